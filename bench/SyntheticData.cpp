@@ -0,0 +1,96 @@
+// SyntheticData.cpp
+// -------------------------------------------------------------
+// Implementation of the synthetic input generator
+// -------------------------------------------------------------
+
+#include "SyntheticData.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Append one value in the requested format
+void append_number(std::string& out, double value, NumberFormat format) {
+    char text[64];
+    int len = 0;
+    switch (format) {
+        case NumberFormat::scientific:
+            len = std::snprintf(text, sizeof(text), "%.16E", value);
+            break;
+        case NumberFormat::fixed:
+            len = std::snprintf(text, sizeof(text), "%.6f", value);
+            break;
+        case NumberFormat::integer:
+            len = std::snprintf(text, sizeof(text), "%.0f", value);
+            break;
+        case NumberFormat::mixed:
+            break;  // Resolved per column by the caller
+    }
+    out.append(text, static_cast<size_t>(len > 0 ? len : 0));
+}
+
+}  // namespace
+
+// Values span several decades so widths and exponents vary like simulation output
+SyntheticPair SyntheticData::generate(const SyntheticSpec& spec) {
+    SyntheticPair pair;
+    std::mt19937_64 rng(spec.seed);
+    std::uniform_real_distribution<double> exponent(-6.0, 6.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    size_t line_bytes = spec.cols * 26 + 1;
+    pair.text1.reserve(spec.rows * line_bytes);
+    pair.text2.reserve(spec.rows * line_bytes);
+
+    for (size_t row = 0; row < spec.rows; ++row) {
+        if (spec.comment_every > 0 && row % spec.comment_every == 0) {
+            pair.text1 += "# block " + std::to_string(row) + "\n";
+            pair.text2 += "# block " + std::to_string(row) + "\n";
+        }
+        for (size_t col = 0; col < spec.cols; ++col) {
+            NumberFormat format = spec.format;
+            if (format == NumberFormat::mixed) format = static_cast<NumberFormat>(col % 3);
+
+            double sign = unit(rng) < 0.5 ? -1.0 : 1.0;
+            double value = sign * std::pow(10.0, exponent(rng));
+            double other = value * (1.0 + spec.noise);
+            if (format == NumberFormat::integer) {
+                value = std::round(value * 1e12);  // At least 1e6, so +1 stays far within tolerance
+                other = value + 1.0;
+            }
+            if (unit(rng) < spec.diff_density) {
+                other = value * 1.5;
+                pair.n_differences++;
+            }
+
+            if (col > 0) {
+                pair.text1 += "   ";
+                pair.text2 += "   ";
+            }
+            append_number(pair.text1, value, format);
+            append_number(pair.text2, other, format);
+        }
+        pair.text1 += '\n';
+        pair.text2 += '\n';
+    }
+    return pair;
+}
+
+void SyntheticData::write_file(const std::string& path, std::string_view contents) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out) throw std::runtime_error("Error: cannot write " + path + ".");
+}
+
+NumberFormat SyntheticData::parse_format(std::string_view name) {
+    if (name == "scientific") return NumberFormat::scientific;
+    if (name == "fixed") return NumberFormat::fixed;
+    if (name == "integer") return NumberFormat::integer;
+    if (name == "mixed") return NumberFormat::mixed;
+    throw std::runtime_error("Error: unknown number format '" + std::string(name) +
+                             "' (expected scientific, fixed, integer or mixed).");
+}
@@ -0,0 +1,65 @@
+// SyntheticData.hpp
+// -------------------------------------------------------------
+// Synthetic input generator for the diff-numerics benchmarks
+//
+// Produces pairs of whitespace-separated numeric files with a chosen
+// shape, number format and density of out-of-tolerance differences.
+// Used by diff-numerics-bench and by the diff-numerics-gen tool that
+// writes large files for manual or farm-side measurements.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/** Textual encoding of generated numbers */
+enum class NumberFormat : std::uint8_t {
+    scientific,  // 1.2345678901234567E-003 (as in the test data)
+    fixed,       // 0.001235
+    integer,     // 1235
+    mixed        // Cycles through the formats above by column
+};
+
+/** Shape and content of a generated file pair */
+struct SyntheticSpec {
+    size_t rows = 100000;                        // Data lines per file
+    size_t cols = 8;                             // Columns per line
+    double diff_density = 0.01;                  // Fraction of values beyond tolerance
+    double noise = 1e-9;                         // Relative within-tolerance change elsewhere
+    NumberFormat format = NumberFormat::scientific;  // Encoding of the values
+    size_t comment_every = 0;                    // Insert a comment line every n rows (0 = never)
+    std::uint64_t seed = 42;                     // Random seed (same seed, same files)
+};
+
+/** A generated pair of file contents */
+struct SyntheticPair {
+    std::string text1, text2;  // Contents of file1 and file2
+    size_t n_differences = 0;  // Values written beyond tolerance
+};
+
+/**
+ * Static generator for synthetic comparison inputs
+ *
+ * This class cannot be instantiated (deleted default constructor).
+ */
+class SyntheticData {
+   public:
+    SyntheticData() = delete;  // No instances allowed
+
+    /**
+     * Generate both files of a pair in memory
+     *
+     * Every value of file2 is file1's value changed by `noise` (integers:
+     * by one unit), so lines are never byte-identical, except a diff_density fraction that is
+     * changed by 50% and therefore reported with the default tolerance.
+     */
+    static SyntheticPair generate(const SyntheticSpec& spec);
+
+    /** Write a string to a file, throws runtime_error on failure */
+    static void write_file(const std::string& path, std::string_view contents);
+
+    /** Parse a format name ("scientific", "fixed", "integer", "mixed"), throws on unknown names */
+    static NumberFormat parse_format(std::string_view name);
+};
@@ -0,0 +1,330 @@
+// bench-diff-numerics.cpp
+// -------------------------------------------------------------
+// Google Benchmark suite for diff-numerics
+//
+// Measures the hot stages of a comparison on synthetic inputs
+// (see SyntheticData.hpp): tokenizing, fixed-width slicing, number
+// parsing (FloatParser against std::strtod and std::from_chars),
+// numeric validation, digit colorization, the line comparison loop
+// over in-memory sources (also per output mode, specialized against
+// generic) and a full run() over files. Throughput is reported as
+// bytes_per_second (input bytes of both files) and lines/s.
+//
+// Run: ./diff-numerics-bench [--benchmark_filter=<regex>]
+// -------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "FixedWidthLayout.hpp"
+#include "FloatParser.hpp"
+#include "Formatter.hpp"
+#include "LineSource.hpp"
+#include "NumericDiff.hpp"
+#include "SyntheticData.hpp"
+#include "TextParser.hpp"
+
+using numdiff::NumericDiff;
+using numdiff::NumericDiffOptions;
+
+namespace {
+
+// Stream that drops everything, so rendering is measured without terminal or disk I/O
+class DiscardBuffer : public std::streambuf {
+   protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Generated pairs are cached per spec: generation is not part of the measurement
+const SyntheticPair& cached_pair(size_t rows, size_t cols, double density,
+                                 NumberFormat format = NumberFormat::scientific) {
+    static std::map<std::tuple<size_t, size_t, double, NumberFormat>, SyntheticPair> cache;
+    auto key = std::make_tuple(rows, cols, density, format);
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        SyntheticSpec spec;
+        spec.rows = rows;
+        spec.cols = cols;
+        spec.diff_density = density;
+        spec.format = format;
+        it = cache.emplace(key, SyntheticData::generate(spec)).first;
+    }
+    return it->second;
+}
+
+// Throughput counters shared by all line-based benchmarks
+void set_throughput(benchmark::State& state, size_t bytes, size_t lines) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(bytes));
+    state.counters["lines/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * static_cast<double>(lines),
+        benchmark::Counter::kIsRate);
+}
+
+// Density argument is given in differences per 10000 values
+double density_arg(const benchmark::State& state, int index) {
+    return static_cast<double>(state.range(index)) / 10000.0;
+}
+
+}  // namespace
+
+// --- Component benchmarks ---
+
+// Tokenize every line of a file; args: columns, number format
+static void BM_Tokenize(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(10000, static_cast<size_t>(state.range(0)), 0.0,
+                                            static_cast<NumberFormat>(state.range(1)));
+    std::vector<std::string_view> tokens;
+    for (auto _ : state) {
+        BufferLineSource source(pair.text1);
+        std::string_view line;
+        while (source.next_line(line)) {
+            TextParser::tokenize(line, tokens);
+            benchmark::DoNotOptimize(tokens.data());
+        }
+    }
+    set_throughput(state, pair.text1.size(), 10000);
+}
+BENCHMARK(BM_Tokenize)
+    ->ArgNames({"cols", "format"})
+    ->Args({4, static_cast<int>(NumberFormat::scientific)})
+    ->Args({40, static_cast<int>(NumberFormat::scientific)})
+    ->Args({40, static_cast<int>(NumberFormat::fixed)})
+    ->Args({40, static_cast<int>(NumberFormat::mixed)});
+
+// Split every line of a fixed-width file (each value in a 25-byte E field); args: columns,
+// split (0 = TextParser::tokenize, 1 = FixedWidthLayout::slice)
+static void BM_SplitFixedWidth(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(10000, static_cast<size_t>(state.range(0)), 0.0);
+    std::string text;
+    std::vector<std::string_view> tokens;
+    BufferLineSource source(pair.text1);
+    std::string_view line;
+    while (source.next_line(line)) {
+        TextParser::tokenize(line, tokens);
+        for (std::string_view token : tokens) {
+            char field[32];
+            int len = std::snprintf(field, sizeof(field), "%25.16E",
+                                    TextParser::try_parse_number(token).value_or(0.0));
+            text.append(field, static_cast<size_t>(len));
+        }
+        text += '\n';
+    }
+    FixedWidthLayout layout(FixedWidthLayout::default_learn_lines);
+    BufferLineSource learning(text);
+    while (layout.learning() && learning.next_line(line)) {
+        TextParser::tokenize(line, tokens);
+        layout.observe(line, tokens);
+    }
+    const ColumnSelection every_column;
+    bool slice = state.range(1) != 0;
+    for (auto _ : state) {
+        BufferLineSource lines(text);
+        while (lines.next_line(line)) {
+            if (!slice || !layout.slice(line, every_column, tokens)) {
+                TextParser::tokenize(line, tokens);
+            }
+            benchmark::DoNotOptimize(tokens.data());
+        }
+    }
+    set_throughput(state, text.size(), 10000);
+}
+BENCHMARK(BM_SplitFixedWidth)->ArgNames({"cols", "slice"})->ArgsProduct({{4, 40}, {0, 1}});
+
+// Validate every token of a file as a number
+static void BM_StringIsNumeric(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(10000, 8, 0.0,
+                                            static_cast<NumberFormat>(state.range(0)));
+    std::vector<std::string_view> tokens, all;
+    BufferLineSource source(pair.text1);
+    std::string_view line;
+    while (source.next_line(line)) {
+        TextParser::tokenize(line, tokens);
+        all.insert(all.end(), tokens.begin(), tokens.end());
+    }
+    for (auto _ : state) {
+        size_t numeric = 0;
+        for (std::string_view token : all) numeric += TextParser::string_is_numeric(token);
+        benchmark::DoNotOptimize(numeric);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(pair.text1.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(all.size()));
+}
+BENCHMARK(BM_StringIsNumeric)
+    ->ArgName("format")
+    ->Arg(static_cast<int>(NumberFormat::scientific))
+    ->Arg(static_cast<int>(NumberFormat::fixed))
+    ->Arg(static_cast<int>(NumberFormat::integer));
+
+// Parse every token of a file as a double; args: number format, parser
+// (0 = std::strtod, 1 = std::from_chars, 2 = FloatParser)
+static void BM_ParseNumber(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(10000, 8, 0.0,
+                                            static_cast<NumberFormat>(state.range(0)));
+    std::vector<std::string_view> tokens, all;
+    BufferLineSource source(pair.text1);
+    std::string_view line;
+    while (source.next_line(line)) {
+        TextParser::tokenize(line, tokens);
+        all.insert(all.end(), tokens.begin(), tokens.end());
+    }
+    int64_t parser = state.range(1);
+    for (auto _ : state) {
+        double sum = 0.0;
+        for (std::string_view token : all) {
+            double value = 0.0;
+            if (parser == 0) {
+                value = std::strtod(token.data(), nullptr);  // Stops at the separator after it
+            } else if (parser == 1) {
+                std::from_chars(token.data(), token.data() + token.size(), value);
+            } else {
+                value = FloatParser::parse(token).value_or(0.0);
+            }
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(pair.text1.size()));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(all.size()));
+}
+BENCHMARK(BM_ParseNumber)
+    ->ArgNames({"format", "parser"})
+    ->ArgsProduct({{static_cast<int>(NumberFormat::scientific),
+                    static_cast<int>(NumberFormat::fixed), static_cast<int>(NumberFormat::integer)},
+                   {0, 1, 2}});
+
+// Colorize differing digits of token pairs that are all beyond tolerance; arg: into a TokenArena
+static void BM_ColorizeDifferentDigits(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(2000, 8, 1.0);
+    std::vector<std::string_view> t1, t2;
+    std::vector<std::pair<std::string, std::string>> tokens;
+    BufferLineSource source1(pair.text1), source2(pair.text2);
+    std::string_view line1, line2;
+    while (source1.next_line(line1) && source2.next_line(line2)) {
+        TextParser::tokenize(line1, t1);
+        TextParser::tokenize(line2, t2);
+        for (size_t i = 0; i < t1.size(); ++i) tokens.emplace_back(t1[i], t2[i]);
+    }
+    std::string s1, s2;
+    TokenArena arena;
+    bool use_arena = state.range(0) != 0;
+    for (auto _ : state) {
+        arena.clear();
+        for (const auto& [a, b] : tokens) {
+            if (use_arena) {
+                Formatter::append_different_digits(arena, a, b);  // As render_line() does
+                continue;
+            }
+            s1 = a;  // colorize_different_digits works in place
+            s2 = b;
+            Formatter::colorize_different_digits(s1, s2);
+            benchmark::DoNotOptimize(s1.data());
+            benchmark::DoNotOptimize(s2.data());
+        }
+        benchmark::DoNotOptimize(arena.text().data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(tokens.size()));
+}
+BENCHMARK(BM_ColorizeDifferentDigits)->ArgName("arena")->Arg(0)->Arg(1);
+
+// --- Comparison benchmarks ---
+
+// compare_lines loop over in-memory inputs; args: rows, columns, density (1/10000), side-by-side
+static void BM_CompareLines(benchmark::State& state) {
+    size_t rows = static_cast<size_t>(state.range(0));
+    const SyntheticPair& pair =
+        cached_pair(rows, static_cast<size_t>(state.range(1)), density_arg(state, 2));
+    NumericDiffOptions opts;
+    opts.side_by_side = state.range(3) != 0;
+    DiscardBuffer discard;
+    std::ostream out(&discard);
+    for (auto _ : state) {
+        BufferLineSource source1(pair.text1), source2(pair.text2);
+        benchmark::DoNotOptimize(NumericDiff(opts, out).run(source1, source2));
+    }
+    set_throughput(state, pair.text1.size() + pair.text2.size(), rows);
+}
+BENCHMARK(BM_CompareLines)
+    ->ArgNames({"rows", "cols", "diffs_per_10k", "side"})
+    ->Args({100000, 8, 0, 0})
+    ->Args({100000, 8, 100, 0})
+    ->Args({100000, 8, 100, 1})
+    ->Args({20000, 40, 100, 0})
+    ->Unit(benchmark::kMillisecond);
+
+// Output modes of BM_LineLoop
+enum class LoopMode { diff, side_by_side, only_equal, columns };
+
+// Line loop of one output mode, specialized or generic; args: mode, specialized
+static void BM_LineLoop(benchmark::State& state) {
+    const SyntheticPair& pair = cached_pair(100000, 8, 0.01);
+    NumericDiffOptions opts;
+    switch (static_cast<LoopMode>(state.range(0))) {
+        case LoopMode::diff: break;
+        case LoopMode::side_by_side: opts.side_by_side = true; break;
+        case LoopMode::only_equal: opts.only_equal = true; break;
+        case LoopMode::columns: opts.columns_to_compare = {1, 3, 5}; break;
+    }
+    opts.specialize = state.range(1) != 0;
+    DiscardBuffer discard;
+    std::ostream out(&discard);
+    for (auto _ : state) {
+        BufferLineSource source1(pair.text1), source2(pair.text2);
+        benchmark::DoNotOptimize(NumericDiff(opts, out).run(source1, source2));
+    }
+    set_throughput(state, pair.text1.size() + pair.text2.size(), 100000);
+}
+BENCHMARK(BM_LineLoop)
+    ->ArgNames({"mode", "specialized"})
+    ->ArgsProduct({{static_cast<int>(LoopMode::diff), static_cast<int>(LoopMode::side_by_side),
+                    static_cast<int>(LoopMode::only_equal), static_cast<int>(LoopMode::columns)},
+                   {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Full run() over files on disk; args: rows, columns, density (1/10000), threads
+static void BM_RunEndToEnd(benchmark::State& state) {
+    size_t rows = static_cast<size_t>(state.range(0));
+    const SyntheticPair& pair =
+        cached_pair(rows, static_cast<size_t>(state.range(1)), density_arg(state, 2));
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    NumericDiffOptions opts;
+    opts.file1 = (dir / "diff-numerics-bench-1.dat").string();
+    opts.file2 = (dir / "diff-numerics-bench-2.dat").string();
+    opts.threads = static_cast<size_t>(state.range(3));
+    SyntheticData::write_file(opts.file1, pair.text1);
+    SyntheticData::write_file(opts.file2, pair.text2);
+
+    DiscardBuffer discard;
+    std::ostream out(&discard);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(NumericDiff(opts, out).run());
+    }
+    set_throughput(state, pair.text1.size() + pair.text2.size(), rows);
+    std::remove(opts.file1.c_str());
+    std::remove(opts.file2.c_str());
+}
+BENCHMARK(BM_RunEndToEnd)
+    ->ArgNames({"rows", "cols", "diffs_per_10k", "threads"})
+    ->Args({200000, 8, 100, 1})
+    ->Args({200000, 8, 100, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
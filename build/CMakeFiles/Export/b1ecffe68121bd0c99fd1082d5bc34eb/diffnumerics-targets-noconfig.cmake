@@ -0,0 +1,19 @@
+#----------------------------------------------------------------
+# Generated CMake target import file.
+#----------------------------------------------------------------
+
+# Commands may need to know the format version.
+set(CMAKE_IMPORT_FILE_VERSION 1)
+
+# Import target "diffnumerics::diffnumerics" for configuration ""
+set_property(TARGET diffnumerics::diffnumerics APPEND PROPERTY IMPORTED_CONFIGURATIONS NOCONFIG)
+set_target_properties(diffnumerics::diffnumerics PROPERTIES
+  IMPORTED_LINK_INTERFACE_LANGUAGES_NOCONFIG "CXX"
+  IMPORTED_LOCATION_NOCONFIG "${_IMPORT_PREFIX}/lib/libdiffnumerics.a"
+  )
+
+list(APPEND _cmake_import_check_targets diffnumerics::diffnumerics )
+list(APPEND _cmake_import_check_files_for_diffnumerics::diffnumerics "${_IMPORT_PREFIX}/lib/libdiffnumerics.a" )
+
+# Commands beyond this point should not need to know the version.
+set(CMAKE_IMPORT_FILE_VERSION)
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/diff-numerics.dir/src/main.cpp.o"
+  "CMakeFiles/diff-numerics.dir/src/main.cpp.o.d"
+  "diff-numerics"
+  "diff-numerics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/diff-numerics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
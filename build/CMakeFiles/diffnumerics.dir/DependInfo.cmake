@@ -0,0 +1,38 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/ArgParser.cpp" "CMakeFiles/diffnumerics.dir/src/ArgParser.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ArgParser.cpp.o.d"
+  "/root/repo/src/ArraySource.cpp" "CMakeFiles/diffnumerics.dir/src/ArraySource.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ArraySource.cpp.o.d"
+  "/root/repo/src/BatchRunner.cpp" "CMakeFiles/diffnumerics.dir/src/BatchRunner.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/BatchRunner.cpp.o.d"
+  "/root/repo/src/ByteReader.cpp" "CMakeFiles/diffnumerics.dir/src/ByteReader.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ByteReader.cpp.o.d"
+  "/root/repo/src/ColumnErrorStats.cpp" "CMakeFiles/diffnumerics.dir/src/ColumnErrorStats.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ColumnErrorStats.cpp.o.d"
+  "/root/repo/src/ColumnSelection.cpp" "CMakeFiles/diffnumerics.dir/src/ColumnSelection.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ColumnSelection.cpp.o.d"
+  "/root/repo/src/FixedWidthLayout.cpp" "CMakeFiles/diffnumerics.dir/src/FixedWidthLayout.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/FixedWidthLayout.cpp.o.d"
+  "/root/repo/src/FloatParser.cpp" "CMakeFiles/diffnumerics.dir/src/FloatParser.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/FloatParser.cpp.o.d"
+  "/root/repo/src/Formatter.cpp" "CMakeFiles/diffnumerics.dir/src/Formatter.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/Formatter.cpp.o.d"
+  "/root/repo/src/KeyIndex.cpp" "CMakeFiles/diffnumerics.dir/src/KeyIndex.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/KeyIndex.cpp.o.d"
+  "/root/repo/src/LineSource.cpp" "CMakeFiles/diffnumerics.dir/src/LineSource.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/LineSource.cpp.o.d"
+  "/root/repo/src/NumericDiff.cpp" "CMakeFiles/diffnumerics.dir/src/NumericDiff.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/NumericDiff.cpp.o.d"
+  "/root/repo/src/OutputBuffer.cpp" "CMakeFiles/diffnumerics.dir/src/OutputBuffer.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/OutputBuffer.cpp.o.d"
+  "/root/repo/src/Printer.cpp" "CMakeFiles/diffnumerics.dir/src/Printer.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/Printer.cpp.o.d"
+  "/root/repo/src/ReferenceCache.cpp" "CMakeFiles/diffnumerics.dir/src/ReferenceCache.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ReferenceCache.cpp.o.d"
+  "/root/repo/src/RunStats.cpp" "CMakeFiles/diffnumerics.dir/src/RunStats.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/RunStats.cpp.o.d"
+  "/root/repo/src/StreamingDiff.cpp" "CMakeFiles/diffnumerics.dir/src/StreamingDiff.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/StreamingDiff.cpp.o.d"
+  "/root/repo/src/TextParser.cpp" "CMakeFiles/diffnumerics.dir/src/TextParser.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/TextParser.cpp.o.d"
+  "/root/repo/src/ThreadPool.cpp" "CMakeFiles/diffnumerics.dir/src/ThreadPool.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ThreadPool.cpp.o.d"
+  "/root/repo/src/ToleranceKernel.cpp" "CMakeFiles/diffnumerics.dir/src/ToleranceKernel.cpp.o" "gcc" "CMakeFiles/diffnumerics.dir/src/ToleranceKernel.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
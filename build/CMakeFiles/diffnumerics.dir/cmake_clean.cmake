@@ -0,0 +1,49 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/diffnumerics.dir/src/ArgParser.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ArgParser.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ArraySource.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ArraySource.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/BatchRunner.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/BatchRunner.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ByteReader.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ByteReader.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ColumnErrorStats.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ColumnErrorStats.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ColumnSelection.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ColumnSelection.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/FixedWidthLayout.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/FixedWidthLayout.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/FloatParser.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/FloatParser.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/Formatter.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/Formatter.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/KeyIndex.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/KeyIndex.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/LineSource.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/LineSource.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/NumericDiff.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/NumericDiff.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/OutputBuffer.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/OutputBuffer.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/Printer.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/Printer.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ReferenceCache.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ReferenceCache.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/RunStats.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/RunStats.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/StreamingDiff.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/StreamingDiff.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/TextParser.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/TextParser.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ThreadPool.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ThreadPool.cpp.o.d"
+  "CMakeFiles/diffnumerics.dir/src/ToleranceKernel.cpp.o"
+  "CMakeFiles/diffnumerics.dir/src/ToleranceKernel.cpp.o.d"
+  "libdiffnumerics.a"
+  "libdiffnumerics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/diffnumerics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "../bin/diff-numerics-bench"
+  "../bin/diff-numerics-bench.pdb"
+  "CMakeFiles/diff-numerics-bench.dir/SyntheticData.cpp.o"
+  "CMakeFiles/diff-numerics-bench.dir/SyntheticData.cpp.o.d"
+  "CMakeFiles/diff-numerics-bench.dir/bench-diff-numerics.cpp.o"
+  "CMakeFiles/diff-numerics-bench.dir/bench-diff-numerics.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/diff-numerics-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "../bin/diff-numerics-gen"
+  "../bin/diff-numerics-gen.pdb"
+  "CMakeFiles/diff-numerics-gen.dir/SyntheticData.cpp.o"
+  "CMakeFiles/diff-numerics-gen.dir/SyntheticData.cpp.o.d"
+  "CMakeFiles/diff-numerics-gen.dir/generate-data.cpp.o"
+  "CMakeFiles/diff-numerics-gen.dir/generate-data.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/diff-numerics-gen.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,14 @@
+# diffnumericsConfig.cmake
+# -------------------------------------------------------------
+# CMake package configuration for libdiffnumerics.
+#
+# Usage:
+#   find_package(diffnumerics REQUIRED)
+#   target_link_libraries(my-solver PRIVATE diffnumerics::diffnumerics)
+# -------------------------------------------------------------
+
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+find_dependency(ZLIB)
+find_dependency(LibLZMA)
+include("${CMAKE_CURRENT_LIST_DIR}/diffnumerics-targets.cmake")
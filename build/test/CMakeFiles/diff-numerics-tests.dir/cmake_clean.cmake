@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/diff-numerics-tests"
+  "../bin/diff-numerics-tests.pdb"
+  "CMakeFiles/diff-numerics-tests.dir/test-diff-numerics.cpp.o"
+  "CMakeFiles/diff-numerics-tests.dir/test-diff-numerics.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/diff-numerics-tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,9 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/test
+# Build directory: /root/repo/build/test
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(diff-numerics-tests "/root/repo/build/bin/diff-numerics-tests")
+set_tests_properties(diff-numerics-tests PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/test/CMakeLists.txt;26;add_test;/root/repo/test/CMakeLists.txt;0;")
+subdirs("../_deps/googletest-build")
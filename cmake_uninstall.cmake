@@ -3,8 +3,12 @@
 if(NOT DEFINED CMAKE_INSTALL_PREFIX)
     set(CMAKE_INSTALL_PREFIX "/usr/local")
 endif()
-message(STATUS "Uninstalling diff-numerics and man page from ${CMAKE_INSTALL_PREFIX}")
+message(STATUS "Uninstalling diff-numerics, libdiffnumerics and man page from ${CMAKE_INSTALL_PREFIX}")
 file(REMOVE "${CMAKE_INSTALL_PREFIX}/bin/diff-numerics")
 file(REMOVE "${CMAKE_INSTALL_PREFIX}/share/man/man1/diff-numerics.1")
+file(GLOB DIFF_NUMERICS_LIBRARIES "${CMAKE_INSTALL_PREFIX}/lib/libdiffnumerics.*")
+file(REMOVE ${DIFF_NUMERICS_LIBRARIES})
+file(REMOVE_RECURSE "${CMAKE_INSTALL_PREFIX}/include/diff-numerics")
+file(REMOVE_RECURSE "${CMAKE_INSTALL_PREFIX}/lib/cmake/diffnumerics")
 execute_process(COMMAND mandb)
 message(STATUS "Uninstall complete.")
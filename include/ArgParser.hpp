@@ -26,6 +26,9 @@ class ArgParser {
     /** Parse command-line arguments and return validated options */
     static numdiff::NumericDiffOptions parse(int argc, char* argv[]);
 
+    /** Parse an argument list without the program name (e.g. a --batch manifest entry) */
+    static numdiff::NumericDiffOptions parse(const std::vector<std::string>& args);
+
    private:
     /** Internal parsing logic that processes argv and builds options struct */
     static numdiff::NumericDiffOptions parse_args(int argc, char* argv[]);
@@ -35,6 +38,12 @@ class ArgParser {
     
     /** Parse comma-separated column list (e.g., "1,3,5") into a set */
     static void parse_columns(const std::string& col_arg, std::set<size_t>& columns_to_compare);
+
+    /** Parse an input format name used by --format */
+    static InputFormat parse_format(const std::string& name);
+
+    /** Parse a raw array shape "<cols>" or "<rows>,<cols>" used by --shape */
+    static std::vector<size_t> parse_shape(const std::string& shape_arg);
     
     /** Full usage/help text string */
     static const std::string usage;
@@ -46,4 +55,11 @@ class ArgParser {
     static constexpr double max_tol = 1e+3;         // Maximum tolerance (very loose)
     static constexpr double min_threshold = 0.0;    // Minimum threshold (zero)
     static constexpr double max_threshold = 1e+3;   // Maximum threshold
+    static constexpr long max_threads = 1024;       // Maximum worker threads
+    static constexpr long max_resync_window = 4096; // Maximum --resync lookahead (lines)
+    static constexpr size_t default_resync_window = 32;  // --resync without a window
+    static constexpr long max_prefetch_mib = 4096;  // Maximum --prefetch window per input
+    static constexpr long max_fixed_width_lines = 1 << 20;  // Maximum --fixed-width learning lines
+    static constexpr long max_top = 1 << 20;        // Maximum --top report size
+    static constexpr long max_sample = 100000000;   // Maximum --sample size (line pairs)
 };
\ No newline at end of file
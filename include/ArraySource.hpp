@@ -0,0 +1,109 @@
+// ArraySource.hpp
+// -------------------------------------------------------------
+// Binary numeric array inputs for diff-numerics
+//
+// Provides ArraySource, a two-dimensional view (rows x columns) of a
+// binary file that NumericDiff compares directly, without any text
+// parsing. Supported encodings:
+// - NumPy .npy files (float64/float32, either byte order, C or Fortran order)
+// - Raw float64/float32 little-endian arrays with a declared shape
+// - HDF5 datasets (when built with HDF5 support)
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Encoding of an input file
+ * automatic detects .npy and HDF5 files by their magic bytes and
+ * treats everything else as text.
+ */
+enum class InputFormat : std::uint8_t {
+    automatic,  // Detect by magic bytes (default)
+    text,       // Whitespace-separated text columns
+    npy,        // NumPy .npy array
+    raw_f64,    // Raw little-endian float64, shape given by the user
+    raw_f32,    // Raw little-endian float32, shape given by the user
+    hdf5        // HDF5 dataset
+};
+
+/**
+ * Read-only two-dimensional array of floating-point values
+ *
+ * Raw and .npy files are memory-mapped and converted element by element
+ * on access (widening float32, swapping bytes if needed). native_row()
+ * exposes the mapping itself when it already holds native float64 rows.
+ * Arrays with more than two dimensions are viewed as shape[0] rows of
+ * all remaining values; one-dimensional arrays as a single column.
+ */
+class ArraySource {
+   public:
+    ~ArraySource();
+
+    ArraySource(const ArraySource&) = delete;
+    ArraySource& operator=(const ArraySource&) = delete;
+
+    /**
+     * Open a binary array file
+     *
+     * format must not be automatic or text. shape is required for raw
+     * formats ({cols} or {rows, cols}) and dataset for HDF5. Throws
+     * runtime_error for unreadable, malformed or unsupported files.
+     */
+    static std::unique_ptr<ArraySource> open(const std::string& path, InputFormat format,
+                                             const std::vector<size_t>& shape,
+                                             const std::string& dataset);
+
+    /** Identify a file by its magic bytes: npy, hdf5, or text for anything else */
+    static InputFormat detect(const std::string& path);
+
+    /** Human-readable name of a format (for error messages) */
+    static const char* format_name(InputFormat format) noexcept;
+
+    size_t rows() const noexcept { return rows_; }
+    size_t cols() const noexcept { return cols_; }
+
+    /** Row as native float64 values in place, or nullptr if the storage needs conversion */
+    const double* native_row(size_t row) const noexcept;
+
+    /**
+     * Convert rows [first_row, first_row + n_rows) into out, row-major
+     * Only the given (0-based) columns are copied, in that order, so out
+     * receives n_rows * columns.size() values.
+     */
+    void read_rows(size_t first_row, size_t n_rows, const std::vector<size_t>& columns,
+                   double* out) const;
+
+   private:
+    enum class DType : std::uint8_t { float64, float32 };
+
+    ArraySource() = default;
+
+    /** Parse the .npy header of a mapped file and locate its data */
+    void parse_npy(const std::string& path);
+
+    /** Check the declared shape of a raw file against its size */
+    void apply_raw_shape(const std::string& path, const std::vector<size_t>& shape);
+
+    /** Read a whole HDF5 dataset into storage_ */
+    void load_hdf5(const std::string& path, const std::string& dataset);
+
+    /** Map path read-only into mapping_ (left empty for empty files) */
+    void map_file(const std::string& path);
+
+    /** Value at (row, col) converted to double */
+    double value(size_t row, size_t col) const noexcept;
+
+    void* mapping_ = nullptr;         // Base address returned by mmap (null if not mapped)
+    size_t mapping_length_ = 0;       // Length of the mapping in bytes
+    std::vector<double> storage_;     // Owned values (HDF5 datasets)
+    const unsigned char* data_ = nullptr;  // First element
+    DType dtype_ = DType::float64;    // Element type in the file
+    bool swap_bytes_ = false;         // File byte order differs from the host
+    bool fortran_order_ = false;      // Column-major storage
+    size_t rows_ = 0, cols_ = 0;      // Logical shape
+};
@@ -0,0 +1,91 @@
+// BatchRunner.hpp
+// -------------------------------------------------------------
+// Batch comparison of many file pairs in one process
+//
+// Reads a manifest of file pairs (each with optional per-pair options)
+// or pairs the files of two directory trees by relative path, compares
+// all pairs on one shared worker pool, largest inputs first, and
+// reports per-pair output in order followed by an aggregated summary
+// table.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "NumericDiff.hpp"
+
+/** Outcome of one pair of a batch */
+struct BatchOutcome {
+    numdiff::NumericDiffResult result;  // Comparison result (valid unless failed)
+    std::string output;                 // Rendered diff output of the pair
+    std::string error;                  // Error message if the comparison failed
+    bool failed = false;                // The comparison threw
+};
+
+/** File pairs found under two directories */
+struct DirectoryPairing {
+    std::vector<numdiff::NumericDiffOptions> pairs;  // Files present in both trees, by path
+    std::vector<std::string> only_in1;                // Relative paths found in the first tree only
+    std::vector<std::string> only_in2;                // Relative paths found in the second tree only
+};
+
+/**
+ * Runs a list of comparisons on a shared thread pool
+ *
+ * Pairs are scheduled by decreasing input size. Each pair runs on one
+ * worker, except pairs larger than a worker's fair share of the total,
+ * which are split into chunk tasks on the same pool (idle workers steal
+ * them), so one giant file does not serialize the tail of the batch.
+ * A failing pair is reported and does not stop the batch.
+ */
+class BatchRunner {
+   public:
+    /** Run on n_threads workers (at least one) */
+    explicit BatchRunner(size_t n_threads) : n_threads_(n_threads) {}
+
+    /**
+     * Parse a manifest into per-pair options
+     *
+     * Each non-blank, non-# line holds "file1 file2 [options]" in the
+     * command-line syntax; global_args are applied first, so per-pair
+     * options override them. Throws runtime_error naming the manifest
+     * line on invalid entries.
+     */
+    static std::vector<numdiff::NumericDiffOptions> read_manifest(
+        const std::string& path, const std::vector<std::string>& global_args);
+
+    /**
+     * Pair the regular files under two directories by relative path
+     * options.file1 and options.file2 are the directories; every pair
+     * gets the other options. Pairs and unpaired paths are sorted.
+     */
+    static DirectoryPairing pair_directories(const numdiff::NumericDiffOptions& options);
+
+    /**
+     * Compare all pairs; outcomes are in the order of pairs
+     * When os is given, each pair's output is written to it in order as
+     * soon as it and all pairs before it have finished.
+     */
+    std::vector<BatchOutcome> run(const std::vector<numdiff::NumericDiffOptions>& pairs,
+                                  std::ostream* os = nullptr) const;
+
+    /** Print the aggregated table: one row per pair, then totals */
+    static void print_summary(std::ostream& os,
+                              const std::vector<numdiff::NumericDiffOptions>& pairs,
+                              const std::vector<BatchOutcome>& outcomes);
+
+    /** Report the files of a directory comparison that exist in one tree only */
+    static void print_unpaired(std::ostream& os, const numdiff::NumericDiffOptions& dirs,
+                               const DirectoryPairing& pairing);
+
+    static constexpr std::uint64_t split_min_bytes = 16 << 20;  // Smaller pairs are never split
+
+   private:
+    /** Combined size of a pair's inputs in bytes (0 if unknown), used for scheduling */
+    static std::uint64_t input_size(const numdiff::NumericDiffOptions& pair);
+
+    size_t n_threads_;  // Pool size
+};
@@ -0,0 +1,141 @@
+// ByteReader.hpp
+// -------------------------------------------------------------
+// Byte-stream readers feeding StreamLineSource
+//
+// Provides a minimal pull interface for raw bytes and the readers
+// stacked behind streamed inputs:
+// - FdReader: read(2) loop over a file descriptor
+// - ReplayReader: puts bytes peeked from a stream back in front of it
+// - GzipReader / XzReader / ZstdReader: streaming decompression
+//   (zlib, liblzma, libzstd; each optional at build time)
+// - PrefetchReader: runs another reader on a background thread and
+//   hands over filled blocks, so I/O and decompression of one input
+//   overlap with parsing
+// -------------------------------------------------------------
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/** Compression format of an input, identified by its magic bytes */
+enum class Compression : std::uint8_t { none, gzip, xz, zstd };
+
+/**
+ * Abstract pull-based source of bytes
+ *
+ * read() fills up to capacity bytes and returns how many were written;
+ * 0 means end of input. Errors are reported with runtime_error.
+ */
+class ByteReader {
+   public:
+    virtual ~ByteReader() = default;
+
+    /** Read up to capacity bytes into dst, returns 0 at end of input */
+    virtual size_t read(char* dst, size_t capacity) = 0;
+
+    /** Number of leading bytes detect_compression() needs */
+    static constexpr size_t magic_size = 6;
+
+    /** Identify a compression format from the first bytes of an input */
+    static Compression detect_compression(std::string_view head) noexcept;
+
+    /** Name of a compression format (for messages) */
+    static const char* compression_name(Compression compression) noexcept;
+
+    /**
+     * Wrap a reader of compressed bytes into a decompressing reader
+     * Throws runtime_error if support for the format was not compiled in.
+     */
+    static std::unique_ptr<ByteReader> decompress(Compression compression,
+                                                  std::unique_ptr<ByteReader> compressed,
+                                                  const std::string& name);
+};
+
+/** Reader over a file descriptor */
+class FdReader : public ByteReader {
+   public:
+    /** Wrap a descriptor; it is closed on destruction if owns_fd is true */
+    FdReader(int fd, std::string name, bool owns_fd = true);
+    ~FdReader() override;
+
+    FdReader(const FdReader&) = delete;
+    FdReader& operator=(const FdReader&) = delete;
+
+    size_t read(char* dst, size_t capacity) override;
+
+   private:
+    int fd_;            // Descriptor being read
+    std::string name_;  // Path used in error messages
+    bool owns_fd_;      // Close fd_ on destruction
+};
+
+/**
+ * Serves bytes already taken from a reader, then the rest of it
+ * Lets the magic bytes of a pipe be inspected before choosing the
+ * readers stacked on it.
+ */
+class ReplayReader : public ByteReader {
+   public:
+    ReplayReader(std::string head, std::unique_ptr<ByteReader> inner)
+        : head_(std::move(head)), inner_(std::move(inner)) {}
+
+    size_t read(char* dst, size_t capacity) override;
+
+   private:
+    std::string head_;                   // Bytes read ahead of inner_
+    size_t offset_ = 0;                  // Bytes of head_ already served
+    std::unique_ptr<ByteReader> inner_;  // Remainder of the input
+};
+
+/**
+ * Runs another reader ahead of the consumer on a background thread
+ *
+ * The worker fills a ring of depth blocks of block_size bytes; read()
+ * copies out of the oldest filled block and recycles it once drained.
+ * Exceptions thrown by the wrapped reader are rethrown by read() after
+ * the data that preceded them has been consumed.
+ */
+class PrefetchReader : public ByteReader {
+   public:
+    PrefetchReader(std::unique_ptr<ByteReader> inner, size_t block_size = default_block_size,
+                   size_t depth = default_depth);
+    ~PrefetchReader() override;
+
+    PrefetchReader(const PrefetchReader&) = delete;
+    PrefetchReader& operator=(const PrefetchReader&) = delete;
+
+    size_t read(char* dst, size_t capacity) override;
+
+    static constexpr size_t default_block_size = 1 << 20;  // Bytes per block (1 MiB)
+    static constexpr size_t default_depth = 4;             // Blocks in flight
+
+   private:
+    /** Worker loop: fill free blocks until end of input, error or shutdown */
+    void produce();
+
+    struct Block {
+        std::vector<char> data;  // Block storage (block_size bytes)
+        size_t size = 0;         // Valid bytes
+    };
+
+    std::unique_ptr<ByteReader> inner_;  // Reader run on the worker thread
+    std::vector<Block> ring_;            // Block ring
+    size_t head_ = 0;                    // Oldest filled block (consumer side)
+    size_t filled_ = 0;                  // Filled blocks not yet drained
+    size_t offset_ = 0;                  // Bytes of ring_[head_] already consumed
+    bool eof_ = false;                   // Worker reached end of input
+    bool stopping_ = false;              // Destructor requested shutdown
+    std::exception_ptr error_;           // Exception raised by the worker
+    std::mutex mutex_;                   // Guards the fields above
+    std::condition_variable ready_;      // Signals a filled block, EOF or error
+    std::condition_variable free_;       // Signals a drained block or shutdown
+    std::thread worker_;                 // Runs produce()
+};
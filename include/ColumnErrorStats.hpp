@@ -0,0 +1,79 @@
+// ColumnErrorStats.hpp
+// -------------------------------------------------------------
+// Per-column error statistics for diff-numerics (--column-stats)
+//
+// Accumulates, in one pass over the compared values, the maximum,
+// mean and RMS of the absolute and relative error of every column and
+// a histogram of the relative error by decade. Accumulators of
+// parallel chunks merge into the statistics of the whole run.
+// -------------------------------------------------------------
+
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace numdiff {
+
+/**
+ * Running error statistics of one column
+ *
+ * The absolute error of a pair is |v1 - v2|, the relative error
+ * |v1 - v2| / max(|v1|, |v2|) * 100 in percent, as the diff reports it
+ * (0 when both are 0), regardless of tolerance and threshold. Means are
+ * kept as running means rather than sums, so they do not lose the small
+ * errors of a long run next to a large total; merging weights them by
+ * pair count. Squared absolute errors are kept relative to max_abs, so
+ * their mean cannot overflow for errors beyond 1e154. Pairs with a NaN
+ * or infinite value are only counted.
+ */
+struct ColumnErrorStats {
+    /**
+     * Histogram bins of the relative error (%): [0, 1e-14), then one per
+     * decade from [1e-14, 1e-13) to [10, 100), then [100, 200] (values of
+     * opposite signs)
+     */
+    static constexpr size_t n_bins = 18;
+
+    std::uint64_t pairs = 0;         // Value pairs with finite errors
+    std::uint64_t different = 0;     // Out of tolerance, as reported by the diff (nonfinite too)
+    std::uint64_t nonfinite = 0;     // Pairs with a NaN or infinite value (not in the errors)
+    double max_abs = 0.0;            // Largest absolute error
+    double mean_abs = 0.0;           // Mean absolute error
+    double scaled_square_abs = 0.0;  // Mean of (absolute error / max_abs)^2
+    double max_rel = 0.0;            // Largest relative error (%)
+    double mean_rel = 0.0;           // Mean relative error (%)
+    double mean_square_rel = 0.0;    // Mean squared relative error (%^2)
+    std::array<std::uint64_t, n_bins> histogram{};  // Pairs per relative error bin
+
+    /** Add one compared pair */
+    void add(double value1, double value2, bool is_different) noexcept;
+
+    /** Add the pairs of another accumulator of the same column */
+    void merge(const ColumnErrorStats& other) noexcept;
+
+    /** Root mean square of the absolute error */
+    double rms_abs() const noexcept { return max_abs * std::sqrt(scaled_square_abs); }
+
+    /** Root mean square of the relative error */
+    double rms_rel() const noexcept { return std::sqrt(mean_square_rel); }
+
+    /** Lower edge of histogram bin k (0 for the first bin) */
+    static double bin_lower_edge(size_t k) noexcept;
+
+    /** Histogram bin of a relative error */
+    static size_t bin(double rel) noexcept;
+};
+
+/**
+ * Error statistics of all columns, indexed by column (0-based)
+ * Columns never compared as numbers keep pairs == 0 and nonfinite == 0.
+ */
+using ColumnErrorTable = std::vector<ColumnErrorStats>;
+
+/** Add the columns of other to table, column by column */
+void merge_columns(ColumnErrorTable& table, const ColumnErrorTable& other);
+
+}  // namespace numdiff
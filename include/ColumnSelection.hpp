@@ -0,0 +1,57 @@
+// ColumnSelection.hpp
+// -------------------------------------------------------------
+// Compiled --columns specification for diff-numerics
+//
+// Turns the 1-based column set given on the command line into a dense
+// bitmap over 0-based token indices, so the per-token "is this column
+// compared?" test is a single array load instead of a tree lookup.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+/**
+ * Set of compared columns, indexed by 0-based token position
+ *
+ * A default-constructed selection (or one built from an empty set)
+ * selects every column.
+ */
+class ColumnSelection {
+   public:
+    /** Select all columns */
+    ColumnSelection() = default;
+
+    /** Compile a set of 1-based column numbers (empty = all columns) */
+    explicit ColumnSelection(const std::set<size_t>& columns);
+
+    /** Whether every column is selected */
+    bool all() const noexcept { return all_; }
+
+    /** Whether the token at 0-based index is compared */
+    bool contains(size_t index) const noexcept {
+        if (all_) return true;
+        if (index < bitmap_.size()) return bitmap_[index] != 0;
+        return contains_sparse(index);
+    }
+
+    /** One past the highest selected index (no limit when all() is true) */
+    size_t end() const noexcept {
+        return all_ ? static_cast<size_t>(-1) : (indices_.empty() ? 0 : indices_.back() + 1);
+    }
+
+    /** Selected 0-based indices in increasing order (empty when all() is true) */
+    const std::vector<size_t>& indices() const noexcept { return indices_; }
+
+    static constexpr size_t max_bitmap_columns = 1 << 16;  // Larger columns use indices_
+
+   private:
+    /** Lookup of indices beyond the bitmap (absurdly wide selections only) */
+    bool contains_sparse(size_t index) const noexcept;
+
+    bool all_ = true;                   // No --columns given
+    std::vector<std::uint8_t> bitmap_;  // 1 for selected indices below max_bitmap_columns
+    std::vector<size_t> indices_;       // Selected 0-based indices
+};
@@ -0,0 +1,81 @@
+// FixedWidthLayout.hpp
+// -------------------------------------------------------------
+// Fixed-width record layout for diff-numerics (--fixed-width)
+//
+// Many numeric dumps are fixed-width records (Fortran formatted
+// output, printf with field widths) where every column sits at the
+// same byte offsets on every line. The layout is learned from the
+// first data lines of a file; later lines are then cut into fields by
+// offset instead of being scanned for whitespace.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "ColumnSelection.hpp"
+
+/**
+ * Byte ranges of the columns of a fixed-width file
+ *
+ * Learning: observe() is given the first data lines with their tokens
+ * (views into the line, as TextParser::tokenize produces them). Field k
+ * ends where token k ended at the latest over those lines, and starts
+ * right after the blank that follows field k - 1 (at the line start for
+ * the first field), since right-aligned numbers grow to the left. The
+ * layout is kept if every line had the same number of tokens and the
+ * token extents of neighboring columns stayed at least one blank apart;
+ * any other line gives it up for good. Blank lines are ignored.
+ *
+ * Slicing: a line fits the layout when every field holds one run of
+ * non-blank bytes and all bytes outside the fields are blank. The token
+ * of a field is its bytes with the padding trimmed, so a line that fits
+ * gives the same tokens as tokenizing it. Lines that do not fit (two
+ * numbers in one field among them) are left to the tokenizer.
+ */
+class FixedWidthLayout {
+   public:
+    static constexpr size_t default_learn_lines = 16;  // Lines observed by --fixed-width
+
+    /** Layout learned from the first learn_lines non-blank lines (0: never used) */
+    explicit FixedWidthLayout(size_t learn_lines = 0) noexcept
+        : state_(learn_lines > 0 ? State::learning : State::off), learn_lines_(learn_lines) {}
+
+    /** Whether lines are still being observed */
+    bool learning() const noexcept { return state_ == State::learning; }
+
+    /** Whether the layout was learned and lines can be sliced */
+    bool ready() const noexcept { return state_ == State::ready; }
+
+    /** Learn from a tokenized line (no-op unless learning()) */
+    void observe(std::string_view line, const std::vector<std::string_view>& tokens);
+
+    /**
+     * Cut a line into its fields, keeping those in selection
+     * Returns false, leaving tokens unspecified, if the layout is not
+     * ready or the line does not fit it.
+     */
+    bool slice(std::string_view line, const ColumnSelection& selection,
+               std::vector<std::string_view>& tokens) const;
+
+    /** Number of fields (0 unless ready()) */
+    size_t size() const noexcept { return state_ == State::ready ? fields_.size() : 0; }
+
+    /** Width in bytes of field k, padding included */
+    size_t width(size_t k) const noexcept { return fields_[k].end - fields_[k].begin; }
+
+   private:
+    enum class State { off, learning, ready };
+
+    /** Byte range [begin, end) of a column */
+    struct Field {
+        size_t begin;
+        size_t end;
+    };
+
+    State state_;
+    size_t learn_lines_;      // Lines to observe before slicing
+    size_t n_observed_ = 0;   // Lines observed so far
+    std::vector<Field> fields_;  // Column ranges, in increasing order
+};
@@ -0,0 +1,55 @@
+// FloatParser.hpp
+// -------------------------------------------------------------
+// Fast decimal-to-double parser for diff-numerics
+//
+// Parses the number formats of numeric dumps, including Fortran
+// output, in one pass over the token:
+// - Decimal and E-notation ("5.0000000000000001E-003", "-42", ".5")
+// - Fortran D exponents ("1.25D-03", "1.25d+2")
+// - Fortran E fields whose 3-digit exponent displaced the letter
+//   ("0.1234567-100", written by Ew.d for |exponent| > 99)
+// Results are correctly rounded (round to nearest, ties to even), and
+// identical to std::from_chars for every token that it accepts.
+// -------------------------------------------------------------
+
+#pragma once
+#include <optional>
+#include <string_view>
+
+/**
+ * Static utility class converting number tokens to doubles
+ *
+ * Up to 19 significant digits are gathered into a 64-bit integer w with
+ * a decimal exponent q, and w * 10^q is rounded:
+ * 1. exactly with one IEEE multiplication or division when w < 2^53 and
+ *    |q| <= 22 (both operands are then exact doubles);
+ * 2. otherwise through a 128-bit approximation of 5^q (Eisel-Lemire):
+ *    the product brackets the true value, and when both ends of the
+ *    bracket round to the same double that double is the result.
+ * Tokens outside these paths (more digits, extreme exponents, results
+ * near the subnormal or overflow range, inf/nan, an ambiguous bracket)
+ * go to std::from_chars, D exponents rewritten as E.
+ *
+ * This class cannot be instantiated (deleted default constructor).
+ * All methods are thread-safe.
+ */
+class FloatParser {
+   public:
+    FloatParser() = delete;  // No instances allowed
+
+    /**
+     * Parse a whole token as a number
+     * Returns std::nullopt if the token is not a number in one of the formats
+     * above, or if its value is out of double range (as std::from_chars).
+     */
+    static std::optional<double> parse(std::string_view token) noexcept;
+
+    /** Smallest and largest decimal exponent q handled by the 5^q table */
+    static constexpr int min_power = -128;
+    static constexpr int max_power = 127;
+
+   private:
+    /** std::from_chars on the token, with a D or missing exponent letter turned into E */
+    static std::optional<double> parse_fallback(std::string_view token,
+                                                size_t exponent_pos) noexcept;
+};
@@ -7,12 +7,54 @@
 // - String width calculation for aligned output
 // - Selective digit colorization for highlighting differences
 // - Visible character extraction while preserving formatting
+//
+// The append_* variants render into caller-owned buffers (e.g. a
+// TokenArena reused across lines), so that printing a differing line
+// does not allocate once the buffers have grown.
 // -------------------------------------------------------------
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
+/**
+ * Scratch buffer for the rendered tokens of one line
+ * 
+ * Tokens are rendered back to back into a single string, whose capacity
+ * is kept across lines: close() ends the current token, token(k) views
+ * the k-th one. Views are only stable once the line is complete, since
+ * appending may move the storage. One arena per NumericDiff instance,
+ * hence per worker in the parallel engine.
+ */
+class TokenArena {
+   public:
+    /** Drop the tokens of the previous line, keeping the capacity */
+    void clear() noexcept {
+        text_.clear();
+        ends_.clear();
+    }
+
+    /** Buffer to append the current token to */
+    std::string& text() noexcept { return text_; }
+
+    /** End the current token */
+    void close() { ends_.push_back(text_.size()); }
+
+    /** The k-th closed token */
+    std::string_view token(size_t k) const noexcept {
+        size_t begin = k == 0 ? 0 : ends_[k - 1];
+        return std::string_view(text_).substr(begin, ends_[k] - begin);
+    }
+
+    /** Number of closed tokens */
+    size_t size() const noexcept { return ends_.size(); }
+
+   private:
+    std::string text_;          // Tokens back to back
+    std::vector<size_t> ends_;  // End of each closed token in text_
+};
+
 /**
  * Static utility class for string formatting and ANSI color code handling
  * 
@@ -28,8 +70,13 @@ class Formatter {
      * Calculate column widths for aligned output
      * Returns the maximum width for each column across both token vectors
      */
-    static std::vector<size_t> calculate_col_widths(const std::vector<std::string>& t1,
-                                                    const std::vector<std::string>& t2);
+    static std::vector<size_t> calculate_col_widths(const std::vector<std::string_view>& t1,
+                                                    const std::vector<std::string_view>& t2);
+
+    /** calculate_col_widths() into a reused vector */
+    static void calculate_col_widths(const std::vector<std::string_view>& t1,
+                                     const std::vector<std::string_view>& t2,
+                                     std::vector<size_t>& widths);
 
     /**
      * Remove all ANSI escape codes from a string
@@ -37,6 +84,9 @@ class Formatter {
      */
     static std::string strip_ansi(const std::string& input);
 
+    /** Append input without its ANSI escape codes to out (see strip_ansi) */
+    static void append_stripped(std::string& out, std::string_view input);
+
     /**
      * Ensure string ends with ANSI reset code if it contains unclosed color codes
      * Prevents color bleeding into subsequent output
@@ -49,20 +99,40 @@ class Formatter {
      */
     static std::string extract_visible_prefix(const std::string& input, size_t n);
 
+    /**
+     * Append the first n visible characters of input to out (see extract_visible_prefix)
+     * Allocation-free variant used by the printer to truncate lines in its output buffer
+     */
+    static void append_visible_prefix(std::string& out, std::string_view input, size_t n);
+
+    /**
+     * Number of visible characters of a string (its length without ANSI codes)
+     * Equivalent to strip_ansi(input).size() without building the stripped copy
+     */
+    static size_t visible_width(std::string_view input) noexcept;
+
     /**
      * Wrap a string in ANSI red color codes
      * Makes the entire string appear in red in terminal output
      */
-    static inline void make_red(std::string& str) noexcept {
-        str = std::string(RED) + str + std::string(RESET);
+    static inline void make_red(std::string& str) {
+        str.insert(0, RED.data(), RED.size());
+        str.append(RESET.data(), RESET.size());
+    }
+
+    /** Append token wrapped in red color codes to out (see make_red) */
+    static inline void append_red(std::string& out, std::string_view token) {
+        out.append(RED.data(), RED.size());
+        out.append(token.data(), token.size());
+        out.append(RESET.data(), RESET.size());
     }
 
     /**
      * Check if a string contains red ANSI color codes
      * Used to determine if differences are present in formatted output
      */
-    static inline bool string_is_red(const std::string& str) noexcept {
-        return str.find(std::string(RED)) != std::string::npos;
+    static inline bool string_is_red(std::string_view str) noexcept {
+        return str.find(RED) != std::string_view::npos;
     }
 
     /**
@@ -72,6 +142,10 @@ class Formatter {
      */
     static void colorize_different_digits(std::string& s1, std::string& s2);
 
+    /** Append s1 and s2 to arena as two tokens, colorized as by colorize_different_digits */
+    static void append_different_digits(TokenArena& arena, std::string_view s1,
+                                        std::string_view s2);
+
    private:
     // ANSI escape codes for terminal coloring
     static constexpr std::string_view RED = "\033[31m";    // Start red text
@@ -0,0 +1,117 @@
+// KeyIndex.hpp
+// -------------------------------------------------------------
+// Hash index over key columns for diff-numerics (--join)
+//
+// Indexes the rows of one file by the values of a few key columns so
+// that the rows of the other file, in any order, find their peer in
+// expected constant time. Numeric keys may match within an absolute
+// tolerance; the index also routes rows to the partitions of the
+// external (spilling) join.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "ColumnSelection.hpp"
+
+/**
+ * Multimap from the key of a row to its row ids, with tolerant lookup
+ *
+ * Rows are added in id order (0, 1, ...), then build() creates the hash
+ * table and take() hands out each row at most once, the lowest id first
+ * among rows with a matching key. Text keys are views into the added
+ * lines, which must outlive the index.
+ *
+ * Keys match when every key column matches: numbers within tolerance
+ * (exactly equal when it is 0), other tokens byte for byte. Numbers are
+ * hashed by cells of width 2 * tolerance, so a lookup probes at most
+ * two cells per numeric key column.
+ */
+class KeyIndex {
+   public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    /** Where a row goes in a partitioned join */
+    struct Route {
+        size_t home;      // Partition holding the row
+        size_t neighbor;  // Second partition for keys at a partition edge (== home if none)
+    };
+
+    /** Index on the given 1-based columns, numeric keys within tolerance */
+    KeyIndex(const std::set<size_t>& columns, double tolerance);
+
+    /**
+     * Add the next row (id size()); returns false if the line lacks a key column
+     * Rows without a key are kept as ids but can never be taken.
+     */
+    bool add(std::string_view line);
+
+    /** Create the hash table over the added rows */
+    void build();
+
+    /** Take the first untaken row whose key matches line's, or npos */
+    std::uint32_t take(std::string_view line);
+
+    /** Mark a row as taken (e.g. by another partition) */
+    void set_taken(std::uint32_t id) { taken_[id] = 1; }
+
+    /** Whether row id was taken */
+    bool taken(std::uint32_t id) const { return taken_[id] != 0; }
+
+    /** Rows added */
+    size_t size() const noexcept { return taken_.size(); }
+
+    /** Heap bytes held by the index */
+    size_t memory_bytes() const noexcept;
+
+    /** Partition of a line among n_partitions (by its first key column) */
+    Route route(std::string_view line, size_t n_partitions);
+
+   private:
+    /** Tokenize the key columns of line into key_tokens_ (false if one is missing) */
+    bool split(std::string_view line);
+
+    /** Hash of the current key; bit i of probe picks the other cell of probe_columns_[i] */
+    std::uint64_t hash_key(std::uint32_t probe) const;
+
+    /** Whether row id has the key in key_tokens_ */
+    bool matches(std::uint32_t id) const;
+
+    /** Cell of a numeric key value */
+    double cell(double value) const noexcept;
+
+    /** Slot of hash in the table (its own, or the empty slot where it belongs) */
+    size_t find_slot(std::uint64_t hash) const noexcept;
+
+    static constexpr double cells_per_group = 1024;  // Numeric cells per partition group
+    static constexpr size_t max_probe_columns = 8;   // Tolerant columns probed both ways
+
+    ColumnSelection selection_;     // Key columns for tokenize_selected
+    size_t n_columns_;              // Number of key columns
+    size_t min_tokens_;             // Tokens a line needs to hold every key column
+    double tolerance_;              // Absolute tolerance of numeric keys
+
+    // Key of the current line (add, take, route)
+    std::vector<std::string_view> key_tokens_;  // Key tokens, in column order
+    std::vector<double> key_values_;            // Their values (numeric tokens)
+    std::vector<std::uint8_t> key_numeric_;     // Whether each key token is a number
+    std::vector<double> key_cells_, key_other_cells_;  // Hash cell, and the nearest other one
+    std::vector<size_t> probe_columns_;         // Numeric key columns probed in two cells
+
+    // Rows
+    std::vector<std::uint64_t> hashes_;    // Key hash of each row
+    std::vector<std::uint8_t> keyed_;      // Whether the row has every key column
+    std::vector<double> values_;           // Key values, n_columns_ per row
+    std::vector<std::string_view> texts_;  // Key tokens, n_columns_ per row
+    std::vector<std::uint8_t> numeric_;    // Whether each key token is a number
+    std::vector<std::uint8_t> taken_;      // Row handed out by take() or set_taken()
+    std::vector<std::uint32_t> next_;      // Next row with the same hash (npos = end)
+
+    // Open-addressing table over distinct hashes (built by build())
+    std::vector<std::uint64_t> slot_hash_;  // Hash of the slot's rows
+    std::vector<std::uint32_t> slot_head_;  // Lowest row that may be untaken (npos = empty slot)
+};
@@ -0,0 +1,179 @@
+// LineSource.hpp
+// -------------------------------------------------------------
+// Line-oriented input backends for diff-numerics
+//
+// Provides an abstract LineSource that yields lines as std::string_view
+// straight from its backing storage (no per-line heap copies), and the
+// concrete backends used by NumericDiff:
+// - BufferLineSource: lines from a caller-owned contiguous buffer
+// - MappedLineSource: memory-mapped regular file (zero-copy), with
+//   asynchronous read-ahead of the pages in front of the reader
+// - StreamLineSource: buffered reader for pipes, FIFOs, compressed files
+//   and other inputs that cannot be mapped
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ByteReader.hpp"
+
+/**
+ * Abstract source of text lines
+ *
+ * Lines are returned without their terminating '\n', with the same
+ * semantics as std::getline: a final line without newline is returned,
+ * an empty segment after the last newline is not.
+ *
+ * The returned view is only valid until the next call to next_line().
+ * Once a source is exhausted it keeps returning false.
+ */
+class LineSource {
+   public:
+    virtual ~LineSource() = default;
+
+    /** Fetch the next line, returns false at end of input */
+    virtual bool next_line(std::string_view& line) = 0;
+
+    /**
+     * Unread input as one contiguous view, if the backend holds it in memory
+     * Returns std::nullopt for streaming backends. Used by the chunked
+     * parallel engine, which needs random access to the whole input.
+     */
+    virtual std::optional<std::string_view> remaining() const { return std::nullopt; }
+
+    /**
+     * Discard the first n_bytes of remaining(), which hold n_lines whole lines
+     * Lets callers skip regions they already inspected in place without
+     * splitting them into lines again. Only valid for backends that
+     * implement remaining(); the default throws std::logic_error.
+     */
+    virtual void skip(size_t n_bytes, std::uint64_t n_lines);
+
+    /** Number of the line last returned by next_line() (1-based, 0 before the first) */
+    std::uint64_t line_number() const noexcept { return line_number_; }
+
+    /**
+     * Open the best available backend for a file path
+     *
+     * Regular files are memory-mapped; anything that cannot be mapped
+     * (pipes, FIFOs, character devices, empty files) falls back to a
+     * buffered reader. gzip/xz/zstd files (detected by magic bytes) are
+     * decompressed on the fly by a prefetching background thread.
+     * With read_ahead > 0, up to that many bytes in front of the reader
+     * are fetched asynchronously: pages of a mapping are requested from
+     * the kernel ahead of use, other inputs are read by a PrefetchReader.
+     * The path "-" reads standard input (mapped too when it is redirected
+     * from a regular file); it is not closed.
+     * Throws runtime_error if the file cannot be opened.
+     */
+    static std::unique_ptr<LineSource> open(const std::string& path, size_t read_ahead = 0);
+
+    /** Whether path names standard input ("-") */
+    static bool is_stdin(const std::string& path) noexcept { return path == "-"; }
+
+   protected:
+    std::uint64_t line_number_ = 0;  // Lines returned so far (plus any starting offset)
+};
+
+/**
+ * Line source over a contiguous in-memory buffer
+ *
+ * The buffer is not owned and must outlive the source. Used directly by
+ * tests and in-memory inputs, and as the base of MappedLineSource.
+ */
+class BufferLineSource : public LineSource {
+   public:
+    /** Serve lines of buffer; lines_before offsets line_number() for a slice of a larger input */
+    explicit BufferLineSource(std::string_view buffer, std::uint64_t lines_before = 0)
+        : buffer_(buffer) {
+        line_number_ = lines_before;
+    }
+
+    bool next_line(std::string_view& line) override;
+    std::optional<std::string_view> remaining() const override { return buffer_.substr(pos_); }
+    void skip(size_t n_bytes, std::uint64_t n_lines) override;
+
+   protected:
+    BufferLineSource() = default;
+
+    std::string_view buffer_;  // Whole input
+    size_t pos_ = 0;           // Offset of the next unread byte
+};
+
+/**
+ * Line source over a memory-mapped regular file
+ *
+ * Lines are views into the mapping itself. The mapping is released when
+ * the source is destroyed.
+ *
+ * With a read-ahead window, the pages in front of the reader are handed
+ * to the kernel with MADV_WILLNEED: it reads them in the background (for
+ * both inputs at once), so page faults on slow or network storage do not
+ * stall the parser. The window is topped up once less than half of it is
+ * left, i.e. every read_ahead / 2 bytes.
+ */
+class MappedLineSource : public BufferLineSource {
+   public:
+    /** Adopt a mapping; window is the read-ahead in bytes (0 = off) */
+    MappedLineSource(void* mapping, size_t length, size_t window = 0);
+    ~MappedLineSource() override;
+
+    MappedLineSource(const MappedLineSource&) = delete;
+    MappedLineSource& operator=(const MappedLineSource&) = delete;
+
+    bool next_line(std::string_view& line) override {
+        if (pos_ >= refill_at_) read_ahead();
+        return BufferLineSource::next_line(line);
+    }
+    void skip(size_t n_bytes, std::uint64_t n_lines) override;
+
+   private:
+    /** Request the pages up to read_ahead_ bytes past the reader */
+    void read_ahead();
+
+    void* mapping_;   // Base address returned by mmap
+    size_t length_;   // Length of the mapping in bytes
+    size_t read_ahead_;          // Window in front of the reader (0 = off)
+    size_t requested_ = 0;       // End of the range requested so far
+    size_t refill_at_ = static_cast<size_t>(-1);  // Reader offset that triggers the next request
+};
+
+/**
+ * Buffered line source over a byte stream
+ *
+ * Reads large blocks from a ByteReader (a descriptor, a decompressor,
+ * a prefetching stage) into a reusable buffer and returns views into
+ * it. The buffer only grows when a single line is longer than the
+ * current capacity.
+ */
+class StreamLineSource : public LineSource {
+   public:
+    /** Wrap a descriptor; it is closed on destruction if owns_fd is true */
+    StreamLineSource(int fd, std::string name, bool owns_fd = true);
+
+    /** Read lines from an arbitrary byte reader */
+    explicit StreamLineSource(std::unique_ptr<ByteReader> reader);
+
+    StreamLineSource(const StreamLineSource&) = delete;
+    StreamLineSource& operator=(const StreamLineSource&) = delete;
+
+    bool next_line(std::string_view& line) override;
+
+   private:
+    /** Read more data after the unconsumed tail, returns false at EOF */
+    bool refill();
+
+    std::unique_ptr<ByteReader> reader_;  // Source of bytes
+    bool eof_ = false;        // Reader reported end of input
+    std::vector<char> buf_;   // Read buffer
+    size_t begin_ = 0;        // First unconsumed byte in buf_
+    size_t end_ = 0;          // One past the last valid byte in buf_
+
+    static constexpr size_t block_size = 1 << 16;  // Initial buffer size (64 KiB)
+};
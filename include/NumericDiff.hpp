@@ -8,16 +8,38 @@
 // -------------------------------------------------------------
 
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <fstream>
+#include <initializer_list>
+#include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "ArraySource.hpp"
+#include "ColumnErrorStats.hpp"
+#include "ColumnSelection.hpp"
+#include "FixedWidthLayout.hpp"
+#include "Formatter.hpp"
+#include "LineSource.hpp"
 #include "Printer.hpp"
+#include "RunStats.hpp"
+#include "ToleranceKernel.hpp"
+
+class ReferenceCache;
+class ThreadPool;
 
 namespace numdiff {
 
+/** How --records writes the differing values (instead of the line-by-line output) */
+enum class RecordFormat : std::uint8_t {
+    none,    // Line-by-line text output
+    jsonl,   // One JSON object per differing value
+    binary,  // Packed fixed-size records (Printer::record_size bytes each)
+};
+
 /**
  * Configuration options for numerical comparison
  * Contains all user-configurable parameters for file comparison
@@ -33,16 +55,109 @@ struct NumericDiffOptions {
     int line_length = 60;                // Maximum line length for output formatting
     bool color_diff_digits = false;      // Colorize only differing digits (not entire numbers)
     std::set<size_t> columns_to_compare; // Specific columns to compare (1-based, empty = all)
+    size_t threads = 1;                  // Worker threads for chunked comparison (1 = sequential)
+    bool first_diff = false;             // Stop at the first difference beyond tolerance
+    InputFormat input_format = InputFormat::automatic;  // Encoding of both input files
+    std::vector<size_t> shape;           // Declared shape of raw inputs ({cols} or {rows, cols})
+    std::string dataset;                 // Dataset path inside HDF5 inputs
+    StatsFormat stats = StatsFormat::none;  // Collect per-stage statistics (--stats)
+    std::string reference_cache;         // Parsed sidecar cache of file1 (--cache, "" = off)
+    size_t resync_window = 0;            // Lookahead for inserted/deleted lines (0 = pair lines)
+    size_t key_column = 0;               // Column identifying a line when resyncing (0 = all)
+    std::set<size_t> join_columns;       // Key columns matching unordered rows (1-based, --join)
+    double key_tolerance = 0.0;          // Absolute tolerance of numeric keys (--join, --key)
+    std::uint64_t join_memory = 1ULL << 30;  // --join index budget before spilling to disk
+    size_t prefetch_bytes = 16 << 20;    // Asynchronous read-ahead per input (--prefetch, 0 = off)
+    size_t fixed_width_lines = 0;        // Lines learning the --fixed-width layout (0 = off)
+    size_t top_k = 0;                    // Report only the K largest value errors (--top, 0 = off)
+    StatsFormat column_stats = StatsFormat::none;  // Per-column error statistics (--column-stats)
+    RecordFormat records = RecordFormat::none;  // Differing values as records (--records)
+    std::uint64_t sample_lines = 0;      // Line pairs compared by --sample (0 = all lines)
+    bool specialize = true;              // Per-mode specialized line loops (false: generic loop)
     std::string file1, file2;            // Paths to files being compared
 };
 
+/**
+ * Location of a difference in both input files
+ * Line numbers count every physical line, including comment lines
+ */
+struct DiffLocation {
+    std::uint64_t line1 = 0;  // Line in file1 (1-based, 0 = none found, or a file2-only row)
+    std::uint64_t line2 = 0;  // Line in file2 (1-based)
+    size_t column = 0;        // First differing column (1-based, 0 = line in one file only)
+};
+
+/**
+ * One differing value pair (--top report, --records)
+ * Line numbers count every physical line, as in DiffLocation.
+ */
+struct ValueDifference {
+    double error = 0.0;       // Percentage error
+    std::uint64_t line1 = 0;  // Line in file1 (1-based)
+    std::uint64_t line2 = 0;  // Line in file2 (1-based)
+    size_t column = 0;        // Column (1-based; 0 = line in one file only, values are NaN)
+    double value1 = 0.0;      // Value in file1
+    double value2 = 0.0;      // Value in file2
+
+    /**
+     * Whether this difference ranks before other: larger error first, then
+     * earlier line and column, so the top K do not depend on the order in
+     * which candidates are met (sequential or merged from threads)
+     */
+    bool ranks_before(const ValueDifference& other) const noexcept {
+        if (error > other.error) return true;
+        if (error < other.error) return false;
+        if (line1 != other.line1) return line1 < other.line1;
+        if (line2 != other.line2) return line2 < other.line2;
+        return column < other.column;
+    }
+};
+
+/**
+ * Difference rate estimated from a random sample of line pairs (--sample)
+ * The population is the data lines present in both files; lower and upper
+ * bound the rate of differing lines at 95% confidence.
+ */
+struct SampleEstimate {
+    std::uint64_t n_lines1 = 0;     // Data lines of file1
+    std::uint64_t n_lines2 = 0;     // Data lines of file2
+    std::uint64_t population = 0;   // Line pairs sampled from (the shorter file)
+    std::uint64_t n_sampled = 0;    // Line pairs compared
+    std::uint64_t n_different = 0;  // Compared line pairs that differ
+    double rate = 0.0;              // Estimated fraction of differing line pairs
+    double lower = 0.0;             // Lower confidence bound of rate
+    double upper = 0.0;             // Upper confidence bound of rate
+};
+
 /**
  * Results from a numerical comparison operation
  * Contains statistics about differences found between files
  */
 struct NumericDiffResult {
-    std::uint32_t n_different_lines = 0;  // Count of lines with differences
+    std::uint32_t n_different_lines = 0;  // Count of lines with differences (unmatched included)
+    std::uint32_t n_only_in1 = 0;         // file1 lines without a peer (--resync, --join)
+    std::uint32_t n_only_in2 = 0;         // file2 lines without a peer (--resync, --join)
     double max_percentage_err = 0;        // Maximum percentage error found
+    DiffLocation first_diff;              // Where the first difference was found
+    std::vector<ValueDifference> top;       // Largest value errors, worst first (options.top_k)
+    ColumnErrorTable columns;             // Error statistics per column (options.column_stats)
+    SampleEstimate sample;                // Estimated difference rate (options.sample_lines)
+    RunStats stats;                       // Timings and counters (only with options.stats)
+};
+
+/**
+ * Per-column outcome of the numeric comparison kernel
+ * Produced for every token pair of a line, consumed by the rendering stage
+ */
+struct ColumnVerdict {
+    enum class Kind : std::uint8_t {
+        skipped,    // Column not selected with --columns
+        text,       // At least one token is non-numeric (not compared)
+        equal,      // Numeric and within tolerance
+        different   // Numeric and beyond tolerance
+    };
+    Kind kind = Kind::skipped;
+    double diff = 0.0;  // Percentage difference (set for different columns)
 };
 
 /**
@@ -61,24 +176,351 @@ class NumericDiff {
     
     /** Construct with options and custom output stream */
     explicit NumericDiff(const NumericDiffOptions& opts, std::ostream& os)
-        : options_(opts), printer_(os) {};
+        : options_(opts), columns_(opts.columns_to_compare), printer_(os) {};
+
+    /** Construct with options, rendering into a caller-owned output buffer */
+    explicit NumericDiff(const NumericDiffOptions& opts, OutputBuffer& out)
+        : options_(opts), columns_(opts.columns_to_compare), printer_(out) {};
     
-    /** Execute the comparison and return results */
+    /** Execute the comparison of options.file1 and options.file2 and return results */
     NumericDiffResult run();
 
+    /** Execute the comparison over two already opened line sources */
+    NumericDiffResult run(LineSource& source1, LineSource& source2);
+
+    /** Execute the comparison over two binary arrays (rows are compared like lines) */
+    NumericDiffResult run(const ArraySource& array1, const ArraySource& array2);
+
+    /**
+     * Run the chunks of the parallel engine (options.threads > 1) on a shared pool
+     * instead of a private one; run() may then itself be a task of that pool.
+     */
+    void set_pool(ThreadPool* pool) noexcept { pool_ = pool; }
+
    private:
+    friend class StreamingDiff;  // Drives compare_lines() line pair by line pair
+
+    /** Byte range of an input holding whole lines, with its data-line numbering */
+    struct LineChunk {
+        std::string_view bytes;       // Whole lines of the chunk (including newlines)
+        std::uint64_t first_line = 0; // Global index of the chunk's first non-comment line
+        std::uint64_t n_lines = 0;    // Number of non-comment lines in the chunk
+        std::uint64_t first_physical = 0;  // Physical lines preceding the chunk
+        std::uint64_t n_physical = 0;      // Physical lines in the chunk
+    };
+
+    /**
+     * Data lines of an in-memory input, located by index (--sample)
+     * Either counted chunks, or with --fixed-width records of one length
+     * (record_length > 0) found by arithmetic without reading the file.
+     */
+    struct LineIndex {
+        std::string_view data;             // The whole input
+        std::vector<LineChunk> chunks;     // Counted chunks (unless records)
+        size_t record_offset = 0;          // Records: bytes before the first data line
+        size_t record_length = 0;          // Records: bytes per line, newline included
+        std::uint64_t first_physical = 0;  // Records: physical lines before the first
+        std::uint64_t n_lines = 0;         // Data lines of the input
+    };
+
+    /** Data line held in the --resync lookahead, parsed once for matching */
+    struct ResyncLine {
+        std::string_view text;                  // The line (into the source or into storage)
+        std::string storage;                    // Copy for sources that reuse their buffer
+        std::uint64_t physical = 0;             // Physical line number (1-based)
+        bool parsed = false;                    // tokens/values/numeric are filled
+        std::vector<std::string_view> tokens;   // Tokens of text
+        std::vector<double> values;             // Value of each numeric token
+        std::vector<std::uint8_t> numeric;      // Whether each token is a number
+    };
+
+    /** Ring of the next lookahead lines of one input (--resync) */
+    struct ResyncWindow {
+        std::vector<ResyncLine> ring;  // Fixed capacity: entries never move
+        size_t head = 0;               // Index of the front line in ring
+        size_t size = 0;               // Lines held
+        bool copy = true;              // Lines must be copied (source buffers are reused)
+
+        ResyncLine& operator[](size_t i) { return ring[(head + i) % ring.size()]; }
+        void pop_front() {
+            head = (head + 1) % ring.size();
+            size--;
+        }
+    };
+
+    /** Data line of file1 held by the --join index */
+    struct JoinRow {
+        std::string_view text;       // The line (into the source or into stored copies)
+        std::uint64_t physical = 0;  // Physical line number (1-based)
+    };
+
     NumericDiffOptions options_;           // Comparison configuration
-    static constexpr double big = 1.0E99;  // Value for "infinite" percentage difference
+    ColumnSelection columns_;              // options_.columns_to_compare, compiled to a bitmap
+    FixedWidthLayout layout1_{options_.fixed_width_lines};  // --fixed-width fields of file1
+    FixedWidthLayout layout2_{options_.fixed_width_lines};  // --fixed-width fields of file2
+    static constexpr size_t chunks_per_thread = 4;        // Oversubscription for load balance
+    static constexpr size_t min_chunk_bytes = 1 << 20;    // Smaller inputs are not split
+    static constexpr size_t identity_block_bytes = 1 << 12;  // memcmp stride of identity scans
+    static constexpr size_t array_block_values = 1 << 12;    // Values per kernel call on arrays
+    static constexpr size_t join_partitions = 64;  // Partitions of a spilled --join
+    static constexpr size_t sample_chunk_bytes = 1 << 16;  // --sample: seek granularity
+    static constexpr std::uint64_t sample_seed = 0x9E3779B97F4A7C15ULL;  // Reproducible --sample
     Printer printer_;                      // Handles formatted output
+    std::vector<std::string_view> tokens1_, tokens2_;  // Reused per-line token buffers
+    std::vector<ColumnVerdict> verdicts_;               // Reused per-line kernel output
+    std::vector<double> values1_, values2_, diffs_;     // Reused numeric block of a line
+    std::vector<size_t> value_columns_;                 // Token index of each block entry
+    std::vector<std::uint8_t> diff_mask_;               // Kernel verdict per block entry
+    std::vector<ValueDifference> line_diffs_;           // Differing values of the line
+    TokenArena colored_, errors_;                       // Colored tokens; error texts of a line
+    std::vector<Printer::Cell> cells1_, cells2_, error_cells_;  // Reused rendered line
+    std::vector<size_t> col_widths_;                    // Column widths of the printed line
+    std::string blanks_;                                // Padding for error cells
+    std::string row_text1_, row_text2_;                 // Printed array rows rendered as text
+    std::vector<double> row_values_;                    // Full array row being printed
+    RunStats stats_;                                    // Statistics of the current run
+    ColumnErrorTable column_stats_;                     // Column errors of the current run
+    std::chrono::steady_clock::time_point stats_start_; // Start of the current run
+    std::uint64_t stats_bytes_before_ = 0;              // Printer output before the run
+    ThreadPool* pool_ = nullptr;                        // Shared pool (null: private per run)
 
    private:
+    /** Sequential or parallel comparison of two line sources (body of run) */
+    NumericDiffResult compare_sources(LineSource& source1, LineSource& source2);
+
+    /** Row-by-row comparison of two arrays (body of run) */
+    NumericDiffResult compare_arrays(const ArraySource& array1, const ArraySource& array2);
+
+    /** Reset statistics and start the wall clock of a run (--stats), reset column errors */
+    void begin_stats();
+
+    /** Complete the result of a finished run: rank the --top list, add the statistics */
+    void finish_run(NumericDiffResult& result);
+
+    /** Statistics being collected, or null when --stats is off */
+    RunStats* stats() noexcept { return options_.stats != StatsFormat::none ? &stats_ : nullptr; }
+
+    /**
+     * Add n compared value pairs to the --column-stats accumulators
+     * columns[k] is the (0-based) column of pair k, mask[k] its kernel verdict.
+     */
+    void record_column_errors(const double* values1, const double* values2,
+                              const std::uint8_t* mask, const size_t* columns, size_t n);
+
+    /** Map the --cache sidecar of file1 (text1), building and writing it if missing or stale */
+    std::unique_ptr<ReferenceCache> open_reference_cache(std::string_view text1) const;
+
+    /** Sequential comparison of a cached reference (parsed from text1) with a text source */
+    NumericDiffResult compare_cached(const ReferenceCache& reference, std::string_view text1,
+                                     LineSource& source2);
+
+    /** Kernel for data line index of the reference against line2 (like compare_lines) */
+    std::pair<bool, double> compare_cached_line(const ReferenceCache& reference, size_t index,
+                                                std::string_view text1, std::string_view line2);
+
+    /** Count, run the kernel on the gathered block and mark different verdicts */
+    std::pair<bool, double> apply_verdicts(size_t n_text);
+
+    /**
+     * Sequential comparison that realigns inserted and deleted lines (--resync)
+     * Lines that do not match are looked up in a bounded window of the next lines.
+     */
+    NumericDiffResult compare_resync(LineSource& source1, LineSource& source2);
+
+    /**
+     * Comparison of rows in any order, paired by key columns (--join)
+     * file1 is indexed in memory, or partitioned on disk beyond options.join_memory.
+     */
+    NumericDiffResult compare_joined(LineSource& source1, LineSource& source2);
+
+    /** --join beyond the memory budget: rows1 were read so far, the rest is still in source1 */
+    NumericDiffResult compare_spilled(const std::vector<JoinRow>& rows1, LineSource& source1,
+                                      LineSource& source2);
+
+    /** Read data lines into window until it holds n (or the source ends) */
+    void fill_window(ResyncWindow& window, LineSource& source, size_t n);
+
+    /** Whether two lines are the same row: equal keys, or equal within tolerance */
+    bool rows_match(ResyncLine& a, ResyncLine& b);
+
+    /** Tokenize and parse a window line once */
+    void parse_resync_line(ResyncLine& line);
+
+    /** Kernel for two window lines with the same number of tokens (like compare_lines) */
+    std::pair<bool, double> compare_resync_lines(ResyncLine& a, ResyncLine& b);
+
+    /**
+     * Report a line present in one file only, at physical line of its file
+     * other_line locates it in the other file (0 if nowhere). Returns true
+     * if --first-diff must stop.
+     */
+    bool report_unmatched(NumericDiffResult& result, std::string_view text,
+                          std::uint64_t physical, bool in_file1, std::uint64_t other_line);
+
+    /** Chunked multi-threaded comparison of two in-memory inputs */
+    NumericDiffResult run_parallel(std::string_view data1, std::string_view data2);
+
+    /**
+     * Options that shape the per-line work, as run-time flags (generic line loop)
+     * print: some lines are printed (not --only-equal); print_equal:
+     * lines without differences too (side-by-side without -s); all_columns:
+     * no --columns; skip_identical: see can_skip_identical().
+     */
+    struct DynamicMode {
+        bool print;
+        bool print_equal;
+        bool all_columns;
+        bool skip_identical;
+        bool column_stats;
+    };
+
+    /**
+     * The same flags as compile-time constants (specialized line loops)
+     * Only for non-negative tolerances, where identical lines are skipped
+     * whenever they are not printed.
+     */
+    template <bool Print, bool PrintEqual, bool AllColumns>
+    struct StaticMode {
+        static constexpr bool print = Print;
+        static constexpr bool print_equal = PrintEqual;
+        static constexpr bool all_columns = AllColumns;
+        static constexpr bool skip_identical = !PrintEqual;
+        static constexpr bool column_stats = false;
+    };
+
+    /** The mode of the active options as run-time flags */
+    DynamicMode dynamic_mode() const;
+
+    /** Call f(mode) with the StaticMode of the active options (DynamicMode if none applies) */
+    template <class F>
+    decltype(auto) with_mode(F&& f) const;
+
+    /** line_must_be_printed() under a mode */
+    template <class Mode>
+    static bool must_print(const Mode& mode, bool any_error) noexcept {
+        return mode.print && (mode.print_equal || any_error);
+    }
+
+    /** Line-paired loop of compare_sources(), instantiated per mode */
+    template <class Mode>
+    NumericDiffResult compare_sequential(const Mode& mode, LineSource& source1,
+                                         LineSource& source2);
+
+    /**
+     * Compare the next n_lines non-comment line pairs of two sources into result
+     * Returns true if it stopped on a difference (--first-diff)
+     */
+    template <class Mode>
+    bool compare_range(const Mode& mode, LineSource& source1, LineSource& source2,
+                       std::uint64_t n_lines, NumericDiffResult& result,
+                       const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * Fold one line outcome into result, line1/line2 locating it in each file
+     * only_in1/only_in2: the line has no peer (its --records record gets line 0 for the other
+     * file). Returns true if --first-diff must stop
+     */
+    bool accumulate(NumericDiffResult& result, std::pair<bool, double> line_result,
+                    std::uint64_t line1, std::uint64_t line2, bool only_in1 = false,
+                    bool only_in2 = false);
+
+    /** Whether a --fixed-width layout still learns (its lines must be tokenized, even identical) */
+    bool learning_layout() const noexcept { return layout1_.learning() || layout2_.learning(); }
+
+    /** Whether the differing values of each line are collected (--top, --records) */
+    bool collects_differences() const noexcept {
+        return options_.top_k > 0 || options_.records != RecordFormat::none;
+    }
+
+    /** Encoding of an input: options.input_format, or detected from the file */
+    InputFormat resolve_format(const std::string& path) const;
+
+    /** Render array values as text tokens (views into text) for printing */
+    static void format_row(const double* values, size_t n, std::string& text,
+                           std::vector<std::string_view>& tokens);
+
+    /** Whether byte-identical lines may be skipped without tokenizing (nothing to print) */
+    bool can_skip_identical() const;
+
+    /**
+     * Skip the byte-identical whole lines at the front of two in-memory sources
+     * Returns the number of non-comment lines skipped (0 for streaming sources)
+     */
+    std::uint64_t skip_identical_lines(LineSource& source1, LineSource& source2);
+
+    /** Length of the longest common prefix of a and b that ends on a line boundary */
+    static size_t identical_line_prefix(std::string_view a, std::string_view b) noexcept;
+
+    /** Count every chunk's lines (on pool when given) and number the chunks in file order */
+    void count_chunks(std::initializer_list<std::vector<LineChunk>*> inputs,
+                      ThreadPool* pool) const;
+
+    /** Estimate the difference rate from a random subset of aligned line pairs (--sample) */
+    NumericDiffResult compare_sampled(std::string_view data1, std::string_view data2);
+
+    /** Locate the data lines of an input: as fixed-length records if allowed and they are */
+    LineIndex index_lines(std::string_view data, bool records, ThreadPool* pool) const;
+
+    /** Whether an input after its header is records of the first data line's length */
+    bool index_records(LineIndex& index) const;
+
+    /** Whether record k of an indexed input is one whole data line */
+    bool record_fits(const LineIndex& index, std::uint64_t k) const;
+
+    /** Data line k of an indexed input, its physical line number (1-based) in physical */
+    std::string_view data_line(const LineIndex& index, std::uint64_t k,
+                               std::uint64_t& physical) const;
+
+    /** Split data into n_chunks byte ranges that start and end on line boundaries */
+    static std::vector<LineChunk> split_into_chunks(std::string_view data, size_t n_chunks);
+
+    /** Count non-comment and physical lines of a chunk */
+    void count_lines(LineChunk& chunk) const;
+
+    /** Position a source on the non-comment line with the given global index */
+    BufferLineSource seek_data_line(std::string_view data, const std::vector<LineChunk>& chunks,
+                                    std::uint64_t index) const;
+
     /** Compare two lines token-by-token, returns (has_diff, max_percentage_error) */
-    std::pair<bool, double> compare_lines(const std::string& line1, const std::string& line2);
-    
-    /** Calculate percentage difference between two numeric values */
-    double percentage_difference(double value1, double value2) const;
-    
-    /** Open a file and throw exception if it fails */
-    std::ifstream open_and_validate_file(const std::string& file_path) const;
+    std::pair<bool, double> compare_lines(std::string_view line1, std::string_view line2);
+
+    /** compare_lines() under a given mode */
+    template <class Mode>
+    std::pair<bool, double> compare_lines(const Mode& mode, std::string_view line1,
+                                          std::string_view line2);
+
+    /** Comparison kernel: fill verdicts_ from the current tokens, no formatting */
+    template <class Mode>
+    std::pair<bool, double> compare_tokens(const Mode& mode);
+
+    /** Kernel over tokens that are all selected: no verdicts, returns (has_diff, max_error) */
+    std::pair<bool, double> compare_selected_tokens();
+
+    /** Run the tolerance kernel over the gathered values1_/values2_ block */
+    ToleranceKernel::BlockResult compare_values();
+
+    /** Whether the current line pair must be rendered under the active options */
+    bool line_must_be_printed(bool any_error) const;
+
+    /** Rendering stage: build colored output for the current line pair and print it */
+    void render_line();
+
+    /** Tokens of a line: sliced by the file's --fixed-width layout if it fits, else tokenized */
+    void split_line(FixedWidthLayout& layout, std::string_view line,
+                    std::vector<std::string_view>& tokens);
+
+    /** split_line() keeping only the selected columns; returns the number of columns */
+    size_t split_selected(FixedWidthLayout& layout, std::string_view line,
+                          std::vector<std::string_view>& tokens);
+
+    /**
+     * Advance a source to its next non-comment line, returns false at EOF
+     * Bytes and comment lines passed over are counted into stats when given.
+     */
+    bool next_data_line(LineSource& source, std::string_view& line,
+                        RunStats* stats = nullptr) const;
+
+    /** Open a file as a line source and throw exception if it fails */
+    std::unique_ptr<LineSource> open_and_validate_file(const std::string& file_path) const;
 };
 }  // namespace numdiff
\ No newline at end of file
@@ -0,0 +1,68 @@
+// OutputBuffer.hpp
+// -------------------------------------------------------------
+// Batched output sink for diff-numerics
+//
+// Collects rendered output in one large reusable byte buffer and hands
+// it to the underlying stream in big writes. An OutputBuffer without a
+// stream only collects, which the parallel engine uses to render each
+// chunk separately and concatenate the chunks in file order.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Append-only byte buffer flushed to an ostream in large blocks
+ *
+ * Producers append whole records (lines) and call commit() after each;
+ * the buffer is written out once it holds at least flush_threshold
+ * bytes, and on flush() or destruction. The storage keeps its capacity
+ * across flushes, so steady-state output performs no allocation.
+ */
+class OutputBuffer {
+   public:
+    /** Buffer for os; with os == nullptr bytes are only collected (see view()) */
+    explicit OutputBuffer(std::ostream* os = nullptr, size_t flush_threshold = default_threshold);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(std::string_view text) { data_.append(text.data(), text.size()); }
+    void append(char c) { data_.push_back(c); }
+
+    /** Append n copies of c (padding) */
+    void append_fill(size_t n, char c = ' ') { data_.append(n, c); }
+
+    /** Direct access for formatters that render in place; call commit() afterwards */
+    std::string& data() noexcept { return data_; }
+
+    /** End of a record: write out the buffer if it reached the flush threshold */
+    void commit() {
+        if (os_ != nullptr && data_.size() >= flush_threshold_) flush();
+    }
+
+    /** Write all pending bytes to the stream (no-op for collecting buffers) */
+    void flush();
+
+    /** Pending bytes */
+    std::string_view view() const noexcept { return data_; }
+
+    /** Bytes appended over the buffer's lifetime (written out or pending) */
+    std::uint64_t total_bytes() const noexcept { return flushed_bytes_ + data_.size(); }
+
+    /** Discard pending bytes, keeping the capacity */
+    void clear() noexcept { data_.clear(); }
+
+    static constexpr size_t default_threshold = 1 << 16;  // Flush in 64 KiB writes
+
+   private:
+    std::ostream* os_;         // Destination (null: collect only)
+    size_t flush_threshold_;   // Pending size that triggers a write
+    std::string data_;         // Pending bytes
+    std::uint64_t flushed_bytes_ = 0;  // Bytes already written to the stream
+};
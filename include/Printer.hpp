@@ -9,14 +9,22 @@
 // -------------------------------------------------------------
 
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "OutputBuffer.hpp"
+#include "RunStats.hpp"
+
 // Forward declarations to avoid circular dependency
 namespace numdiff {
 struct NumericDiffResult;
 struct NumericDiffOptions;
+struct ValueDifference;
+enum class RecordFormat : std::uint8_t;
 }  // namespace numdiff
 
 /**
@@ -28,13 +36,23 @@ struct NumericDiffOptions;
  * - Unified diff format (< line1 / > line2 / >> errors)
  * - Proper handling of ANSI color codes in width calculations
  * 
- * Outputs to a configurable ostream (typically stdout, but can be
- * redirected for testing or file output).
+ * Renders into an OutputBuffer: either its own buffer over a configurable
+ * ostream (typically stdout, flushed in large writes), or a caller-owned
+ * collecting buffer (per-chunk output of the parallel engine).
  */
 class Printer {
    public:
-    /** Construct printer with output stream */
-    Printer(std::ostream& os) : os_(os) {}
+    /** A rendered token: text (possibly with ANSI color codes) and its visible width */
+    struct Cell {
+        std::string_view text;
+        size_t width;
+    };
+
+    /** Construct printer with output stream (buffered, see flush()) */
+    Printer(std::ostream& os);
+
+    /** Construct printer rendering into a caller-owned buffer */
+    explicit Printer(OutputBuffer& out) : out_(&out) {}
 
     /**
      * Print summary or detailed results based on options
@@ -59,6 +77,16 @@ class Printer {
                                    const std::vector<std::string>& tokens2,
                                    const std::vector<size_t>& col_widths, int line_length);
 
+    /**
+     * Side-by-side output from cells with known visible widths
+     * Same output as print_side_by_side_tokens, but padding uses the
+     * precomputed widths and both lines are built and truncated in
+     * reusable buffers, so no ANSI stripping or allocation is needed.
+     */
+    void print_side_by_side_cells(const std::vector<Cell>& cells1,
+                                  const std::vector<Cell>& cells2,
+                                  const std::vector<size_t>& col_widths, int line_length);
+
     /**
      * Print differences in unified diff format
      * 
@@ -72,6 +100,96 @@ class Printer {
     void print_diff(const std::string& output1, const std::string& output2,
                     const std::string& errors);
 
+    /**
+     * Unified diff output from cells, joined with single spaces
+     * Same output as print_diff on the joined strings.
+     */
+    void print_diff_cells(const std::vector<Cell>& cells1, const std::vector<Cell>& cells2,
+                          const std::vector<Cell>& errors);
+
+    /**
+     * Print a line found in only one of the files (--resync)
+     * 
+     * Unified diff: a block of its own, "< line" for file1 or "> line"
+     * for file2. Side by side: the line on its own side, with "<" or ">"
+     * in place of the "|" separator.
+     */
+    void print_unmatched_cells(const std::vector<Cell>& cells, bool in_file1, bool side_by_side,
+                               int line_length);
+
+    /** Size of a binary record: line1, line2 (u64), column (u32), value1, value2, error (f64) */
+    static constexpr size_t record_size = 44;
+
+    /**
+     * Write differing values as records (--records)
+     *
+     * JSONL: one object per value,
+     * {"line1":L1,"line2":L2,"column":C,"v1":V1,"v2":V2,"err":E},
+     * numbers in their shortest round-trip form, non-finite values as
+     * null. Binary: record_size bytes per value, fields packed in that
+     * order in native byte order.
+     */
+    void print_records(const std::vector<numdiff::ValueDifference>& differences,
+                       numdiff::RecordFormat format);
+
+    /**
+     * Write already rendered output verbatim
+     * Used to emit the buffered output of parallel chunks in file order.
+     */
+    void print_raw(std::string_view text) {
+        out_->append(text);
+        out_->commit();
+    }
+
+    /** Write pending output to the stream */
+    void flush() { out_->flush(); }
+
+    /** Output bytes produced so far (for --stats) */
+    std::uint64_t bytes_written() const noexcept { return out_->total_bytes(); }
+
+    /** Report run statistics in the requested format (text or JSON) */
+    static void print_stats(std::ostream& os, const numdiff::RunStats& stats,
+                            numdiff::StatsFormat format);
+
+    /**
+     * Report of the largest value errors (--top)
+     * The summary of only-equal mode, then one row per kept difference,
+     * worst first: its lines, column, both values and percentage error.
+     */
+    static void print_top(std::ostream& os, const numdiff::NumericDiffResult& result,
+                          const numdiff::NumericDiffOptions& opts);
+
+    /**
+     * Report of a sampled comparison (--sample)
+     * How many line pairs were compared and differ, the estimated rate of
+     * differing lines with its 95% confidence bounds, and a warning when
+     * the files have different numbers of data lines.
+     */
+    static void print_sample(std::ostream& os, const numdiff::NumericDiffResult& result,
+                             const numdiff::NumericDiffOptions& opts);
+
+    /**
+     * Report per-column error statistics (--column-stats)
+     * Text: a table of the compared columns, then their non-empty
+     * relative error bins. JSON: one object per file pair, on one line.
+     */
+    static void print_column_stats(std::ostream& os, const numdiff::NumericDiffResult& result,
+                                   const numdiff::NumericDiffOptions& opts);
+
    private:
-    std::ostream& os_;  // Output stream (stdout or custom)
+    /** Summary text for quiet and only-equal modes */
+    static void print_summary(std::ostream& os, const numdiff::NumericDiffResult& result,
+                              const numdiff::NumericDiffOptions& opts);
+
+    /** Count of lines found in one file only, if any (--resync) */
+    static void print_unmatched(std::ostream& os, const numdiff::NumericDiffResult& result,
+                                const numdiff::NumericDiffOptions& opts);
+
+    /** Whether any cell contains the red color code, i.e. the line has differences */
+    static bool cells_are_red(const std::vector<Cell>& cells) noexcept;
+
+    std::unique_ptr<OutputBuffer> owned_;  // Buffer over the stream (stream constructor only)
+    OutputBuffer* out_;                    // Destination of all output
+    std::string line1_, line2_;            // Reused side-by-side line buffers
+    std::vector<Cell> cells1_, cells2_;    // Reused cells for the string-based entry points
 };
\ No newline at end of file
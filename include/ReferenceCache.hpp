@@ -0,0 +1,114 @@
+// ReferenceCache.hpp
+// -------------------------------------------------------------
+// Parsed-reference sidecar cache for diff-numerics (--cache)
+//
+// Stores the parsed content of a text file (its data lines after
+// comment filtering, the token layout of each line and every numeric
+// value) in a compact binary file next to it. Later comparisons against
+// the same reference map the cache instead of tokenizing and parsing
+// the reference again; only the candidate file is text-parsed.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Binary image of a parsed text file, owned or memory-mapped
+ *
+ * The image is tied to the exact bytes of the text (size and content
+ * hash) and to the comment prefix used to filter it; load() rejects a
+ * cache that does not match, so a stale sidecar is rebuilt, never used.
+ * Values are stored in host byte order.
+ */
+class ReferenceCache {
+   public:
+    /** One data (non-comment) line of the reference */
+    struct Line {
+        std::uint64_t offset;       // Byte offset of the line in the text
+        std::uint64_t physical;     // Physical line number (1-based, counting comments)
+        std::uint64_t first_token;  // Index of the line's first token in values()/numeric()
+        std::uint32_t length;       // Line length in bytes (without the newline)
+        std::uint32_t n_tokens;     // Number of whitespace-separated tokens
+    };
+
+    ~ReferenceCache();
+
+    ReferenceCache(const ReferenceCache&) = delete;
+    ReferenceCache& operator=(const ReferenceCache&) = delete;
+
+    /** Tokenize and parse text into an in-memory image */
+    static std::unique_ptr<ReferenceCache> build(std::string_view text,
+                                                 std::string_view comment_prefix);
+
+    /**
+     * Map the cache at path if it was built from exactly this text and prefix
+     * Returns nullptr when the file is missing, truncated, from another
+     * version or byte order, stale, or has line records that do not fit
+     * the text and token arrays.
+     */
+    static std::unique_ptr<ReferenceCache> load(const std::string& path, std::string_view text,
+                                                std::string_view comment_prefix);
+
+    /**
+     * Write the image to path (through a temporary file and rename, so
+     * concurrent readers never see a partial cache); returns false on failure
+     */
+    bool write(const std::string& path) const;
+
+    size_t n_lines() const noexcept { return n_lines_; }
+    const Line& line(size_t i) const noexcept { return lines_[i]; }
+
+    /** Parsed value of a token (meaningful only where numeric() is set) */
+    const double* values() const noexcept { return values_; }
+
+    /** 1 for tokens that parsed as numbers, 0 for text tokens */
+    const std::uint8_t* numeric() const noexcept { return numeric_; }
+
+    /** 64-bit content hash used to tie a cache to its text (not cryptographic) */
+    static std::uint64_t content_hash(std::string_view data) noexcept;
+
+    /** Default sidecar path of a reference file */
+    static std::string default_path(const std::string& file) { return file + ".dncache"; }
+
+   private:
+    /** Fixed-size header at the start of the image */
+    struct Header {
+        char magic[8];                 // "DNCACHE\0"
+        std::uint32_t version;         // format_version
+        std::uint32_t byte_order;      // byte_order_mark as written by the host
+        std::uint64_t text_size;       // Size of the reference text
+        std::uint64_t text_hash;       // content_hash() of the reference text
+        std::uint64_t n_lines;         // Data lines
+        std::uint64_t n_tokens;        // Tokens over all data lines
+        std::uint64_t prefix_size;     // Comment prefix length (bytes follow the header)
+    };
+
+    ReferenceCache() = default;
+
+    /** Byte size of an image with the given counts */
+    static size_t image_size(size_t prefix_size, size_t n_lines, size_t n_tokens) noexcept;
+
+    /** Point the section views into image (header already validated) */
+    void attach(const char* image);
+
+    /** Whether every line lies inside the text and the lines tile the token arrays in order */
+    bool consistent(size_t text_size, size_t n_tokens) const noexcept;
+
+    // Bumped whenever the image layout or the token parser changes, since a
+    // cache stores parser verdicts: 2 = Fortran-aware parser (D exponents, Ew.d)
+    static constexpr std::uint32_t format_version = 2;
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+    std::vector<char> storage_;      // Owned image (built, not loaded)
+    void* mapping_ = nullptr;        // Mapped image (loaded)
+    size_t mapping_length_ = 0;
+    size_t n_lines_ = 0;
+    const Line* lines_ = nullptr;
+    const double* values_ = nullptr;
+    const std::uint8_t* numeric_ = nullptr;
+};
@@ -0,0 +1,89 @@
+// RunStats.hpp
+// -------------------------------------------------------------
+// Opt-in instrumentation for diff-numerics (--stats)
+//
+// Holds per-stage wall time and work counters of one comparison, and
+// the scoped timer used to fill them. Instrumentation is off unless a
+// stats format is requested: timers then hold a null pointer and cost
+// one well-predicted branch each.
+// -------------------------------------------------------------
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace numdiff {
+
+/** How --stats reports the collected statistics */
+enum class StatsFormat : std::uint8_t {
+    none,  // Not collected
+    text,  // Human-readable summary on stderr
+    json   // One JSON object on stderr
+};
+
+/**
+ * Per-stage timings and counters of a comparison
+ *
+ * Stage times are summed over all threads, so with --threads they can
+ * exceed the wall time.
+ */
+struct RunStats {
+    /** Pipeline stages that are timed separately */
+    enum class Stage : std::uint8_t {
+        read,      // Fetching lines (I/O, decompression, comment skipping) or array rows
+        identity,  // Skipping byte-identical regions
+        tokenize,  // Splitting lines into tokens
+        parse,     // Number parsing
+        compare,   // Tolerance kernel
+        render,    // Formatting and printing output lines
+    };
+    static constexpr size_t n_stages = 6;
+
+    std::array<std::uint64_t, n_stages> stage_ns{};  // Time per stage (nanoseconds)
+    std::uint64_t wall_ns = 0;          // Wall time of the whole comparison
+    std::uint64_t bytes_read = 0;       // Input bytes consumed, both files (lines and newlines)
+    std::uint64_t lines = 0;            // Data line pairs (array rows) processed
+    std::uint64_t identical_lines = 0;  // Of which skipped as byte-identical, never tokenized
+    std::uint64_t comment_lines = 0;    // Comment lines skipped, both files
+    std::uint64_t tokens = 0;           // Tokens produced by the tokenizer, both files
+    std::uint64_t sliced_lines = 0;     // Lines sliced by their --fixed-width layout, both files
+    std::uint64_t numeric_columns = 0;  // Compared column pairs where both tokens are numbers
+    std::uint64_t text_columns = 0;     // Compared column pairs with a non-numeric token
+    std::uint64_t lines_printed = 0;    // Line pairs rendered to the output
+    std::uint64_t bytes_written = 0;    // Output bytes produced
+
+    /** Add another run's (or chunk's) statistics, wall time excluded */
+    void merge(const RunStats& other) noexcept;
+
+    /** Short name of a stage (for reports) */
+    static const char* stage_name(Stage stage) noexcept;
+};
+
+/**
+ * Adds the lifetime of a scope to one stage of a RunStats
+ * A null stats pointer disables the timer.
+ */
+class StageTimer {
+   public:
+    StageTimer(RunStats* stats, RunStats::Stage stage) noexcept : stats_(stats), stage_(stage) {
+        if (stats_ != nullptr) start_ = std::chrono::steady_clock::now();
+    }
+    ~StageTimer() {
+        if (stats_ == nullptr) return;
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_->stage_ns[static_cast<size_t>(stage_)] += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+   private:
+    RunStats* stats_;                                   // Destination (null: disabled)
+    RunStats::Stage stage_;                             // Stage being timed
+    std::chrono::steady_clock::time_point start_{};     // Start of the scope
+};
+
+}  // namespace numdiff
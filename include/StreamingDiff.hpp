@@ -0,0 +1,123 @@
+// StreamingDiff.hpp
+// -------------------------------------------------------------
+// Incremental comparison API of libdiffnumerics
+//
+// Compares two inputs that arrive piecewise (e.g. a solver's output
+// while it is being written against an in-memory reference) without
+// files: bytes or whole lines are fed for each side, line pairs are
+// compared as soon as both sides have one, and every out-of-tolerance
+// value is reported through a callback.
+// -------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "NumericDiff.hpp"
+#include "OutputBuffer.hpp"
+
+namespace numdiff {
+
+/** One value beyond tolerance, as reported to a StreamingDiff callback */
+struct DiffEvent {
+    std::uint64_t line1 = 0;       // Line in input 1 (1-based, counting comment lines)
+    std::uint64_t line2 = 0;       // Line in input 2
+    size_t column = 0;             // Column (1-based)
+    std::string_view token1;       // Value text in input 1 (valid during the callback only)
+    std::string_view token2;       // Value text in input 2
+    double percentage_err = 0.0;   // Percentage difference
+};
+
+/**
+ * Incremental line-by-line comparison of two inputs
+ *
+ * Uses the same options and comparison rules as NumericDiff::run()
+ * (file1/file2, threads and input_format are ignored). Inputs may be
+ * fed in chunks of any size, split anywhere; data stays buffered only
+ * until the other side catches up. With an output stream the usual
+ * diff output is rendered to it; without one nothing is rendered.
+ *
+ * Errors (column count mismatch) are thrown as runtime_error from the
+ * feed call that completes the offending line pair.
+ */
+class StreamingDiff {
+   public:
+    using DiffCallback = std::function<void(const DiffEvent&)>;
+
+    /** Compare without rendering; on_diff (optional) receives each differing value */
+    explicit StreamingDiff(const NumericDiffOptions& opts, DiffCallback on_diff = nullptr);
+
+    /** Compare and render output to os as run() would */
+    StreamingDiff(const NumericDiffOptions& opts, std::ostream& os,
+                  DiffCallback on_diff = nullptr);
+
+    StreamingDiff(const StreamingDiff&) = delete;
+    StreamingDiff& operator=(const StreamingDiff&) = delete;
+
+    /** Append bytes to input 1 / input 2 (lines end with '\n') */
+    void feed1(std::string_view bytes) { feed(side1_, bytes); }
+    void feed2(std::string_view bytes) { feed(side2_, bytes); }
+
+    /** Append one whole line (without its newline) to input 1 / input 2 */
+    void feed_line1(std::string_view line) { feed_line(side1_, line); }
+    void feed_line2(std::string_view line) { feed_line(side2_, line); }
+
+    /** Result over the line pairs compared so far (statistics are filled by finish()) */
+    const NumericDiffResult& result() const noexcept { return result_; }
+
+    /** Whether comparison stopped at a difference (options.first_diff); later input is ignored */
+    bool stopped() const noexcept { return stopped_; }
+
+    /**
+     * End of both inputs
+     * Compares unterminated last lines and lines left over on one side
+     * (which must be blank), flushes the output and returns the result.
+     */
+    NumericDiffResult finish();
+
+   private:
+    /** Buffered input of one side */
+    struct Side {
+        std::string data;               // Bytes not yet consumed
+        size_t pos = 0;                 // Start of the unconsumed bytes
+        size_t scanned = 0;             // Bytes from pos known to hold no newline
+        std::uint64_t line_number = 0;  // Physical lines taken so far
+        bool ready = false;             // A data line [line_begin, +line_size) is waiting
+        size_t line_begin = 0;
+        size_t line_size = 0;
+        std::uint64_t ready_line_number = 0;  // Physical line number of the waiting line
+    };
+
+    /** Discard options that make no sense without files; render nothing without a stream */
+    static NumericDiffOptions streaming_options(const NumericDiffOptions& opts, bool render);
+
+    void feed(Side& side, std::string_view bytes);
+    void feed_line(Side& side, std::string_view line);
+
+    /** Make the next non-comment line of side ready; at_end: take an unterminated tail */
+    bool fetch(Side& side, bool at_end);
+
+    /** Compare ready line pairs while both sides have one */
+    void pump(bool at_end);
+
+    /** Compare the pair of ready lines (a missing side compares as an empty line) */
+    void compare_ready(std::string_view line1, std::string_view line2);
+
+    /** Drop consumed bytes once they dominate the buffer */
+    static void compact(Side& side);
+
+    OutputBuffer discard_;       // Sink of the internal printer when nothing is rendered
+    NumericDiff diff_;           // Comparison engine (kernel, rendering, statistics)
+    DiffCallback on_diff_;       // Per-value difference callback (may be empty)
+    NumericDiffResult result_;   // Running result
+    Side side1_, side2_;         // Buffered inputs
+    bool stopped_ = false;       // --first-diff reached
+    bool finished_ = false;      // finish() was called
+
+    static constexpr size_t compact_bytes = 1 << 16;  // Minimum consumed prefix worth moving
+};
+
+}  // namespace numdiff
@@ -12,10 +12,13 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "ColumnSelection.hpp"
+
 /**
  * Static utility class for text parsing operations
  * 
@@ -30,18 +33,40 @@
  */
 class TextParser {
    public:
-    TextParser() = delete;  // No instances allowed  // No instances allowed
+    TextParser() = delete;  // No instances allowed
 
     /**
      * Split a line into whitespace-separated tokens
      * 
-     * Uses standard C++ stream tokenization (operator>>).
+     * Splits on the same whitespace characters as stream extraction
+     * (space, \t, \n, \v, \f, \r).
      * Consecutive whitespace is treated as a single separator.
      * Leading and trailing whitespace is ignored.
      * 
      * Example: "  1.23   4.56  " -> {"1.23", "4.56"}
      */
-    static std::vector<std::string> tokenize(const std::string& line);
+    static std::vector<std::string> tokenize(std::string_view line);
+
+    /**
+     * Split a line into whitespace-separated tokens without allocating
+     * 
+     * Same splitting rules as tokenize(), but the tokens are views into
+     * `line` written to a caller-owned vector. The vector is cleared first
+     * and its capacity is reused, so once it has grown to the widest line
+     * no further allocation takes place.
+     */
+    static void tokenize(std::string_view line, std::vector<std::string_view>& tokens);
+
+    /**
+     * Tokenize keeping only the selected columns
+     * 
+     * Same splitting rules as tokenize(), but only tokens whose 0-based
+     * index is in `selection` are written to `tokens`; the others are
+     * stepped over without being emitted. Returns the total number of
+     * tokens on the line, so column counts can still be checked.
+     */
+    static size_t tokenize_selected(std::string_view line, const ColumnSelection& selection,
+                                    std::vector<std::string_view>& tokens);
     
     /**
      * Check if a line is a comment line
@@ -55,9 +80,21 @@ class TextParser {
      *   line = "  # This is a comment", prefix = "#" -> true
      *   line = "123 # inline comment", prefix = "#" -> false
      */
-    static bool line_is_comment(const std::string& line, std::string_view prefix);
+    static bool line_is_comment(std::string_view line, std::string_view prefix);
     
     
     /**  Check if a string represents a valid numeric value */
-    static bool string_is_numeric(const std::string& str);
+    static bool string_is_numeric(std::string_view str);
+
+    /**
+     * Parse a token as a number in a single pass
+     * 
+     * Returns the value if the whole token is a valid number, std::nullopt
+     * otherwise (including values out of double range). Locale-independent
+     * and never throws, so it is safe to use on the hot comparison loop
+     * instead of string_is_numeric() followed by std::stod().
+     * 
+     * Example: "1.5e-3" -> 0.0015, "1.5D-03" -> 0.0015, "12abc" -> nullopt
+     */
+    static std::optional<double> try_parse_number(std::string_view str) noexcept;
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+// ThreadPool.hpp
+// -------------------------------------------------------------
+// Work-stealing worker pool for diff-numerics
+//
+// Runs independent tasks (e.g. chunks of a large comparison, or whole
+// file pairs in batch mode) on a fixed set of worker threads. Tasks
+// submitted from outside the pool are queued in FIFO order; tasks
+// submitted by a running task go to that worker's own deque, where idle
+// workers can steal them. Each submit returns a std::future that
+// reports completion or the task's exception.
+// -------------------------------------------------------------
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads with work stealing
+ *
+ * A worker runs its own newest task first, then steals the oldest task
+ * of another worker, and only then starts a new task from the shared
+ * queue, so work that was split into subtasks finishes before new work
+ * is taken up. A task may wait for its subtasks with wait(), which runs
+ * queued subtasks instead of blocking the worker.
+ *
+ * The destructor drains all queues and joins all workers, so every task
+ * submitted before destruction runs to completion.
+ */
+class ThreadPool {
+   public:
+    /** Start n_threads workers (at least one) */
+    explicit ThreadPool(size_t n_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Number of worker threads */
+    size_t size() const noexcept { return workers_.size(); }
+
+    /**
+     * Queue a task for execution on a worker
+     * Returns a future that becomes ready when the task finishes and
+     * rethrows anything the task threw from get().
+     */
+    template <class F>
+    std::future<void> submit(F&& task) {
+        auto packaged = std::make_shared<std::packaged_task<void()>>(std::forward<F>(task));
+        std::future<void> done = packaged->get_future();
+        enqueue([packaged] { (*packaged)(); });
+        return done;
+    }
+
+    /**
+     * Block until done is ready
+     * Called from one of this pool's workers, runs subtasks (own or
+     * stolen) while waiting, so tasks can wait for the tasks they
+     * submitted without deadlocking the pool.
+     */
+    void wait(const std::future<void>& done);
+
+    /** Number of worker threads to use when the user asks for "all" (0) */
+    static size_t hardware_threads() noexcept;
+
+   private:
+    /** Push a type-erased task: on the caller's deque if it is a worker, else the shared queue */
+    void enqueue(std::function<void()> task);
+
+    /** Worker loop: pop and run tasks until stopped and drained */
+    void worker_loop(size_t index);
+
+    /** Take the next task for worker self (lock held); shared: also the shared queue */
+    bool pop_task(size_t self, bool shared, std::function<void()>& task);
+
+    /** Run a task, then wake the workers waiting in wait() */
+    void run_task(std::function<void()>& task);
+
+    /** Index of the calling thread among this pool's workers, or size() */
+    size_t current_worker() const noexcept;
+
+    std::vector<std::thread> workers_;                      // Worker threads
+    std::vector<std::deque<std::function<void()>>> local_;  // Per-worker subtasks (LIFO owner)
+    std::deque<std::function<void()>> tasks_;               // Tasks from outside (FIFO)
+    std::mutex mutex_;             // Guards the queues, counters and stopping_
+    std::condition_variable cv_;   // Signals new tasks, finished tasks or shutdown
+    size_t n_local_ = 0;           // Tasks in all local deques
+    size_t n_waiting_ = 0;         // Workers blocked in wait()
+    bool stopping_ = false;        // Set by the destructor
+};
@@ -0,0 +1,78 @@
+// ToleranceKernel.hpp
+// -------------------------------------------------------------
+// Batch tolerance kernel for diff-numerics
+//
+// Provides static methods to apply the tolerance/threshold semantics of
+// NumericDiff to whole blocks of parsed numbers:
+// - Scalar percentage difference (the reference semantics)
+// - Block kernel computing per-element differences, a difference mask
+//   and the running maximum, with AVX-512, AVX2 and NEON paths
+// - Runtime selection of the widest instruction set the CPU supports
+// -------------------------------------------------------------
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Static utility class for tolerance checks over blocks of values
+ *
+ * All paths produce bit-identical results: the vector code performs the
+ * same IEEE operations in the same order as the scalar reference, and
+ * NaN inputs compare as "not different" exactly like the scalar code.
+ * This class cannot be instantiated (deleted default constructor).
+ */
+class ToleranceKernel {
+   public:
+    ToleranceKernel() = delete;  // No instances allowed
+
+    /** Value reported for an "infinite" percentage difference */
+    static constexpr double big = 1.0E99;
+
+    /** Summary of one block */
+    struct BlockResult {
+        size_t n_different = 0;  // Elements whose difference exceeds tolerance
+        double max_diff = 0.0;   // Largest difference among those elements
+    };
+
+    /**
+     * Percentage difference between two values (scalar reference)
+     *
+     * Handles special cases:
+     * - Both below threshold: returns 0 (no difference)
+     * - One below threshold, other not: returns big (infinite difference)
+     * - Otherwise: |v1-v2| / max(|v1|,|v2|) * 100, or 0 if below tolerance
+     */
+    static inline double percentage_difference(double value1, double value2, double tolerance,
+                                               double threshold) noexcept {
+        double abs1 = std::abs(value1);
+        double abs2 = std::abs(value2);
+        if (abs1 < threshold && abs2 < threshold) return 0.0;
+        if ((abs1 < threshold && abs2 >= threshold) || (abs2 < threshold && abs1 >= threshold))
+            return big;
+        double percentage_diff = std::abs(value1 - value2) / std::max(abs1, abs2) * 100.0;
+        return percentage_diff < tolerance ? 0.0 : percentage_diff;
+    }
+
+    /**
+     * Compare two blocks of n values element by element
+     *
+     * Writes the percentage difference of each pair to diff_out[i] and
+     * 1 to mask_out[i] if it exceeds tolerance (0 otherwise). Either
+     * output may be null if not needed. Dispatches to the widest
+     * instruction set available at runtime.
+     */
+    static BlockResult compare_block(const double* values1, const double* values2, size_t n,
+                                     double tolerance, double threshold, double* diff_out,
+                                     std::uint8_t* mask_out) noexcept;
+
+    /** Portable scalar implementation of compare_block (reference for tests) */
+    static BlockResult compare_block_scalar(const double* values1, const double* values2,
+                                            size_t n, double tolerance, double threshold,
+                                            double* diff_out, std::uint8_t* mask_out) noexcept;
+
+    /** Name of the implementation selected at runtime: "avx512", "avx2", "neon" or "scalar" */
+    static const char* active_isa() noexcept;
+};
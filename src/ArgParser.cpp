@@ -11,9 +11,15 @@
 #include <iostream>
 #include <sstream>
 
+#include "LineSource.hpp"
+#include "ReferenceCache.hpp"
+#include "ThreadPool.hpp"
+
 // Define the static usage/help text
 const std::string ArgParser::usage =
-    "Usage: diff-numerics [options] file1 file2\n"
+    "Usage: diff-numerics [options] file1 file2   (either file can be - for standard input)\n"
+    "       diff-numerics [options] --batch manifest\n"
+    "       diff-numerics [options] dir1 dir2   (files paired by relative path)\n"
     "Options:\n"
     "  -y,  --side-by-side             Show files side by side (default: off)\n"
     "  -ys, --suppress-common-lines    Suppress lines that are the same (implies side-by-side, "
@@ -27,6 +33,37 @@ const std::string ArgParser::usage =
     "  -d,  --color-different-digits   Color differing digits (default: off)\n"
     "  -C,  --columns <list>           Compare only specified columns (comma-separated, 1-based, "
     "default: all)\n"
+    "  -j,  --threads <n>              Compare large files with n worker threads (0 = all cores, "
+    "default: 1)\n"
+    "  -F,  --first-diff               Stop at the first difference beyond tolerance (default: "
+    "off)\n"
+    "  -f,  --format <fmt>             Input format: auto, text, npy, f64, f32, hdf5 (default: "
+    "auto)\n"
+    "       --shape [<rows>,]<cols>    Shape of raw f64/f32 inputs\n"
+    "       --dataset <name>           Dataset to compare in HDF5 inputs\n"
+    "       --stats[=text|json]        Print per-stage timings and counters to stderr (default: "
+    "off)\n"
+    "       --column-stats[=text|json] Print per-column error statistics and histograms to stderr\n"
+    "       --cache[=<path>]           Reuse parsed file1 from a sidecar cache (default: off, "
+    "path: file1.dncache)\n"
+    "       --resync[=<n>]             Realign inserted/deleted lines within n lines (default: "
+    "off, n: 32)\n"
+    "       --key <col>                Match lines by this column when resyncing (implies "
+    "--resync)\n"
+    "       --join <list>              Pair rows in any order by these key columns (comma-"
+    "separated, 1-based)\n"
+    "       --key-tolerance <abs>      Absolute tolerance of numeric keys (default: 0 = exact)\n"
+    "       --join-memory <MiB>        Index memory before --join partitions on disk (default: "
+    "1024)\n"
+    "       --prefetch <MiB>           Read ahead this much of each input asynchronously (0 = off, "
+    "default: 16)\n"
+    "       --fixed-width[=<n>]        Learn column offsets from the first n lines, then slice "
+    "fields (n: 16)\n"
+    "       --top <K>                  Report only the K largest value errors, worst first\n"
+    "       --records=jsonl|binary     Write only the differing values, as JSONL or packed "
+    "records\n"
+    "       --sample <n>               Estimate the difference rate from n random line pairs\n"
+    "       --batch <manifest>         Compare every \"file1 file2 [options]\" line of manifest\n"
     "  -v,  --version                  Show program version and exit\n"
     "  -h,  --help                     Show this help message\n";
 
@@ -64,6 +101,38 @@ void ArgParser::parse_columns(const std::string& col_arg, std::set<size_t>& colu
     }
 }
 
+/**
+ * Parse an input format name ("auto", "text", "npy", "f64", "f32", "hdf5")
+ * Throws runtime_error for unknown names
+ */
+InputFormat ArgParser::parse_format(const std::string& name) {
+    for (InputFormat format : {InputFormat::automatic, InputFormat::text, InputFormat::npy,
+                               InputFormat::raw_f64, InputFormat::raw_f32, InputFormat::hdf5}) {
+        if (name == ArraySource::format_name(format)) return format;
+    }
+    throw std::runtime_error("Error: Unknown input format: " + name +
+                             " (expected auto, text, npy, f64, f32 or hdf5).");
+}
+
+/**
+ * Parse a raw array shape: "<cols>" or "<rows>,<cols>"
+ * Throws runtime_error unless it has one or two positive dimensions
+ */
+std::vector<size_t> ArgParser::parse_shape(const std::string& shape_arg) {
+    std::stringstream ss(shape_arg);
+    std::string dim;
+    std::vector<size_t> shape;
+    while (std::getline(ss, dim, ',')) {
+        size_t n = std::stoul(dim);
+        if (n < 1) throw std::runtime_error("Error: Shape dimensions must be at least 1.");
+        shape.push_back(n);
+    }
+    if (shape.empty() || shape.size() > 2)
+        throw std::runtime_error("Error: Shape must be <cols> or <rows>,<cols> (got " + shape_arg +
+                                 ").");
+    return shape;
+}
+
 /**
  * Main argument parsing function
  * 
@@ -83,6 +152,7 @@ void ArgParser::parse_columns(const std::string& col_arg, std::set<size_t>& colu
  */
 numdiff::NumericDiffOptions ArgParser::parse_args(int argc, char* argv[]) {
     numdiff::NumericDiffOptions o;  // Default-initialized options  // Default-initialized options
+    bool default_cache = false;     // --cache without a path: file1 is not known yet
     
     // Iterate through all command-line arguments
     for (int i = 1; i < argc; ++i) {
@@ -154,6 +224,164 @@ numdiff::NumericDiffOptions ArgParser::parse_args(int argc, char* argv[]) {
                 throw std::runtime_error("Error: Missing value for " + arg + " option.");
             }
         }
+        // Worker threads for the chunked parallel engine (0 = all hardware threads)
+        else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 0 || n > max_threads)
+                    throw std::runtime_error("Error: Thread count (" + std::to_string(n) +
+                                             ") must be between 0 and " +
+                                             std::to_string(max_threads) + ".");
+                o.threads = (n == 0) ? ThreadPool::hardware_threads() : static_cast<size_t>(n);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Fail fast: stop at the first out-of-tolerance difference
+        else if (arg == "-F" || arg == "--first-diff" || arg == "--fail-fast") {
+            o.first_diff = true;
+        }
+        // Input encoding (binary arrays are compared without text parsing)
+        else if (arg == "-f" || arg == "--format") {
+            if (i + 1 < argc) {
+                o.input_format = ArgParser::parse_format(argv[++i]);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Declared shape of raw binary inputs
+        else if (arg == "--shape") {
+            if (i + 1 < argc) {
+                o.shape = ArgParser::parse_shape(argv[++i]);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Dataset inside HDF5 inputs
+        else if (arg == "--dataset") {
+            if (i + 1 < argc) {
+                o.dataset = argv[++i];
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Per-stage timings and counters on stderr
+        else if (arg == "--stats" || arg == "--stats=text") {
+            o.stats = numdiff::StatsFormat::text;
+        } else if (arg == "--stats=json") {
+            o.stats = numdiff::StatsFormat::json;
+        }
+        // Per-column error statistics on stderr
+        else if (arg == "--column-stats" || arg == "--column-stats=text") {
+            o.column_stats = numdiff::StatsFormat::text;
+        } else if (arg == "--column-stats=json") {
+            o.column_stats = numdiff::StatsFormat::json;
+        }
+        // Parsed sidecar cache of file1: next to it, or at an explicit path
+        else if (arg == "--cache") {
+            default_cache = true;
+        } else if (arg.rfind("--cache=", 0) == 0 && arg.size() > 8) {
+            o.reference_cache = arg.substr(8);
+        }
+        // Realignment of inserted/deleted lines, optionally keyed on one column
+        else if (arg == "--resync") {
+            o.resync_window = default_resync_window;
+        } else if (arg.rfind("--resync=", 0) == 0) {
+            long n = std::stol(arg.substr(9));
+            if (n < 1 || n > max_resync_window)
+                throw std::runtime_error("Error: Resync window (" + std::to_string(n) +
+                                         ") must be between 1 and " +
+                                         std::to_string(max_resync_window) + ".");
+            o.resync_window = static_cast<size_t>(n);
+        } else if (arg == "--fixed-width") {
+            o.fixed_width_lines = FixedWidthLayout::default_learn_lines;
+        } else if (arg.rfind("--fixed-width=", 0) == 0) {
+            long n = std::stol(arg.substr(14));
+            if (n < 1 || n > max_fixed_width_lines)
+                throw std::runtime_error("Error: Fixed-width learning lines (" + std::to_string(n) +
+                                         ") must be between 1 and " +
+                                         std::to_string(max_fixed_width_lines) + ".");
+            o.fixed_width_lines = static_cast<size_t>(n);
+        }
+        // Differing values as machine-readable records instead of the text output
+        else if (arg == "--records=jsonl") {
+            o.records = numdiff::RecordFormat::jsonl;
+        } else if (arg == "--records=binary") {
+            o.records = numdiff::RecordFormat::binary;
+        }
+        // Bounded report of the worst differences instead of the line-by-line output
+        else if (arg == "--top") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 1 || n > max_top)
+                    throw std::runtime_error("Error: Top report size (" + std::to_string(n) +
+                                             ") must be between 1 and " +
+                                             std::to_string(max_top) + ".");
+                o.top_k = static_cast<size_t>(n);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Approximate answer from a random subset of the line pairs
+        else if (arg == "--sample") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 1 || n > max_sample)
+                    throw std::runtime_error("Error: Sample size (" + std::to_string(n) +
+                                             ") must be between 1 and " +
+                                             std::to_string(max_sample) + ".");
+                o.sample_lines = static_cast<std::uint64_t>(n);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        } else if (arg == "--key") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 1)
+                    throw std::runtime_error("Error: Key column must be at least 1 (got " +
+                                             std::to_string(n) + ").");
+                o.key_column = static_cast<size_t>(n);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
+        // Unordered rows paired by key columns
+        else if (arg == "--join") {
+            if (i + 1 < argc) {
+                ArgParser::parse_columns(argv[++i], o.join_columns);
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        } else if (arg == "--key-tolerance") {
+            if (i + 1 < argc) {
+                o.key_tolerance = std::stod(argv[++i]);
+                if (!(o.key_tolerance >= 0.0))
+                    throw std::runtime_error("Error: Key tolerance must not be negative.");
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        } else if (arg == "--join-memory") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 1)
+                    throw std::runtime_error("Error: Join memory must be at least 1 MiB (got " +
+                                             std::to_string(n) + ").");
+                o.join_memory = static_cast<std::uint64_t>(n) << 20;
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        } else if (arg == "--prefetch") {
+            if (i + 1 < argc) {
+                long n = std::stol(argv[++i]);
+                if (n < 0 || n > max_prefetch_mib)
+                    throw std::runtime_error("Error: Prefetch must be between 0 and " +
+                                             std::to_string(max_prefetch_mib) + " MiB (got " +
+                                             std::to_string(n) + ").");
+                o.prefetch_bytes = static_cast<size_t>(n) << 20;
+            } else {
+                throw std::runtime_error("Error: Missing value for " + arg + " option.");
+            }
+        }
         // First non-option argument: file1
         else if (o.file1.empty()) {
             o.file1 = arg;
@@ -168,6 +396,10 @@ numdiff::NumericDiffOptions ArgParser::parse_args(int argc, char* argv[]) {
         }
     }
     
+    if (default_cache && !o.file1.empty() && !LineSource::is_stdin(o.file1))
+        o.reference_cache = ReferenceCache::default_path(o.file1);
+    if (o.key_column > 0 && o.resync_window == 0) o.resync_window = default_resync_window;
+
     // Validate all options before returning
     validate_options(o);
     return o;
@@ -178,10 +410,13 @@ numdiff::NumericDiffOptions ArgParser::parse_args(int argc, char* argv[]) {
  * 
  * Checks:
  * - Both file paths are specified
- * - File paths are different
+ * - File paths are different, at most one of them standard input ("-"),
+ *   which is read as text
  * - Column width is within valid range [10, 200]
  * - Tolerance is within valid range [1e-15, 1e+3]
  * - Threshold is within valid range [0, 1e+3]
+ * - Raw binary formats come with a declared shape
+ * - --sample pairs the lines of two text files, in memory
  * 
  * Throws runtime_error with descriptive message if validation fails
  */
@@ -190,6 +425,14 @@ void ArgParser::validate_options(const numdiff::NumericDiffOptions& o) {
     if (o.file1.empty() || o.file2.empty())
         throw std::runtime_error("Error: Two input files must be specified.");
 
+    // Standard input is a single stream of text
+    bool from_stdin = LineSource::is_stdin(o.file1) || LineSource::is_stdin(o.file2);
+    if (LineSource::is_stdin(o.file1) && LineSource::is_stdin(o.file2))
+        throw std::runtime_error("Error: Only one input can be read from standard input (-).");
+    if (from_stdin && o.input_format != InputFormat::automatic &&
+        o.input_format != InputFormat::text)
+        throw std::runtime_error("Error: Standard input (-) can only be read as text.");
+
     // Files must be different (comparing a file to itself is not useful)
     if (o.file1 == o.file2)
         throw std::runtime_error("Error: The two input files must be different.");
@@ -206,6 +449,25 @@ void ArgParser::validate_options(const numdiff::NumericDiffOptions& o) {
                                  ") must be between " + std::to_string(min_tol) + " and " +
                                  std::to_string(max_tol) + ".");
 
+    // Raw binary inputs carry no header, so their shape must be declared
+    bool raw = o.input_format == InputFormat::raw_f64 || o.input_format == InputFormat::raw_f32;
+    if (raw && o.shape.empty())
+        throw std::runtime_error("Error: --format " +
+                                 std::string(ArraySource::format_name(o.input_format)) +
+                                 " requires --shape.");
+
+    // Sampled lines are located in mapped text files, paired by position
+    if (o.sample_lines > 0) {
+        if (from_stdin)
+            throw std::runtime_error("Error: --sample cannot read standard input (-).");
+        if (o.resync_window > 0 || !o.join_columns.empty() || !o.reference_cache.empty() ||
+            o.top_k > 0)
+            throw std::runtime_error("Error: --sample cannot be combined with --resync, --key, "
+                                     "--join, --cache or --top.");
+        if (o.input_format != InputFormat::automatic && o.input_format != InputFormat::text)
+            throw std::runtime_error("Error: --sample compares text inputs only.");
+    }
+
     // Validate threshold: non-negative, reasonable upper bound
     if (o.threshold < min_threshold || o.threshold > max_threshold)
         throw std::runtime_error("Error: Threshold (" + std::to_string(o.threshold) +
@@ -220,4 +482,17 @@ void ArgParser::validate_options(const numdiff::NumericDiffOptions& o) {
  */
 numdiff::NumericDiffOptions ArgParser::parse(int argc, char* argv[]) {
     return parse_args(argc, argv);
+}
+
+// Same rules as the command line: build an argv and reuse parse_args
+numdiff::NumericDiffOptions ArgParser::parse(const std::vector<std::string>& args) {
+    std::vector<std::string> storage;
+    storage.reserve(args.size() + 1);
+    storage.emplace_back("diff-numerics");
+    storage.insert(storage.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    argv.reserve(storage.size() + 1);
+    for (std::string& arg : storage) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+    return parse_args(static_cast<int>(storage.size()), argv.data());
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+// ArraySource.cpp
+// -------------------------------------------------------------
+// Implementation of the binary array inputs
+//
+// .npy and raw files are memory-mapped; elements are decoded on access
+// so that float32 data and foreign byte orders need no extra copy of
+// the file. HDF5 datasets are read into memory as native doubles.
+// -------------------------------------------------------------
+
+#include "ArraySource.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef DIFF_NUMERICS_WITH_HDF5
+#include <hdf5.h>
+#endif
+
+namespace {
+
+constexpr bool host_little_endian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+constexpr std::string_view npy_magic("\x93NUMPY", 6);
+constexpr std::string_view hdf5_magic("\x89HDF\r\n\x1a\n", 8);
+
+// Element size in bytes of raw and .npy formats
+size_t item_size(bool is_float32) {
+    return is_float32 ? sizeof(float) : sizeof(double);
+}
+
+// Text following `'key':` in a .npy header dictionary (empty if the key is missing)
+std::string_view npy_header_value(std::string_view header, std::string_view key) {
+    std::string quoted = "'" + std::string(key) + "'";
+    size_t pos = header.find(quoted);
+    if (pos == std::string_view::npos) return {};
+    pos = header.find(':', pos + quoted.size());
+    if (pos == std::string_view::npos) return {};
+    pos = header.find_first_not_of(' ', pos + 1);
+    return pos == std::string_view::npos ? std::string_view() : header.substr(pos);
+}
+
+}  // namespace
+
+// Release the mapping, if any
+ArraySource::~ArraySource() {
+    if (mapping_ != nullptr) ::munmap(mapping_, mapping_length_);
+}
+
+/**
+ * Identify a file by its first bytes
+ *
+ * Only regular files are inspected, so pipes are never consumed here;
+ * they are always treated as text.
+ */
+InputFormat ArraySource::detect(const std::string& path) {
+    // Only regular files are probed: opening a FIFO would wait for its writer, and closing it
+    // again could hand the writer a broken pipe
+    struct stat st {};
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return InputFormat::text;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return InputFormat::text;  // Reported by the text backend
+
+    char magic[8] = {};
+    ssize_t n = ::read(fd, magic, sizeof(magic));
+    ::close(fd);
+
+    std::string_view head(magic, n > 0 ? static_cast<size_t>(n) : 0);
+    if (head.substr(0, npy_magic.size()) == npy_magic) return InputFormat::npy;
+    if (head == hdf5_magic) return InputFormat::hdf5;
+    return InputFormat::text;
+}
+
+// Names used in messages and accepted by --format
+const char* ArraySource::format_name(InputFormat format) noexcept {
+    switch (format) {
+        case InputFormat::automatic: return "auto";
+        case InputFormat::text: return "text";
+        case InputFormat::npy: return "npy";
+        case InputFormat::raw_f64: return "f64";
+        case InputFormat::raw_f32: return "f32";
+        case InputFormat::hdf5: return "hdf5";
+    }
+    return "unknown";
+}
+
+/**
+ * Open a binary array with the given encoding
+ *
+ * Validates the layout up front (header, declared shape against file
+ * size), so element access never reads outside the file.
+ */
+std::unique_ptr<ArraySource> ArraySource::open(const std::string& path, InputFormat format,
+                                               const std::vector<size_t>& shape,
+                                               const std::string& dataset) {
+    std::unique_ptr<ArraySource> array(new ArraySource());
+    switch (format) {
+        case InputFormat::npy:
+            array->map_file(path);
+            array->parse_npy(path);
+            break;
+        case InputFormat::raw_f64:
+        case InputFormat::raw_f32:
+            array->map_file(path);
+            array->dtype_ = format == InputFormat::raw_f32 ? DType::float32 : DType::float64;
+            array->swap_bytes_ = !host_little_endian;
+            array->data_ = static_cast<const unsigned char*>(array->mapping_);
+            array->apply_raw_shape(path, shape);
+            break;
+        case InputFormat::hdf5:
+            array->load_hdf5(path, dataset);
+            break;
+        default:
+            throw std::runtime_error(std::string("Error: not a binary input format: ") +
+                                     format_name(format));
+    }
+    return array;
+}
+
+// Map the whole file read-only; empty files stay unmapped
+void ArraySource::map_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Error: could not open file: " + path);
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("Error: binary input must be a regular file: " + path);
+    }
+    mapping_length_ = static_cast<size_t>(st.st_size);
+    if (mapping_length_ > 0) {
+        void* mapping = ::mmap(nullptr, mapping_length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Error: could not read file: " + path);
+        }
+        ::madvise(mapping, mapping_length_, MADV_SEQUENTIAL);
+        mapping_ = mapping;
+    }
+    ::close(fd);
+}
+
+/**
+ * Parse a .npy header (format versions 1.0, 2.0 and 3.0)
+ *
+ * The header is a Python dict literal with 'descr', 'fortran_order' and
+ * 'shape'. Only floating-point descriptors '<f8', '>f8', '<f4', '>f4'
+ * (and '=' for native order) are accepted.
+ */
+void ArraySource::parse_npy(const std::string& path) {
+    std::string_view file(static_cast<const char*>(mapping_), mapping_length_);
+    auto malformed = [&path](const std::string& what) {
+        return std::runtime_error("Error: malformed .npy file (" + what + "): " + path);
+    };
+    if (file.size() < 10 || file.substr(0, npy_magic.size()) != npy_magic)
+        throw malformed("bad magic");
+
+    // Header length: 2 bytes in version 1, 4 bytes in versions 2 and 3 (little-endian)
+    auto byte = [&file](size_t i) {
+        return static_cast<size_t>(static_cast<unsigned char>(file[i]));
+    };
+    unsigned major = static_cast<unsigned>(byte(6));
+    size_t header_start = major == 1 ? 10 : 12;
+    if (file.size() < header_start) throw malformed("truncated header");
+    size_t header_len = major == 1 ? byte(8) | byte(9) << 8
+                                   : byte(8) | byte(9) << 8 | byte(10) << 16 | byte(11) << 24;
+    if (header_start + header_len > file.size()) throw malformed("truncated header");
+    std::string_view header = file.substr(header_start, header_len);
+
+    // Element type and byte order
+    std::string_view descr = npy_header_value(header, "descr");
+    if (descr.size() < 5 || descr[0] != '\'' || descr[4] != '\'') throw malformed("descr");
+    std::string_view type = descr.substr(2, 2);
+    if (type != "f8" && type != "f4")
+        throw std::runtime_error("Error: unsupported .npy dtype '" +
+                                 std::string(descr.substr(1, 3)) + "' (only float64/float32): " +
+                                 path);
+    dtype_ = type == "f4" ? DType::float32 : DType::float64;
+    char order = descr[1];
+    if (order != '<' && order != '>' && order != '=') throw malformed("byte order");
+    swap_bytes_ = (order == '<' && !host_little_endian) || (order == '>' && host_little_endian);
+
+    fortran_order_ = npy_header_value(header, "fortran_order").substr(0, 4) == "True";
+
+    // Shape tuple: (), (n,), (rows, cols) or more dimensions
+    std::string_view shape = npy_header_value(header, "shape");
+    size_t close = shape.find(')');
+    if (shape.empty() || shape[0] != '(' || close == std::string_view::npos)
+        throw malformed("shape");
+    std::vector<size_t> dims;
+    std::string dims_text(shape.substr(1, close - 1));
+    for (const char* p = dims_text.c_str(); *p != '\0';) {
+        char* end = nullptr;
+        unsigned long long dim = std::strtoull(p, &end, 10);
+        if (end == p) {
+            ++p;  // Separator or whitespace
+            continue;
+        }
+        dims.push_back(static_cast<size_t>(dim));
+        p = end;
+    }
+    rows_ = dims.empty() ? 1 : dims[0];
+    cols_ = 1;
+    for (size_t k = 1; k < dims.size(); ++k) cols_ *= dims[k];
+    if (dims.size() > 2 && fortran_order_)
+        throw std::runtime_error("Error: Fortran-ordered .npy arrays with more than 2 dimensions "
+                                 "are not supported: " + path);
+
+    size_t data_offset = header_start + header_len;
+    if ((file.size() - data_offset) / item_size(dtype_ == DType::float32) < rows_ * cols_)
+        throw malformed("truncated data");
+    data_ = static_cast<const unsigned char*>(mapping_) + data_offset;
+}
+
+/**
+ * Derive the shape of a raw file
+ *
+ * {cols}: rows follow from the file size, which must hold whole rows.
+ * {rows, cols}: the file size must match exactly.
+ */
+void ArraySource::apply_raw_shape(const std::string& path, const std::vector<size_t>& shape) {
+    if (shape.empty() || shape.size() > 2 || shape.back() == 0)
+        throw std::runtime_error("Error: raw binary input requires --shape <cols> or "
+                                 "<rows>,<cols>: " + path);
+    size_t row_bytes = shape.back() * item_size(dtype_ == DType::float32);
+    if (mapping_length_ % row_bytes != 0)
+        throw std::runtime_error("Error: size of " + path + " (" + std::to_string(mapping_length_) +
+                                 " bytes) is not a multiple of the row size (" +
+                                 std::to_string(row_bytes) + " bytes).");
+    cols_ = shape.back();
+    rows_ = mapping_length_ / row_bytes;
+    if (shape.size() == 2 && shape[0] != rows_)
+        throw std::runtime_error("Error: " + path + " holds " + std::to_string(rows_) +
+                                 " rows, but --shape declares " + std::to_string(shape[0]) + ".");
+}
+
+/**
+ * Read an HDF5 dataset as native doubles
+ *
+ * The library converts any numeric element type on read. Datasets are
+ * shaped like .npy arrays (first dimension = rows).
+ */
+void ArraySource::load_hdf5(const std::string& path, const std::string& dataset) {
+#ifdef DIFF_NUMERICS_WITH_HDF5
+    if (dataset.empty())
+        throw std::runtime_error("Error: HDF5 input requires --dataset <name>: " + path);
+    H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);  // Errors are reported through exceptions
+
+    // Close HDF5 handles on every exit path
+    struct Handle {
+        hid_t id;
+        herr_t (*close)(hid_t);
+        ~Handle() {
+            if (id >= 0) close(id);
+        }
+    };
+    Handle file{H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT), H5Fclose};
+    if (file.id < 0) throw std::runtime_error("Error: could not open HDF5 file: " + path);
+    Handle data{H5Dopen2(file.id, dataset.c_str(), H5P_DEFAULT), H5Dclose};
+    if (data.id < 0)
+        throw std::runtime_error("Error: HDF5 dataset '" + dataset + "' not found in: " + path);
+    Handle space{H5Dget_space(data.id), H5Sclose};
+    int rank = H5Sget_simple_extent_ndims(space.id);
+    if (rank < 0) throw std::runtime_error("Error: could not read HDF5 dataset: " + dataset);
+
+    std::vector<hsize_t> dims(static_cast<size_t>(rank));
+    H5Sget_simple_extent_dims(space.id, dims.data(), nullptr);
+    rows_ = dims.empty() ? 1 : static_cast<size_t>(dims[0]);
+    cols_ = 1;
+    for (size_t k = 1; k < dims.size(); ++k) cols_ *= static_cast<size_t>(dims[k]);
+
+    storage_.resize(rows_ * cols_);
+    if (!storage_.empty() &&
+        H5Dread(data.id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, storage_.data()) < 0)
+        throw std::runtime_error("Error: could not read HDF5 dataset: " + dataset);
+    data_ = reinterpret_cast<const unsigned char*>(storage_.data());
+    dtype_ = DType::float64;
+#else
+    (void)dataset;
+    throw std::runtime_error("Error: this build of diff-numerics has no HDF5 support: " + path);
+#endif
+}
+
+// Direct access is possible for native-endian float64 in C order
+const double* ArraySource::native_row(size_t row) const noexcept {
+    if (dtype_ != DType::float64 || swap_bytes_ || fortran_order_ || data_ == nullptr)
+        return nullptr;
+    if (reinterpret_cast<std::uintptr_t>(data_) % alignof(double) != 0) return nullptr;
+    return reinterpret_cast<const double*>(data_) + row * cols_;
+}
+
+// Decode one element (memcpy keeps unaligned and foreign-endian access well-defined)
+double ArraySource::value(size_t row, size_t col) const noexcept {
+    size_t index = fortran_order_ ? col * rows_ + row : row * cols_ + col;
+    if (dtype_ == DType::float32) {
+        std::uint32_t bits;
+        std::memcpy(&bits, data_ + index * sizeof(bits), sizeof(bits));
+        if (swap_bytes_) bits = __builtin_bswap32(bits);
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return static_cast<double>(v);
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, data_ + index * sizeof(bits), sizeof(bits));
+    if (swap_bytes_) bits = __builtin_bswap64(bits);
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Gather the selected columns of a range of rows
+void ArraySource::read_rows(size_t first_row, size_t n_rows, const std::vector<size_t>& columns,
+                            double* out) const {
+    for (size_t r = first_row; r < first_row + n_rows; ++r) {
+        for (size_t c : columns) *out++ = value(r, c);
+    }
+}
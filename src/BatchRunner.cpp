@@ -0,0 +1,238 @@
+// BatchRunner.cpp
+// -------------------------------------------------------------
+// Implementation of batch mode (--batch)
+// -------------------------------------------------------------
+
+#include "BatchRunner.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <future>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "ArgParser.hpp"
+#include "OutputBuffer.hpp"
+#include "Printer.hpp"
+#include "TextParser.hpp"
+#include "ThreadPool.hpp"
+
+using numdiff::NumericDiff;
+using numdiff::NumericDiffOptions;
+
+/**
+ * Parse the manifest
+ *
+ * Lines are split on whitespace; blank lines and lines starting with #
+ * are skipped. Paths are used as written (relative to the working
+ * directory).
+ */
+std::vector<NumericDiffOptions> BatchRunner::read_manifest(
+    const std::string& path, const std::vector<std::string>& global_args) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Error: cannot open batch manifest " + path + ".");
+
+    std::vector<NumericDiffOptions> pairs;
+    std::vector<std::string_view> tokens;
+    std::string line;
+    for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+        if (TextParser::line_is_comment(line, "#")) continue;
+        TextParser::tokenize(line, tokens);
+        if (tokens.empty()) continue;
+
+        std::vector<std::string> args(global_args);
+        args.insert(args.end(), tokens.begin(), tokens.end());
+        try {
+            pairs.push_back(ArgParser::parse(args));
+        } catch (const std::exception& e) {
+            std::string_view message = e.what();
+            if (message.rfind("Error: ", 0) == 0) message.remove_prefix(7);
+            throw std::runtime_error("Error: " + path + ":" + std::to_string(line_number) + ": " +
+                                     std::string(message));
+        }
+    }
+    if (pairs.empty()) throw std::runtime_error("Error: batch manifest " + path + " is empty.");
+    return pairs;
+}
+
+/**
+ * Pair two directory trees
+ *
+ * Walks the first tree for regular files (following symlinks) and
+ * looks each relative path up in the second; a second walk finds the
+ * files missing from the first tree.
+ */
+DirectoryPairing BatchRunner::pair_directories(const NumericDiffOptions& options) {
+    namespace fs = std::filesystem;
+    auto relative_files = [](const std::string& root) {
+        std::vector<std::string> files;
+        std::error_code ec;
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied,
+                                            ec);
+        if (ec) throw std::runtime_error("Error: cannot read directory " + root + ".");
+        for (; it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) throw std::runtime_error("Error: cannot read directory " + root + ".");
+            if (it->is_regular_file()) {
+                files.push_back(it->path().lexically_relative(root).generic_string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    };
+    std::vector<std::string> files1 = relative_files(options.file1);
+    std::vector<std::string> files2 = relative_files(options.file2);
+
+    DirectoryPairing pairing;
+    std::set_difference(files1.begin(), files1.end(), files2.begin(), files2.end(),
+                        std::back_inserter(pairing.only_in1));
+    std::set_difference(files2.begin(), files2.end(), files1.begin(), files1.end(),
+                        std::back_inserter(pairing.only_in2));
+    std::vector<std::string> common;
+    std::set_intersection(files1.begin(), files1.end(), files2.begin(), files2.end(),
+                          std::back_inserter(common));
+    for (const std::string& relative : common) {
+        NumericDiffOptions pair = options;
+        pair.file1 = (fs::path(options.file1) / relative).string();
+        pair.file2 = (fs::path(options.file2) / relative).string();
+        pairing.pairs.push_back(std::move(pair));
+    }
+    return pairing;
+}
+
+/**
+ * Compare all pairs on one pool
+ *
+ * Tasks are queued by decreasing input size. A pair holding more than
+ * a worker's share of all input bytes runs the parallel engine on the
+ * shared pool. Outputs are collected in per-pair buffers and emitted in
+ * the order of pairs.
+ */
+std::vector<BatchOutcome> BatchRunner::run(const std::vector<NumericDiffOptions>& pairs,
+                                           std::ostream* os) const {
+    std::vector<BatchOutcome> outcomes(pairs.size());
+    std::vector<std::future<void>> done(pairs.size());
+
+    std::vector<std::uint64_t> sizes(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) sizes[i] = input_size(pairs[i]);
+    std::vector<size_t> order(pairs.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    {
+        ThreadPool pool(n_threads_);
+        std::uint64_t total = std::accumulate(sizes.begin(), sizes.end(), std::uint64_t{0});
+        std::uint64_t split_at = std::max<std::uint64_t>(split_min_bytes, total / pool.size());
+        for (size_t i : order) {
+            bool split = pool.size() > 1 && sizes[i] >= split_at;
+            done[i] = pool.submit([&pairs, &outcomes, &pool, i, split] {
+                BatchOutcome& outcome = outcomes[i];
+                NumericDiffOptions options = pairs[i];
+                options.threads = split ? pool.size() : 1;  // Otherwise pairs run side by side
+                OutputBuffer out;
+                try {
+                    NumericDiff diff(options, out);
+                    if (split) diff.set_pool(&pool);
+                    outcome.result = diff.run();
+                } catch (const std::exception& e) {
+                    outcome.failed = true;
+                    outcome.error = e.what();
+                }
+                outcome.output.assign(out.view());
+                if (options.sample_lines > 0 && !outcome.failed) {
+                    std::ostringstream report;
+                    Printer::print_sample(report, outcome.result, options);
+                    outcome.output += report.str();
+                }
+                if (options.top_k > 0 && !outcome.failed) {
+                    std::ostringstream report;
+                    Printer::print_top(report, outcome.result, options);
+                    outcome.output += report.str();
+                }
+            });
+        }
+
+        // Ordered output while later pairs are still running
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            done[i].get();
+            if (os == nullptr || outcomes[i].output.empty()) continue;
+            *os << "==> " << pairs[i].file1 << " <-> " << pairs[i].file2 << " <==\n"
+                << outcomes[i].output;
+            std::string().swap(outcomes[i].output);  // Printed: release the buffer
+        }
+    }
+    return outcomes;
+}
+
+/**
+ * Print the batch summary table
+ *
+ * Columns: pair index, status (EQUAL, DIFFER or ERROR), differing
+ * lines, maximum percentage error, first difference (--first-diff) and
+ * the two files. Errors are printed below the table.
+ */
+void BatchRunner::print_summary(std::ostream& os, const std::vector<NumericDiffOptions>& pairs,
+                                const std::vector<BatchOutcome>& outcomes) {
+    size_t n_differ = 0, n_failed = 0;
+    std::uint64_t total_lines = 0;
+    double max_err = 0.0;
+    std::ostringstream out;
+    out << "\nBatch summary\n"
+        << std::right << std::setw(5) << "#" << "  " << std::left << std::setw(7) << "Status"
+        << std::right << std::setw(12) << "Diff lines" << std::setw(14) << "Max error %"
+        << "  Files\n";
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const BatchOutcome& outcome = outcomes[i];
+        const numdiff::NumericDiffResult& r = outcome.result;
+        const char* status = outcome.failed ? "ERROR"
+                             : r.n_different_lines > 0 ? "DIFFER"
+                                                       : "EQUAL";
+        out << std::right << std::setw(5) << i + 1 << "  " << std::left << std::setw(7)
+            << status << std::right;
+        if (outcome.failed) {
+            out << std::setw(12) << "-" << std::setw(14) << "-";
+            n_failed++;
+        } else {
+            out << std::setw(12) << r.n_different_lines << std::setw(14) << r.max_percentage_err;
+            if (r.n_different_lines > 0) n_differ++;
+            total_lines += r.n_different_lines;
+            max_err = std::max(max_err, r.max_percentage_err);
+        }
+        out << "  " << pairs[i].file1 << " " << pairs[i].file2;
+        if (!outcome.failed && pairs[i].sample_lines > 0)
+            out << " (sampled " << r.sample.n_sampled << " of " << r.sample.population << ")";
+        if (!outcome.failed && r.first_diff.line1 > 0 && pairs[i].first_diff)
+            out << " (first at line " << r.first_diff.line1 << ", column "
+                << r.first_diff.column << ")";
+        out << "\n";
+    }
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (outcomes[i].failed) out << "  [" << i + 1 << "] " << outcomes[i].error << "\n";
+    }
+    out << "Pairs: " << pairs.size() << ", equal: " << pairs.size() - n_differ - n_failed
+        << ", differ: " << n_differ << ", errors: " << n_failed
+        << "; differing lines: " << total_lines << ", max percentage error: " << max_err
+        << "%\n";
+    os << out.str();
+}
+
+// Same wording as diff -r
+void BatchRunner::print_unpaired(std::ostream& os, const NumericDiffOptions& dirs,
+                                 const DirectoryPairing& pairing) {
+    for (const std::string& relative : pairing.only_in1)
+        os << "Only in " << dirs.file1 << ": " << relative << "\n";
+    for (const std::string& relative : pairing.only_in2)
+        os << "Only in " << dirs.file2 << ": " << relative << "\n";
+}
+
+// Missing files sort last; they fail quickly anyway
+std::uint64_t BatchRunner::input_size(const NumericDiffOptions& pair) {
+    std::error_code ec1, ec2;
+    std::uintmax_t size1 = std::filesystem::file_size(pair.file1, ec1);
+    std::uintmax_t size2 = std::filesystem::file_size(pair.file2, ec2);
+    return (ec1 ? 0 : size1) + (ec2 ? 0 : size2);
+}
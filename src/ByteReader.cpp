@@ -0,0 +1,340 @@
+// ByteReader.cpp
+// -------------------------------------------------------------
+// Implementation of the byte-stream readers
+//
+// Decompressors pull compressed bytes from the reader they wrap into a
+// fixed input buffer and inflate straight into the caller's buffer.
+// Concatenated gzip members and xz streams are decoded as one input.
+// -------------------------------------------------------------
+
+#include "ByteReader.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef DIFF_NUMERICS_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DIFF_NUMERICS_WITH_XZ
+#include <lzma.h>
+#endif
+#ifdef DIFF_NUMERICS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+constexpr size_t compressed_buffer_size = 1 << 16;  // Compressed bytes pulled per refill
+
+#ifdef DIFF_NUMERICS_WITH_ZLIB
+/** gzip (and zlib) stream decoder */
+class GzipReader : public ByteReader {
+   public:
+    GzipReader(std::unique_ptr<ByteReader> compressed, std::string name)
+        : compressed_(std::move(compressed)), name_(std::move(name)), in_(compressed_buffer_size) {
+        // 15 + 32: maximum window, detect gzip or zlib header automatically
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK)
+            throw std::runtime_error("Error: could not initialize gzip decoder for: " + name_);
+    }
+    ~GzipReader() override { inflateEnd(&stream_); }
+
+    size_t read(char* dst, size_t capacity) override {
+        stream_.next_out = reinterpret_cast<Bytef*>(dst);
+        stream_.avail_out = static_cast<uInt>(std::min<size_t>(capacity, UINT32_MAX));
+        uInt requested = stream_.avail_out;
+        while (stream_.avail_out > 0) {
+            if (stream_.avail_in == 0 && !input_done_) {
+                size_t n = compressed_->read(in_.data(), in_.size());
+                input_done_ = n == 0;
+                stream_.next_in = reinterpret_cast<Bytef*>(in_.data());
+                stream_.avail_in = static_cast<uInt>(n);
+            }
+            if (stream_.avail_in == 0 && input_done_) {
+                if (in_member_)
+                    throw std::runtime_error("Error: truncated gzip data in file: " + name_);
+                break;
+            }
+            in_member_ = true;
+            int ret = inflate(&stream_, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                in_member_ = false;
+                inflateReset(&stream_);  // Further members are part of the same input
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("Error: corrupt gzip data in file: " + name_);
+            }
+        }
+        return requested - stream_.avail_out;
+    }
+
+   private:
+    std::unique_ptr<ByteReader> compressed_;  // Source of compressed bytes
+    std::string name_;                        // Path used in error messages
+    std::vector<char> in_;                    // Compressed input buffer
+    z_stream stream_{};                       // zlib state
+    bool input_done_ = false;                 // Compressed input exhausted
+    bool in_member_ = false;                  // Inside a member that has not ended yet
+};
+#endif
+
+#ifdef DIFF_NUMERICS_WITH_XZ
+/** xz (and legacy .lzma) stream decoder */
+class XzReader : public ByteReader {
+   public:
+    XzReader(std::unique_ptr<ByteReader> compressed, std::string name)
+        : compressed_(std::move(compressed)), name_(std::move(name)), in_(compressed_buffer_size) {
+        if (lzma_auto_decoder(&stream_, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)
+            throw std::runtime_error("Error: could not initialize xz decoder for: " + name_);
+    }
+    ~XzReader() override { lzma_end(&stream_); }
+
+    size_t read(char* dst, size_t capacity) override {
+        stream_.next_out = reinterpret_cast<std::uint8_t*>(dst);
+        stream_.avail_out = capacity;
+        while (stream_.avail_out > 0 && !finished_) {
+            if (stream_.avail_in == 0 && !input_done_) {
+                size_t n = compressed_->read(in_.data(), in_.size());
+                input_done_ = n == 0;
+                stream_.next_in = reinterpret_cast<const std::uint8_t*>(in_.data());
+                stream_.avail_in = n;
+            }
+            lzma_ret ret = lzma_code(&stream_, input_done_ ? LZMA_FINISH : LZMA_RUN);
+            if (ret == LZMA_STREAM_END) {
+                finished_ = true;
+            } else if (ret == LZMA_BUF_ERROR && input_done_) {
+                throw std::runtime_error("Error: truncated xz data in file: " + name_);
+            } else if (ret != LZMA_OK && ret != LZMA_BUF_ERROR) {
+                throw std::runtime_error("Error: corrupt xz data in file: " + name_);
+            }
+        }
+        return capacity - stream_.avail_out;
+    }
+
+   private:
+    std::unique_ptr<ByteReader> compressed_;  // Source of compressed bytes
+    std::string name_;                        // Path used in error messages
+    std::vector<char> in_;                    // Compressed input buffer
+    lzma_stream stream_ = LZMA_STREAM_INIT;   // liblzma state
+    bool input_done_ = false;                 // Compressed input exhausted
+    bool finished_ = false;                   // Decoder reported end of stream
+};
+#endif
+
+#ifdef DIFF_NUMERICS_WITH_ZSTD
+/** zstd stream decoder (handles concatenated frames) */
+class ZstdReader : public ByteReader {
+   public:
+    ZstdReader(std::unique_ptr<ByteReader> compressed, std::string name)
+        : compressed_(std::move(compressed)),
+          name_(std::move(name)),
+          in_(ZSTD_DStreamInSize()),
+          stream_(ZSTD_createDStream()) {
+        if (stream_ == nullptr)
+            throw std::runtime_error("Error: could not initialize zstd decoder for: " + name_);
+    }
+    ~ZstdReader() override { ZSTD_freeDStream(stream_); }
+
+    size_t read(char* dst, size_t capacity) override {
+        ZSTD_outBuffer out{dst, capacity, 0};
+        while (out.pos < out.size) {
+            if (input_.pos == input_.size && !input_done_) {
+                size_t n = compressed_->read(in_.data(), in_.size());
+                input_done_ = n == 0;
+                input_ = ZSTD_inBuffer{in_.data(), n, 0};
+            }
+            if (input_.pos == input_.size && input_done_) {
+                if (in_frame_)
+                    throw std::runtime_error("Error: truncated zstd data in file: " + name_);
+                break;
+            }
+            size_t ret = ZSTD_decompressStream(stream_, &out, &input_);
+            if (ZSTD_isError(ret))
+                throw std::runtime_error("Error: corrupt zstd data in file: " + name_);
+            in_frame_ = ret != 0;  // 0: a frame was completely decoded and flushed
+        }
+        return out.pos;
+    }
+
+   private:
+    std::unique_ptr<ByteReader> compressed_;  // Source of compressed bytes
+    std::string name_;                        // Path used in error messages
+    std::vector<char> in_;                    // Compressed input buffer
+    ZSTD_inBuffer input_{nullptr, 0, 0};      // Unconsumed part of in_
+    ZSTD_DStream* stream_;                    // libzstd state
+    bool input_done_ = false;                 // Compressed input exhausted
+    bool in_frame_ = false;                   // Inside a frame that has not ended yet
+};
+#endif
+
+}  // namespace
+
+// Magic numbers: gzip 1f 8b, xz fd '7zXZ' 00, zstd 28 b5 2f fd
+Compression ByteReader::detect_compression(std::string_view head) noexcept {
+    if (head.substr(0, 2) == std::string_view("\x1f\x8b", 2)) return Compression::gzip;
+    if (head.substr(0, 6) == std::string_view("\xfd" "7zXZ\x00", 6)) return Compression::xz;
+    if (head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) return Compression::zstd;
+    return Compression::none;
+}
+
+// Names used in messages
+const char* ByteReader::compression_name(Compression compression) noexcept {
+    switch (compression) {
+        case Compression::none: return "uncompressed";
+        case Compression::gzip: return "gzip";
+        case Compression::xz: return "xz";
+        case Compression::zstd: return "zstd";
+    }
+    return "unknown";
+}
+
+// Pick the decoder for a format, if it was compiled in
+std::unique_ptr<ByteReader> ByteReader::decompress(Compression compression,
+                                                   std::unique_ptr<ByteReader> compressed,
+                                                   const std::string& name) {
+    switch (compression) {
+        case Compression::none:
+            return compressed;
+#ifdef DIFF_NUMERICS_WITH_ZLIB
+        case Compression::gzip:
+            return std::make_unique<GzipReader>(std::move(compressed), name);
+#endif
+#ifdef DIFF_NUMERICS_WITH_XZ
+        case Compression::xz:
+            return std::make_unique<XzReader>(std::move(compressed), name);
+#endif
+#ifdef DIFF_NUMERICS_WITH_ZSTD
+        case Compression::zstd:
+            return std::make_unique<ZstdReader>(std::move(compressed), name);
+#endif
+        default:
+            throw std::runtime_error(std::string("Error: ") + name + " is " +
+                                     compression_name(compression) +
+                                     "-compressed, but this build has no support for it.");
+    }
+}
+
+// Take over a descriptor
+FdReader::FdReader(int fd, std::string name, bool owns_fd)
+    : fd_(fd), name_(std::move(name)), owns_fd_(owns_fd) {}
+
+// Close the descriptor if we own it
+FdReader::~FdReader() {
+    if (owns_fd_ && fd_ >= 0) ::close(fd_);
+}
+
+// One read(2), retried on EINTR
+size_t FdReader::read(char* dst, size_t capacity) {
+    ssize_t n;
+    do {
+        n = ::read(fd_, dst, capacity);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) throw std::runtime_error("Error: could not read file: " + name_);
+    return static_cast<size_t>(n);
+}
+
+// Allocate the ring and start the worker
+// The head is drained first; a read never mixes it with bytes of the inner reader
+size_t ReplayReader::read(char* dst, size_t capacity) {
+    if (offset_ == head_.size()) return inner_->read(dst, capacity);
+    size_t n = std::min(capacity, head_.size() - offset_);
+    std::memcpy(dst, head_.data() + offset_, n);
+    offset_ += n;
+    return n;
+}
+
+PrefetchReader::PrefetchReader(std::unique_ptr<ByteReader> inner, size_t block_size, size_t depth)
+    : inner_(std::move(inner)), ring_(std::max<size_t>(depth, 1)) {
+    for (Block& block : ring_) block.data.resize(std::max<size_t>(block_size, 1));
+    worker_ = std::thread([this] { produce(); });
+}
+
+// Stop the worker once it finishes its current block
+PrefetchReader::~PrefetchReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    free_.notify_all();
+    worker_.join();
+}
+
+/**
+ * Worker loop
+ *
+ * Fills the next free block completely (short reads are retried, so
+ * blocks only come out partial at end of input), then publishes it.
+ * The block being filled is never visible to the consumer, so it is
+ * written without holding the lock.
+ */
+void PrefetchReader::produce() {
+    for (;;) {
+        Block* block;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            free_.wait(lock, [this] { return stopping_ || filled_ < ring_.size(); });
+            if (stopping_) return;
+            block = &ring_[(head_ + filled_) % ring_.size()];
+        }
+
+        size_t size = 0;
+        bool at_end = false;
+        try {
+            while (size < block->data.size()) {
+                size_t n = inner_->read(block->data.data() + size, block->data.size() - size);
+                if (n == 0) {
+                    at_end = true;
+                    break;
+                }
+                size += n;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            block->size = size;
+            if (size > 0) ++filled_;
+            error_ = std::current_exception();
+            ready_.notify_one();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        block->size = size;
+        if (size > 0) ++filled_;
+        eof_ = at_end;
+        ready_.notify_one();
+        if (at_end) return;
+    }
+}
+
+/**
+ * Copy bytes out of the oldest filled block
+ *
+ * The head block is owned by the consumer while filled_ > 0, so the
+ * copy runs outside the lock.
+ */
+size_t PrefetchReader::read(char* dst, size_t capacity) {
+    Block* block;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return filled_ > 0 || eof_ || error_; });
+        if (filled_ == 0) {
+            if (error_) std::rethrow_exception(error_);
+            return 0;  // End of input
+        }
+        block = &ring_[head_];
+    }
+
+    size_t n = std::min(capacity, block->size - offset_);
+    std::memcpy(dst, block->data.data() + offset_, n);
+    offset_ += n;
+    if (offset_ == block->size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = (head_ + 1) % ring_.size();
+        --filled_;
+        offset_ = 0;
+        free_.notify_one();
+    }
+    return n;
+}
@@ -0,0 +1,87 @@
+// ColumnErrorStats.cpp
+// -------------------------------------------------------------
+// Implementation of the --column-stats accumulators
+// -------------------------------------------------------------
+
+#include "ColumnErrorStats.hpp"
+
+#include <algorithm>
+
+namespace numdiff {
+
+namespace {
+// Upper edges (%) of the histogram bins but the last: 1e-14, 1e-13, ..., 100
+constexpr std::array<double, ColumnErrorStats::n_bins - 1> bin_edges = {
+    1e-14, 1e-13, 1e-12, 1e-11, 1e-10, 1e-9, 1e-8, 1e-7, 1e-6,
+    1e-5,  1e-4,  1e-3,  1e-2,  1e-1,  1.0,  10.0, 100.0,
+};
+
+// A mean of squares relative to scale, made relative to a larger scale top
+double rescale_squares(double scaled_squares, double scale, double top) noexcept {
+    if (top <= 0.0) return 0.0;
+    double ratio = scale / top;
+    return scaled_squares * ratio * ratio;
+}
+}  // namespace
+
+double ColumnErrorStats::bin_lower_edge(size_t k) noexcept {
+    return k == 0 ? 0.0 : bin_edges[k - 1];
+}
+
+size_t ColumnErrorStats::bin(double rel) noexcept {
+    return static_cast<size_t>(std::upper_bound(bin_edges.begin(), bin_edges.end(), rel) -
+                               bin_edges.begin());
+}
+
+// Running means: mean += (x - mean) / n stays within the range of the errors
+void ColumnErrorStats::add(double value1, double value2, bool is_different) noexcept {
+    if (is_different) different++;  // Whether or not the error is finite, as in the diff
+    double abs_err = std::abs(value1 - value2);
+    if (!std::isfinite(abs_err)) {
+        nonfinite++;
+        return;
+    }
+    double scale = std::max(std::abs(value1), std::abs(value2));
+    double rel_err = scale > 0.0 ? abs_err / scale * 100.0 : 0.0;
+
+    pairs++;
+    double weight = 1.0 / static_cast<double>(pairs);
+    if (abs_err > max_abs) {
+        scaled_square_abs = rescale_squares(scaled_square_abs, max_abs, abs_err);
+        max_abs = abs_err;
+    }
+    double scaled = max_abs > 0.0 ? abs_err / max_abs : 0.0;
+    mean_abs += (abs_err - mean_abs) * weight;
+    scaled_square_abs += (scaled * scaled - scaled_square_abs) * weight;
+    max_rel = std::max(max_rel, rel_err);
+    mean_rel += (rel_err - mean_rel) * weight;
+    mean_square_rel += (rel_err * rel_err - mean_square_rel) * weight;
+    histogram[bin(rel_err)]++;
+}
+
+// Means are combined weighted by pair count, in the same running form as add()
+void ColumnErrorStats::merge(const ColumnErrorStats& other) noexcept {
+    nonfinite += other.nonfinite;
+    different += other.different;
+    if (other.pairs == 0) return;
+    std::uint64_t total = pairs + other.pairs;
+    double weight = static_cast<double>(other.pairs) / static_cast<double>(total);
+    pairs = total;
+    double top = std::max(max_abs, other.max_abs);
+    double mine = rescale_squares(scaled_square_abs, max_abs, top);
+    double theirs = rescale_squares(other.scaled_square_abs, other.max_abs, top);
+    max_abs = top;
+    mean_abs += (other.mean_abs - mean_abs) * weight;
+    scaled_square_abs = mine + (theirs - mine) * weight;
+    max_rel = std::max(max_rel, other.max_rel);
+    mean_rel += (other.mean_rel - mean_rel) * weight;
+    mean_square_rel += (other.mean_square_rel - mean_square_rel) * weight;
+    for (size_t k = 0; k < n_bins; ++k) histogram[k] += other.histogram[k];
+}
+
+void merge_columns(ColumnErrorTable& table, const ColumnErrorTable& other) {
+    if (table.size() < other.size()) table.resize(other.size());
+    for (size_t c = 0; c < other.size(); ++c) table[c].merge(other[c]);
+}
+
+}  // namespace numdiff
@@ -0,0 +1,27 @@
+// ColumnSelection.cpp
+// -------------------------------------------------------------
+// Implementation of the compiled column selection
+// -------------------------------------------------------------
+
+#include "ColumnSelection.hpp"
+
+#include <algorithm>
+
+// Column numbers are 1-based on the command line and 0-based token indices here
+ColumnSelection::ColumnSelection(const std::set<size_t>& columns) : all_(columns.empty()) {
+    for (size_t column : columns) {
+        if (column == 0) continue;  // Not a valid column number, never matches a token
+        size_t index = column - 1;
+        indices_.push_back(index);
+        if (index < max_bitmap_columns) {
+            if (bitmap_.size() <= index) bitmap_.resize(index + 1, 0);
+            bitmap_[index] = 1;
+        }
+    }
+}
+
+// Indices beyond the bitmap are looked up in the sorted index list
+bool ColumnSelection::contains_sparse(size_t index) const noexcept {
+    return index >= max_bitmap_columns &&
+           std::binary_search(indices_.begin(), indices_.end(), index);
+}
@@ -0,0 +1,84 @@
+// FixedWidthLayout.cpp
+// -------------------------------------------------------------
+// Implementation of the fixed-width record layout
+// -------------------------------------------------------------
+
+#include "FixedWidthLayout.hpp"
+
+#include <algorithm>
+
+namespace {
+// Whitespace as recognized by TextParser::tokenize
+inline bool is_space(char c) noexcept {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Whether line[from, to) is all whitespace
+inline bool is_blank(const char* line, size_t from, size_t to) noexcept {
+    for (size_t i = from; i < to; ++i) {
+        if (!is_space(line[i])) return false;
+    }
+    return true;
+}
+}  // namespace
+
+void FixedWidthLayout::observe(std::string_view line,
+                               const std::vector<std::string_view>& tokens) {
+    if (state_ != State::learning || tokens.empty()) return;
+    if (n_observed_ > 0 && tokens.size() != fields_.size()) {
+        state_ = State::off;  // Not the same record: keep tokenizing
+        return;
+    }
+    fields_.resize(tokens.size(), Field{static_cast<size_t>(-1), 0});
+    for (size_t k = 0; k < tokens.size(); ++k) {
+        size_t begin = static_cast<size_t>(tokens[k].data() - line.data());
+        fields_[k].begin = std::min(fields_[k].begin, begin);
+        fields_[k].end = std::max(fields_[k].end, begin + tokens[k].size());
+        // Fields that touch could hide a token running across the boundary
+        if (k > 0 && fields_[k - 1].end >= fields_[k].begin) {
+            state_ = State::off;
+            return;
+        }
+    }
+    if (++n_observed_ < learn_lines_) return;
+
+    // A field may start anywhere after the blank that ends the previous one: right-aligned
+    // numbers grow to the left (a sign, a wider exponent) beyond what the learned lines showed
+    for (size_t k = 0; k < fields_.size(); ++k) {
+        fields_[k].begin = k > 0 ? fields_[k - 1].end + 1 : 0;
+    }
+    state_ = State::ready;
+}
+
+/**
+ * Slice a line by field offsets
+ *
+ * The padding of each field and the blanks between fields are skipped
+ * without tokenizing; a field whose trimmed value still holds a blank
+ * is two tokens to the tokenizer, so the line is left to it. Sliced
+ * tokens are therefore exactly those of TextParser::tokenize. A line
+ * may end inside its last field.
+ */
+bool FixedWidthLayout::slice(std::string_view line, const ColumnSelection& selection,
+                             std::vector<std::string_view>& tokens) const {
+    if (state_ != State::ready) return false;
+    tokens.clear();
+    const char* text = line.data();
+    size_t size = line.size();
+    size_t gap = 0;  // Start of the blanks before the next field
+    for (size_t k = 0; k < fields_.size(); ++k) {
+        const Field& field = fields_[k];
+        if (field.begin >= size || !is_blank(text, gap, field.begin)) return false;
+        size_t begin = field.begin;
+        size_t end = std::min(field.end, size);
+        while (begin < end && is_space(text[begin])) ++begin;
+        while (end > begin && is_space(text[end - 1])) --end;
+        if (begin == end) return false;  // Blank field
+        for (size_t i = begin; i < end; ++i) {
+            if (is_space(text[i])) return false;  // Two tokens in one field
+        }
+        if (selection.contains(k)) tokens.emplace_back(text + begin, end - begin);
+        gap = field.end;
+    }
+    return gap >= size || is_blank(text, gap, size);
+}
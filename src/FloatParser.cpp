@@ -0,0 +1,332 @@
+// FloatParser.cpp
+// -------------------------------------------------------------
+// Implementation of the fast decimal-to-double parser
+//
+// The 128-bit significands of 5^q are computed once, at static
+// initialization, with a small big-integer routine; parsing itself only
+// touches 64-bit and 128-bit integers.
+// -------------------------------------------------------------
+
+#include "FloatParser.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 u128;  // GCC/Clang extension (64-bit targets)
+
+// Normalized 128-bit significand of 5^q: 5^q ~= bits * 2^shift, bits in [2^127, 2^128)
+struct Power {
+    u128 bits;
+    int shift;
+    bool exact;  // bits * 2^shift == 5^q
+};
+
+// Little-endian 32-bit limbs
+using BigInt = std::vector<std::uint32_t>;
+
+size_t bit_length(const BigInt& x) {
+    for (size_t i = x.size(); i-- > 0;) {
+        if (x[i] != 0) return 32 * i + 32 - static_cast<size_t>(__builtin_clz(x[i]));
+    }
+    return 0;
+}
+
+bool bit(const BigInt& x, size_t i) {
+    return i / 32 < x.size() && ((x[i / 32] >> (i % 32)) & 1U) != 0;
+}
+
+void multiply_by_5(BigInt& x) {
+    std::uint64_t carry = 0;
+    for (std::uint32_t& limb : x) {
+        std::uint64_t v = static_cast<std::uint64_t>(limb) * 5 + carry;
+        limb = static_cast<std::uint32_t>(v);
+        carry = v >> 32;
+    }
+    if (carry != 0) x.push_back(static_cast<std::uint32_t>(carry));
+}
+
+// x >= y, both normalized to the same number of limbs
+bool not_less(const BigInt& x, const BigInt& y) {
+    for (size_t i = x.size(); i-- > 0;) {
+        if (x[i] != y[i]) return x[i] > y[i];
+    }
+    return true;
+}
+
+void shift_left_1(BigInt& x) {
+    std::uint32_t carry = 0;
+    for (std::uint32_t& limb : x) {
+        std::uint32_t next = limb >> 31;
+        limb = (limb << 1) | carry;
+        carry = next;
+    }
+}
+
+void subtract(BigInt& x, const BigInt& y) {
+    std::int64_t borrow = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        std::int64_t v = static_cast<std::int64_t>(x[i]) - y[i] - borrow;
+        borrow = v < 0 ? 1 : 0;
+        x[i] = static_cast<std::uint32_t>(v + (borrow << 32));
+    }
+}
+
+/**
+ * Table of 5^q for q in [min_power, max_power]
+ *
+ * Positive powers keep the top 128 bits of the exact 5^q (truncated),
+ * negative ones are floor(2^(b + 127) / 5^m) for m = -q and b the bit
+ * length of 5^m, by restoring long division. Either way the stored
+ * significand is at most the true one and less than it plus one unit.
+ */
+std::array<Power, FloatParser::max_power - FloatParser::min_power + 1> make_powers() {
+    std::array<Power, FloatParser::max_power - FloatParser::min_power + 1> table{};
+    BigInt five{1};
+    for (int m = 0; m <= -FloatParser::min_power || m <= FloatParser::max_power; ++m) {
+        size_t b = bit_length(five);
+        if (m <= FloatParser::max_power) {
+            Power& p = table[static_cast<size_t>(m - FloatParser::min_power)];
+            p.bits = 0;
+            for (size_t k = 0; k < 128; ++k) {
+                // Bit k of the significand is bit (b - 128 + k) of 5^m (zero below bit 0)
+                std::int64_t src =
+                    static_cast<std::int64_t>(b) - 128 + static_cast<std::int64_t>(k);
+                if (src >= 0 && bit(five, static_cast<size_t>(src))) p.bits |= u128(1) << k;
+            }
+            p.shift = static_cast<int>(b) - 128;
+            p.exact = b <= 128;
+        }
+        if (m > 0 && -m >= FloatParser::min_power) {
+            BigInt divisor = five, remainder(five.size() + 1, 0);
+            divisor.push_back(0);
+            remainder[0] = 1;  // Numerator 2^(b + 127): a 1 followed by b + 127 shifts
+            u128 quotient = 0;
+            for (size_t k = 0; k < b + 127; ++k) {
+                shift_left_1(remainder);
+                bool one = not_less(remainder, divisor);
+                if (one) subtract(remainder, divisor);
+                quotient = (quotient << 1) | static_cast<u128>(one);
+            }
+            Power& p = table[static_cast<size_t>(-m - FloatParser::min_power)];
+            p.bits = quotient;
+            p.shift = -static_cast<int>(b) - 127;
+            p.exact = false;
+        }
+        multiply_by_5(five);
+    }
+    return table;
+}
+
+const auto powers_table = make_powers();  // No lazy-init guard on the parsing path
+
+const Power& power_of_five(int q) {
+    return powers_table[static_cast<size_t>(q - FloatParser::min_power)];
+}
+
+// 192-bit unsigned integer, most significant limb first
+struct U192 {
+    std::uint64_t hi, mid, lo;
+};
+
+/**
+ * Round p * 2^e2 to the nearest double, ties to even
+ *
+ * p is the product of normalized factors (one of its top two bits set)
+ * and the true value lies in [p, p + 2^64) * 2^e2, or is p itself when
+ * exact. The interval rounds like p unless adding to the low 128 bits
+ * may carry into the rounded bits, or p has no sticky bits to tell a
+ * tie; those cases, and results that are not normal doubles, return
+ * false. Branch-free on the common path.
+ */
+bool round_product(U192 p, int e2, bool exact, std::uint64_t& out) {
+    std::uint64_t shift = 1 - (p.hi >> 63);  // Move the top bit to bit 191
+    p.hi = (p.hi << shift) | ((p.mid >> 63) & shift);
+    std::uint64_t mid = (p.mid << shift) | ((p.lo >> 63) & shift);
+    std::uint64_t lo = p.lo << shift;
+    bool sticky = (p.hi & 0x3FF) != 0 || mid != 0 || lo != 0;
+    if (!exact && (((p.mid | (std::uint64_t{1} << 63)) == ~std::uint64_t{0}) || !sticky)) {
+        return false;
+    }
+    int exponent = 191 + e2 - static_cast<int>(shift);  // Value in [2^exponent, 2^(exponent + 1))
+    std::uint64_t mantissa = p.hi >> 11;                 // 53 bits, top bit set
+    std::uint64_t round = (p.hi >> 10) & 1U;
+    mantissa += round & (static_cast<std::uint64_t>(sticky) | (mantissa & 1U));
+    std::uint64_t carry = mantissa >> 53;  // Rounded up to 2^53
+    mantissa >>= carry;
+    exponent += static_cast<int>(carry);
+    int biased = exponent + 1023;
+    if (biased < 1 || biased > 2046) return false;
+    out = (static_cast<std::uint64_t>(biased) << 52) | (mantissa & ((std::uint64_t{1} << 52) - 1));
+    return true;
+}
+
+// w * bits as a 192-bit product
+U192 multiply(std::uint64_t w, u128 bits) {
+    u128 low = static_cast<u128>(w) * static_cast<std::uint64_t>(bits);
+    u128 high = static_cast<u128>(w) * static_cast<std::uint64_t>(bits >> 64) + (low >> 64);
+    return {static_cast<std::uint64_t>(high >> 64), static_cast<std::uint64_t>(high),
+            static_cast<std::uint64_t>(low)};
+}
+
+#endif  // __SIZEOF_INT128__
+
+// Exactly representable powers of ten (fast path)
+constexpr double exact_powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                          1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                          1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+constexpr std::uint64_t max_exact_integer = std::uint64_t{1} << 53;
+
+inline bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Eight characters as a little-endian 64-bit word
+inline std::uint64_t load_eight(const char* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// Whether all eight bytes are ASCII digits
+inline bool is_eight_digits(std::uint64_t v) noexcept {
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL)
+                                            >> 4)) == 0x3333333333333333ULL);
+}
+
+// Value of eight ASCII digits, first digit in the low byte (SWAR: three multiplications)
+inline std::uint64_t parse_eight_digits(std::uint64_t v) noexcept {
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);  // Pairs of digits
+    return (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+            (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >>
+           32;
+}
+
+// Append the digits at p to w, eight at a time while they last; returns the end of the run
+inline const char* parse_fraction_digits(const char* p, const char* end, std::uint64_t& w) noexcept {
+    while (end - p >= 8) {
+        std::uint64_t v = load_eight(p);
+        if (!is_eight_digits(v)) break;
+        w = w * 100000000 + parse_eight_digits(v);
+        p += 8;
+    }
+    for (; p != end && is_digit(*p); ++p) w = w * 10 + static_cast<std::uint64_t>(*p - '0');
+    return p;
+}
+
+}  // namespace
+
+std::optional<double> FloatParser::parse(std::string_view token) noexcept {
+    const char* p = token.data();
+    const char* end = p + token.size();
+    bool negative = p != end && *p == '-';
+    if (negative) ++p;
+    if (p == end || (!is_digit(*p) && *p != '.')) {
+        return parse_fallback(token, std::string_view::npos);  // inf, nan, or not numeric
+    }
+
+    // Mantissa digits into w (leading zeros keep it 0), the decimal exponent q from the point;
+    // integer parts are short in numeric dumps, fractions are read eight digits at a time
+    std::uint64_t w = 0;
+    const char* digits = p;
+    for (; p != end && is_digit(*p); ++p) w = w * 10 + static_cast<std::uint64_t>(*p - '0');
+    size_t n_digits = static_cast<size_t>(p - digits);
+    bool has_point = p != end && *p == '.';
+    int q = 0;
+    if (has_point) {
+        const char* fraction = ++p;
+        p = parse_fraction_digits(p, end, w);
+        q = -static_cast<int>(p - fraction);
+        n_digits += static_cast<size_t>(p - fraction);
+    }
+    if (n_digits == 0) return std::nullopt;
+    // w overflows beyond 19 significant digits: those tokens go to the fallback
+    bool too_long = false;
+    if (n_digits > 19) {
+        const char* s = digits;
+        for (; s != p && (*s == '0' || *s == '.'); ++s) {
+            if (*s == '0') --n_digits;
+        }
+        too_long = n_digits > 19;
+    }
+
+    // Exponent: E/e, Fortran D/d, or a bare sign with 3 digits after a decimal point (Ew.d)
+    size_t exponent_pos = std::string_view::npos;
+    if (p != end) {
+        exponent_pos = static_cast<size_t>(p - token.data());
+        bool letter = *p == 'e' || *p == 'E' || *p == 'd' || *p == 'D';
+        if (letter) {
+            ++p;
+        } else if (!has_point || (*p != '+' && *p != '-') || end - p != 4) {
+            return std::nullopt;
+        }
+        bool negative_exponent = p != end && *p == '-';
+        if (p != end && (*p == '-' || *p == '+')) ++p;
+        if (p == end) return std::nullopt;
+        int exponent = 0;
+        for (; p != end && is_digit(*p); ++p) {
+            if (exponent < 100000) exponent = exponent * 10 + (*p - '0');
+        }
+        if (p != end) return std::nullopt;
+        q += negative_exponent ? -exponent : exponent;
+    }
+
+    if (too_long) return parse_fallback(token, exponent_pos);
+    if (w == 0) return negative ? -0.0 : 0.0;
+
+    // 1. Clinger's fast path: one correctly rounded operation on exact operands
+    if (w <= max_exact_integer && q >= -22 && q <= 22) {
+        double value = static_cast<double>(w);
+        value = q < 0 ? value / exact_powers_of_ten[-q] : value * exact_powers_of_ten[q];
+        return negative ? -value : value;
+    }
+
+#ifdef __SIZEOF_INT128__
+    // 2. w * 5^q * 2^q, bracketed by the truncated 128-bit significand of 5^q
+    if (q >= min_power && q <= max_power) {
+        const Power& power = power_of_five(q);
+        int lz = __builtin_clzll(w);
+        std::uint64_t normalized = w << lz;
+        int e2 = power.shift + q - lz;
+        std::uint64_t bits;
+        if (round_product(multiply(normalized, power.bits), e2, power.exact, bits)) {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return negative ? -value : value;
+        }
+    }
+#endif
+    return parse_fallback(token, exponent_pos);
+}
+
+// std::from_chars accepts only E exponents: rewrite D and insert the letter Ew.d dropped
+std::optional<double> FloatParser::parse_fallback(std::string_view token,
+                                                  size_t exponent_pos) noexcept {
+    char buffer[128];
+    if (exponent_pos != std::string_view::npos && token[exponent_pos] != 'e' &&
+        token[exponent_pos] != 'E') {
+        if (token.size() + 1 > sizeof(buffer)) return std::nullopt;
+        std::memcpy(buffer, token.data(), exponent_pos);
+        size_t n = exponent_pos;
+        buffer[n++] = 'e';
+        size_t rest = exponent_pos;
+        if (token[rest] == 'd' || token[rest] == 'D') ++rest;
+        std::memcpy(buffer + n, token.data() + rest, token.size() - rest);
+        token = std::string_view(buffer, n + token.size() - rest);
+    }
+    double value;
+    const char* end = token.data() + token.size();
+    auto result = std::from_chars(token.data(), end, value);
+    if (result.ec != std::errc() || result.ptr != end) return std::nullopt;
+    return value;
+}
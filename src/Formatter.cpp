@@ -18,13 +18,21 @@
  * is the maximum length between corresponding tokens in t1 and t2.
  * Used for aligned column output.
  */
-std::vector<size_t> Formatter::calculate_col_widths(const std::vector<std::string>& t1,
-                                                    const std::vector<std::string>& t2) {
+std::vector<size_t> Formatter::calculate_col_widths(const std::vector<std::string_view>& t1,
+                                                    const std::vector<std::string_view>& t2) {
+    std::vector<size_t> col_widths;
+    calculate_col_widths(t1, t2, col_widths);
+    return col_widths;
+}
+
+// Same as above, reusing the caller's vector
+void Formatter::calculate_col_widths(const std::vector<std::string_view>& t1,
+                                     const std::vector<std::string_view>& t2,
+                                     std::vector<size_t>& widths) {
     size_t n = std::min(t1.size(), t2.size());
-    std::vector<size_t> col_widths(n, 0);
+    widths.resize(n);
     // For each column, take the maximum width between the two vectors
-    for (size_t i = 0; i < n; ++i) col_widths[i] = std::max(t1[i].size(), t2[i].size());
-    return col_widths;
+    for (size_t i = 0; i < n; ++i) widths[i] = std::max(t1[i].size(), t2[i].size());
 }
 
 /**
@@ -36,26 +44,25 @@ std::vector<size_t> Formatter::calculate_col_widths(const std::vector<std::strin
  */
 std::string Formatter::strip_ansi(const std::string& input) {
     std::string result;
-    bool in_escape = false;  // Track if we're inside an escape sequence
-    
-    for (size_t i = 0; i < input.size(); ++i) {
-        if (!in_escape) {
-            // Check for start of ANSI sequence: ESC[
-            if (input[i] == '\033' && i + 1 < input.size() && input[i + 1] == '[') {
-                in_escape = true;
-            } else {
-                result += input[i];  // Regular character, keep it
-            }
-        } else {
-            // Inside escape sequence: skip until we find 'm'
-            if (input[i] == 'm') {
-                in_escape = false;  // End of sequence
-            }
-        }
-    }
+    result.reserve(input.size());
+    append_stripped(result, input);
     return result;
 }
 
+// Copies the visible runs between escape sequences in bulk
+void Formatter::append_stripped(std::string& out, std::string_view input) {
+    size_t pos = 0;
+    for (;;) {
+        size_t esc = input.find("\033[", pos);
+        if (esc == std::string_view::npos) break;
+        out.append(input.data() + pos, esc - pos);  // Visible run before the sequence
+        size_t end = input.find('m', esc + 2);        // Sequence ends at its 'm'
+        if (end == std::string_view::npos) return;    // Unterminated: dropped, like its tail
+        pos = end + 1;
+    }
+    out.append(input.data() + pos, input.size() - pos);
+}
+
 /**
  * Ensure a string ends with ANSI reset code if it contains unclosed color
  * 
@@ -88,36 +95,76 @@ void Formatter::ensure_ansi_reset(std::string& str) {
  */
 std::string Formatter::extract_visible_prefix(const std::string& input, size_t n) {
     std::string result;
-    size_t visible_count = 0;    // Count of non-ANSI characters
-    bool in_escape = false;      // Track if inside escape sequence
-    
-    for (size_t i = 0; i < input.size(); ++i) {
+    append_visible_prefix(result, input, n);
+    return result;
+}
+
+/**
+ * Append the first n visible characters of input, preserving ANSI codes
+ * 
+ * The kept part is always a prefix of input: scanning stops at the first
+ * visible character beyond the limit, so escape sequences right after
+ * the limit are still copied. Tracks whether the last complete color
+ * code in the prefix was red without a later reset, and closes it (the
+ * behavior of ensure_ansi_reset) without searching the result again.
+ */
+void Formatter::append_visible_prefix(std::string& out, std::string_view input, size_t n) {
+    // Fast path: plain text that fits
+    if (input.size() <= n && input.find('\033') == std::string_view::npos) {
+        out.append(input.data(), input.size());
+        return;
+    }
+
+    size_t visible_count = 0;  // Count of non-ANSI characters
+    bool in_escape = false;    // Track if inside escape sequence
+    size_t escape_start = 0;   // Position of the current sequence's ESC
+    bool color_open = false;   // Red started and not reset yet
+    size_t i = 0;
+    for (; i < input.size(); ++i) {
         if (!in_escape) {
             // Check for start of ANSI sequence
             if (input[i] == '\033' && i + 1 < input.size() && input[i + 1] == '[') {
                 in_escape = true;
-                result += input[i];  // Include escape sequence in output
+                escape_start = i;
+            } else if (visible_count < n) {
+                ++visible_count;  // Regular visible character
             } else {
-                // Regular visible character
-                if (visible_count < n) {
-                    result += input[i];
-                    ++visible_count;
-                } else {
-                    break;  // Reached desired visible character count
-                }
-            }
-        } else {
-            // Inside escape sequence: copy verbatim
-            result += input[i];
-            if (input[i] == 'm') {
-                in_escape = false;  // End of sequence
+                break;  // Reached desired visible character count
             }
+        } else if (input[i] == 'm') {
+            // End of sequence: remember whether it opened or closed the red color
+            in_escape = false;
+            std::string_view code = input.substr(escape_start, i + 1 - escape_start);
+            if (code == RED) color_open = true;
+            else if (code == RESET) color_open = false;
         }
     }
-    
+    out.append(input.data(), i);
+
     // Ensure proper termination if string was truncated mid-color
-    ensure_ansi_reset(result);
-    return result;
+    if (color_open) out.append(RESET.data(), RESET.size());
+}
+
+/**
+ * Count visible characters, skipping ANSI escape sequences
+ * Plain strings (the common case) are measured without a scan.
+ */
+size_t Formatter::visible_width(std::string_view input) noexcept {
+    if (input.find('\033') == std::string_view::npos) return input.size();
+    size_t width = 0;
+    bool in_escape = false;
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (!in_escape) {
+            if (input[i] == '\033' && i + 1 < input.size() && input[i + 1] == '[') {
+                in_escape = true;
+            } else {
+                ++width;
+            }
+        } else if (input[i] == 'm') {
+            in_escape = false;
+        }
+    }
+    return width;
 }
 
 /**
@@ -136,67 +183,48 @@ std::string Formatter::extract_visible_prefix(const std::string& input, size_t n
  * Modifies s1 and s2 in place.
  */
 void Formatter::colorize_different_digits(std::string& s1, std::string& s2) {
-    // Lambda to split a string into mantissa and exponent at 'e' or 'E'
-    auto split_exp = [](const std::string& s) -> std::pair<std::string, std::string> {
-        size_t epos = s.find_first_of("eE");
-        if (epos == std::string::npos) return {s, ""};  // No exponent
-        return {s.substr(0, epos), s.substr(epos)};     // Split at 'e'
-    };
-    
-    auto [mant1, exp1] = split_exp(s1);
-    auto [mant2, exp2] = split_exp(s2);
+    TokenArena arena;
+    append_different_digits(arena, s1, s2);
+    s1.assign(arena.token(0));
+    s2.assign(arena.token(1));
+}
+
+/**
+ * Render colorize_different_digits() output into buffers
+ * 
+ * Mantissas and exponents are views into the inputs, and each colored
+ * number is appended piece by piece, so no temporary strings are made.
+ */
+void Formatter::append_different_digits(TokenArena& arena, std::string_view s1,
+                                        std::string_view s2) {
+    // Split each number into mantissa and exponent at 'e' or 'E'
+    size_t epos1 = std::min(s1.find_first_of("eE"), s1.size());
+    size_t epos2 = std::min(s2.find_first_of("eE"), s2.size());
+    std::string_view mant1 = s1.substr(0, epos1), exp1 = s1.substr(epos1);
+    std::string_view mant2 = s2.substr(0, epos2), exp2 = s2.substr(epos2);
 
-    std::string out1, out2;
+    // First differing character position in the mantissas
     size_t n = std::min(mant1.size(), mant2.size());
-    size_t diff_start = n;  // Position where mantissas first differ
-    
-    // Find the first differing character position in mantissa
-    for (size_t i = 0; i < n; ++i) {
-        if (mant1[i] != mant2[i]) {
-            diff_start = i;
-            break;
-        }
-    }
-    
-    // If mantissas have different lengths, that's also a difference
-    if (mant1.size() != mant2.size()) {
-        diff_start = std::min(diff_start, n);
-    }
-    
-    // Build colored mantissas: matching prefix + red differing suffix
-    if (diff_start < mant1.size()) {
-        out1 = mant1.substr(0, diff_start) + std::string(RED) + mant1.substr(diff_start) +
-               std::string(RESET);
-    } else {
-        out1 = mant1;  // No difference in mantissa1  // No difference in mantissa1
-    }
-    
-    if (diff_start < mant2.size()) {
-        out2 = mant2.substr(0, diff_start) + std::string(RED) + mant2.substr(diff_start) +
-               std::string(RESET);
-    } else {
-        out2 = mant2;  // No difference in mantissa2  // No difference in mantissa2
-    }
-    
-    // Handle exponent colorization
-    if (!exp1.empty() || !exp2.empty()) {
-        // If mantissas differ, color all exponents (even if equal)
-        if (diff_start < n || mant1.size() != mant2.size()) {
-            if (!exp1.empty()) out1 += std::string(RED) + exp1 + std::string(RESET);
-            if (!exp2.empty()) out2 += std::string(RED) + exp2 + std::string(RESET);
-        }
-        // If mantissas match, only color if exponents differ
-        else if (exp1 == exp2) {
-            out1 += exp1;  // No color, exponents match
-            out2 += exp2;
-        } else {
-            // Exponents differ
-            if (!exp1.empty()) out1 += std::string(RED) + exp1 + std::string(RESET);
-            if (!exp2.empty()) out2 += std::string(RED) + exp2 + std::string(RESET);
+    size_t diff_start = static_cast<size_t>(
+        std::mismatch(mant1.begin(), mant1.begin() + n, mant2.begin()).first - mant1.begin());
+
+    // Exponents are colored when the mantissas differ (also in length) or they differ themselves
+    bool color_exponents = diff_start < n || mant1.size() != mant2.size() || exp1 != exp2;
+
+    // Matching prefix + red differing suffix, then the exponent
+    auto append = [&](std::string_view mant, std::string_view exp) {
+        std::string& out = arena.text();
+        out.append(mant.data(), diff_start);
+        if (diff_start < mant.size()) append_red(out, mant.substr(diff_start));
+        if (!exp.empty()) {
+            if (color_exponents) {
+                append_red(out, exp);
+            } else {
+                out.append(exp.data(), exp.size());
+            }
         }
-    }
-    
-    // Update the input strings with colorized versions
-    s1 = out1;
-    s2 = out2;
+        arena.close();
+    };
+    append(mant1, exp1);
+    append(mant2, exp2);
 }
@@ -0,0 +1,204 @@
+// KeyIndex.cpp
+// -------------------------------------------------------------
+// Implementation of the key-column hash index
+// -------------------------------------------------------------
+
+#include "KeyIndex.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#include "TextParser.hpp"
+
+namespace {
+// splitmix64 finalizer: spreads cell bits over the whole hash
+std::uint64_t mix(std::uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Bit pattern of a double, with -0 folded onto +0
+std::uint64_t bits(double value) noexcept {
+    value += 0.0;
+    std::uint64_t b;
+    std::memcpy(&b, &value, sizeof(b));
+    return b;
+}
+}  // namespace
+
+KeyIndex::KeyIndex(const std::set<size_t>& columns, double tolerance)
+    : selection_(columns),
+      n_columns_(columns.size()),
+      min_tokens_(columns.empty() ? 0 : *columns.rbegin()),
+      tolerance_(tolerance) {
+    key_values_.resize(n_columns_);
+    key_numeric_.resize(n_columns_);
+    key_cells_.resize(n_columns_);
+    key_other_cells_.resize(n_columns_);
+}
+
+// Cells are 2 * tolerance wide: a value within tolerance lies in its own or the nearest other
+double KeyIndex::cell(double value) const noexcept {
+    return tolerance_ > 0.0 ? std::floor(value / (2.0 * tolerance_)) : value;
+}
+
+bool KeyIndex::split(std::string_view line) {
+    size_t n_tokens = TextParser::tokenize_selected(line, selection_, key_tokens_);
+    if (n_tokens < min_tokens_) return false;
+    probe_columns_.clear();
+    for (size_t k = 0; k < n_columns_; ++k) {
+        std::optional<double> value = TextParser::try_parse_number(key_tokens_[k]);
+        key_numeric_[k] = value.has_value();
+        if (!value) continue;
+        key_values_[k] = *value;
+        key_cells_[k] = cell(*value);
+        if (tolerance_ > 0.0 && probe_columns_.size() < max_probe_columns &&
+            std::isfinite(*value)) {
+            double position = *value / (2.0 * tolerance_) - key_cells_[k];
+            key_other_cells_[k] = key_cells_[k] + (position < 0.5 ? -1.0 : 1.0);
+            probe_columns_.push_back(k);
+        }
+    }
+    return true;
+}
+
+std::uint64_t KeyIndex::hash_key(std::uint32_t probe) const {
+    std::uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    size_t next_probe = 0;  // Position of column k in probe_columns_ (sorted like k)
+    for (size_t k = 0; k < n_columns_; ++k) {
+        std::uint64_t part;
+        if (key_numeric_[k] != 0) {
+            bool other = false;
+            if (next_probe < probe_columns_.size() && probe_columns_[next_probe] == k)
+                other = ((probe >> next_probe++) & 1U) != 0;
+            part = bits(other ? key_other_cells_[k] : key_cells_[k]);
+        } else {
+            part = std::hash<std::string_view>()(key_tokens_[k]);
+        }
+        hash = mix(hash ^ (part + k));
+    }
+    return hash;
+}
+
+// Numbers within tolerance (exactly equal without one), anything else byte for byte
+bool KeyIndex::matches(std::uint32_t id) const {
+    const double* values = values_.data() + static_cast<size_t>(id) * n_columns_;
+    const std::string_view* texts = texts_.data() + static_cast<size_t>(id) * n_columns_;
+    const std::uint8_t* numeric = numeric_.data() + static_cast<size_t>(id) * n_columns_;
+    for (size_t k = 0; k < n_columns_; ++k) {
+        if (numeric[k] != 0 && key_numeric_[k] != 0) {
+            double distance = std::abs(values[k] - key_values_[k]);
+            if (tolerance_ > 0.0 ? !(distance <= tolerance_) : !(distance <= 0.0)) return false;
+        } else if (texts[k] != key_tokens_[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KeyIndex::add(std::string_view line) {
+    bool keyed = split(line);
+    keyed_.push_back(keyed);
+    taken_.push_back(0);
+    hashes_.push_back(keyed ? hash_key(0) : 0);
+    for (size_t k = 0; k < n_columns_; ++k) {
+        values_.push_back(keyed && key_numeric_[k] != 0 ? key_values_[k] : 0.0);
+        texts_.push_back(keyed ? key_tokens_[k] : std::string_view());
+        numeric_.push_back(keyed ? key_numeric_[k] : 0);
+    }
+    return keyed;
+}
+
+size_t KeyIndex::find_slot(std::uint64_t hash) const noexcept {
+    size_t mask = slot_hash_.size() - 1;
+    size_t slot = static_cast<size_t>(hash) & mask;
+    while (slot_head_[slot] != npos && slot_hash_[slot] != hash) slot = (slot + 1) & mask;
+    return slot;
+}
+
+/**
+ * Build the open-addressing table
+ *
+ * One slot per distinct hash, at most half full. Rows sharing a hash
+ * are chained through next_ in increasing id order (linked from the
+ * last row backwards), so take() meets the lowest ids first.
+ */
+void KeyIndex::build() {
+    size_t capacity = 16;
+    while (capacity < 2 * size()) capacity *= 2;
+    slot_hash_.assign(capacity, 0);
+    slot_head_.assign(capacity, npos);
+    next_.assign(size(), npos);
+    for (size_t i = size(); i-- > 0;) {
+        if (keyed_[i] == 0) continue;
+        size_t slot = find_slot(hashes_[i]);
+        next_[i] = slot_head_[slot];
+        slot_hash_[slot] = hashes_[i];
+        slot_head_[slot] = static_cast<std::uint32_t>(i);
+    }
+}
+
+/**
+ * Look up the cells of the key (one or two per tolerant numeric column)
+ *
+ * Taken rows at the front of a chain are unlinked from its slot as they
+ * are met, so long runs of duplicate keys are not walked again.
+ */
+std::uint32_t KeyIndex::take(std::string_view line) {
+    if (slot_head_.empty() || !split(line)) return npos;
+    std::uint32_t best = npos;
+    std::uint32_t n_probes = 1U << probe_columns_.size();
+    for (std::uint32_t probe = 0; probe < n_probes; ++probe) {
+        size_t slot = find_slot(hash_key(probe));
+        std::uint32_t& head = slot_head_[slot];
+        while (head != npos && taken_[head] != 0) head = next_[head];
+        for (std::uint32_t id = head; id != npos && id < best; id = next_[id]) {
+            if (taken_[id] == 0 && matches(id)) {
+                best = id;
+                break;
+            }
+        }
+    }
+    if (best != npos) taken_[best] = 1;
+    return best;
+}
+
+/**
+ * Partition of a line for the spilling join
+ *
+ * Exact keys and text keys are hashed. Tolerant numeric keys are
+ * grouped into runs of cells_per_group cells first, so that neighboring
+ * cells share a partition; a row in the first or last cell of a run
+ * also belongs to the adjacent run's partition, which receives the file2
+ * rows that may match it across the edge.
+ */
+KeyIndex::Route KeyIndex::route(std::string_view line, size_t n_partitions) {
+    if (n_columns_ == 0 || !split(line)) return {0, 0};
+    auto partition = [n_partitions](std::uint64_t hash) {
+        return static_cast<size_t>(mix(hash) % n_partitions);
+    };
+    if (key_numeric_[0] == 0 || tolerance_ <= 0.0 || !std::isfinite(key_values_[0])) {
+        size_t home = partition(key_numeric_[0] != 0
+                                    ? bits(key_values_[0])
+                                    : std::hash<std::string_view>()(key_tokens_[0]));
+        return {home, home};
+    }
+    double group = std::floor(key_cells_[0] / cells_per_group);
+    double offset = key_cells_[0] - group * cells_per_group;
+    size_t home = partition(bits(group));
+    if (offset < 1.0) return {home, partition(bits(group - 1.0))};
+    if (offset >= cells_per_group - 1.0) return {home, partition(bits(group + 1.0))};
+    return {home, home};
+}
+
+size_t KeyIndex::memory_bytes() const noexcept {
+    return hashes_.capacity() * sizeof(std::uint64_t) + keyed_.capacity() +
+           values_.capacity() * sizeof(double) + texts_.capacity() * sizeof(std::string_view) +
+           numeric_.capacity() + taken_.capacity() + next_.capacity() * sizeof(std::uint32_t) +
+           slot_hash_.capacity() * sizeof(std::uint64_t) +
+           slot_head_.capacity() * sizeof(std::uint32_t);
+}
@@ -0,0 +1,226 @@
+// LineSource.cpp
+// -------------------------------------------------------------
+// Implementation of the line-oriented input backends
+//
+// Regular files are memory-mapped and scanned in place with memchr;
+// everything else (including decompressed data) is read through a
+// reusable block buffer. Neither path copies individual lines. Both can
+// read ahead asynchronously, overlapping storage latency with parsing.
+// -------------------------------------------------------------
+
+#include "LineSource.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Open a file with the most efficient backend available
+ *
+ * Non-empty regular files are mapped read-only with a sequential access
+ * hint. If the descriptor is not a regular file, or mmap fails, the same
+ * descriptor is handed to a StreamLineSource instead.
+ *
+ * Inputs starting with a gzip/xz/zstd magic number are streamed through
+ * the matching decoder, which runs on its own thread behind a
+ * PrefetchReader: decompressing one input overlaps with parsing. The
+ * magic number of a regular file is read with pread(); that of a pipe
+ * is read from the stream and replayed in front of it (ReplayReader).
+ * Standard input ("-") takes the same paths as an opened file.
+ *
+ * read_ahead sizes the asynchronous read-ahead: the MADV_WILLNEED window
+ * of a mapping, or the block ring of a PrefetchReader (default_depth
+ * blocks) in front of a streamed descriptor. io_uring is not used: the
+ * kernel's own read-ahead serves mappings, and one reader thread per
+ * stream keeps a pipe or FIFO drained while the other input is parsed.
+ */
+std::unique_ptr<LineSource> LineSource::open(const std::string& path, size_t read_ahead) {
+    bool owns_fd = !is_stdin(path);  // Standard input stays open for the caller
+    int fd = owns_fd ? ::open(path.c_str(), O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) throw std::runtime_error("Error: could not open file: " + path);
+
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        char head[ByteReader::magic_size];
+        ssize_t n = ::pread(fd, head, sizeof(head), 0);
+        Compression compression = ByteReader::detect_compression(
+            std::string_view(head, n > 0 ? static_cast<size_t>(n) : 0));
+        if (compression != Compression::none) {
+            auto compressed = std::make_unique<FdReader>(fd, path, owns_fd);
+            return std::make_unique<StreamLineSource>(std::make_unique<PrefetchReader>(
+                ByteReader::decompress(compression, std::move(compressed), path)));
+        }
+
+        size_t length = static_cast<size_t>(st.st_size);
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, length, MADV_SEQUENTIAL);
+            if (owns_fd) ::close(fd);  // The mapping stays valid after closing the descriptor
+            return std::make_unique<MappedLineSource>(mapping, length, read_ahead);
+        }
+    }
+
+    // Pipes, FIFOs and the like: the magic bytes are taken from the stream, then replayed
+    auto reader = std::make_unique<FdReader>(fd, path, owns_fd);
+    std::string head(ByteReader::magic_size, '\0');
+    size_t n_head = 0;
+    while (n_head < head.size()) {
+        size_t n = reader->read(head.data() + n_head, head.size() - n_head);
+        if (n == 0) break;
+        n_head += n;
+    }
+    head.resize(n_head);
+    Compression compression = ByteReader::detect_compression(head);
+    std::unique_ptr<ByteReader> input =
+        std::make_unique<ReplayReader>(std::move(head), std::move(reader));
+    if (compression != Compression::none) {
+        return std::make_unique<StreamLineSource>(std::make_unique<PrefetchReader>(
+            ByteReader::decompress(compression, std::move(input), path)));
+    }
+    if (read_ahead > 0) {
+        size_t block = std::max<size_t>(read_ahead / PrefetchReader::default_depth, 1 << 16);
+        return std::make_unique<StreamLineSource>(std::make_unique<PrefetchReader>(
+            std::move(input), block, PrefetchReader::default_depth));
+    }
+    return std::make_unique<StreamLineSource>(std::move(input));
+}
+
+// Skipping needs random access to the unread input
+void LineSource::skip(size_t, std::uint64_t) {
+    throw std::logic_error("LineSource::skip() requires an in-memory backend");
+}
+
+// Advance past a region of whole lines already inspected by the caller
+void BufferLineSource::skip(size_t n_bytes, std::uint64_t n_lines) {
+    pos_ = std::min(pos_ + n_bytes, buffer_.size());
+    line_number_ += n_lines;
+}
+
+/**
+ * Return the next line of the buffer as a view
+ *
+ * Searches for '\n' with memchr from the current position. The final
+ * line is returned even if it has no terminating newline.
+ */
+bool BufferLineSource::next_line(std::string_view& line) {
+    if (pos_ >= buffer_.size()) return false;
+
+    const char* start = buffer_.data() + pos_;
+    size_t remaining = buffer_.size() - pos_;
+    const void* nl = std::memchr(start, '\n', remaining);
+    if (nl == nullptr) {
+        line = std::string_view(start, remaining);
+        pos_ = buffer_.size();
+    } else {
+        size_t len = static_cast<size_t>(static_cast<const char*>(nl) - start);
+        line = std::string_view(start, len);
+        pos_ += len + 1;  // Skip the newline
+    }
+    ++line_number_;
+    return true;
+}
+
+// Adopt an existing read-only mapping, requesting the first window right away
+MappedLineSource::MappedLineSource(void* mapping, size_t length, size_t window)
+    : mapping_(mapping), length_(length), read_ahead_(window) {
+    buffer_ = std::string_view(static_cast<const char*>(mapping_), length_);
+    if (read_ahead_ > 0) read_ahead();
+}
+
+// Skips jump ahead of the window: the next line tops it up from the new position
+void MappedLineSource::skip(size_t n_bytes, std::uint64_t n_lines) {
+    BufferLineSource::skip(n_bytes, n_lines);
+    if (pos_ >= refill_at_) read_ahead();
+}
+
+/**
+ * Extend the requested range to read_ahead_ bytes past the reader
+ *
+ * Only the part not requested yet is passed on, starting at a page
+ * boundary. At the end of the mapping no further requests are made.
+ */
+void MappedLineSource::read_ahead() {
+    size_t end = std::min(length_, pos_ + read_ahead_);
+    size_t begin = std::max(requested_, pos_);
+    if (begin < end) {
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        begin -= begin % page;
+        ::madvise(static_cast<char*>(mapping_) + begin, end - begin, MADV_WILLNEED);
+        requested_ = end;
+    }
+    refill_at_ = end == length_ ? static_cast<size_t>(-1) : end - read_ahead_ / 2;
+}
+
+// Release the mapping
+MappedLineSource::~MappedLineSource() {
+    if (mapping_ != nullptr) ::munmap(mapping_, length_);
+}
+
+// Take over a descriptor and allocate the initial read buffer
+StreamLineSource::StreamLineSource(int fd, std::string name, bool owns_fd)
+    : StreamLineSource(std::make_unique<FdReader>(fd, std::move(name), owns_fd)) {}
+
+// Adopt a reader and allocate the initial read buffer
+StreamLineSource::StreamLineSource(std::unique_ptr<ByteReader> reader)
+    : reader_(std::move(reader)), buf_(block_size) {}
+
+/**
+ * Read more bytes after the unconsumed tail of the buffer
+ *
+ * Moves the pending partial line to the front of the buffer (doubling
+ * the buffer if the partial line already fills it), then issues a
+ * single read from the reader. Returns false once the reader reports
+ * EOF. Read errors propagate as runtime_error.
+ */
+bool StreamLineSource::refill() {
+    if (begin_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+
+    size_t n = reader_->read(buf_.data() + end_, buf_.size() - end_);
+    if (n == 0) {
+        eof_ = true;
+        return false;
+    }
+    end_ += n;
+    return true;
+}
+
+/**
+ * Return the next line as a view into the read buffer
+ *
+ * Scans the buffered bytes for '\n'; when none is found, refills and
+ * retries. At EOF any pending bytes form the final line.
+ */
+bool StreamLineSource::next_line(std::string_view& line) {
+    size_t scanned = begin_;  // Bytes already known not to contain '\n'
+    for (;;) {
+        const void* nl = std::memchr(buf_.data() + scanned, '\n', end_ - scanned);
+        if (nl != nullptr) {
+            size_t nl_pos = static_cast<size_t>(static_cast<const char*>(nl) - buf_.data());
+            line = std::string_view(buf_.data() + begin_, nl_pos - begin_);
+            begin_ = nl_pos + 1;
+            ++line_number_;
+            return true;
+        }
+        if (eof_) break;
+        size_t pending = end_ - begin_;
+        if (!refill()) break;
+        scanned = pending;  // refill() moved the pending bytes to the front
+    }
+
+    // EOF: return the unterminated final line, if any
+    if (begin_ == end_) return false;
+    line = std::string_view(buf_.data() + begin_, end_ - begin_);
+    begin_ = end_;
+    ++line_number_;
+    return true;
+}
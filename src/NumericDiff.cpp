@@ -2,256 +2,1903 @@
 // -------------------------------------------------------------
 #include "NumericDiff.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
-#include <iomanip>
+#include <numeric>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
 #include <set>
-#include <sstream>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 #include "Formatter.hpp"
+#include "KeyIndex.hpp"
 #include "Printer.hpp"
+#include "ReferenceCache.hpp"
 #include "TextParser.hpp"
+#include "ThreadPool.hpp"
+#include "ToleranceKernel.hpp"
 
 namespace numdiff {
 
+namespace {
+// Writes buffered output before results reach the caller (who may print after it)
+class FlushOnExit {
+   public:
+    explicit FlushOnExit(Printer& printer) : printer_(printer) {}
+    ~FlushOnExit() { printer_.flush(); }
+
+    FlushOnExit(const FlushOnExit&) = delete;
+    FlushOnExit& operator=(const FlushOnExit&) = delete;
+
+   private:
+    Printer& printer_;
+};
+
+// Stable copies of lines from sources that reuse their buffer (--join index)
+class TextArena {
+   public:
+    std::string_view store(std::string_view text) {
+        if (blocks_.empty() || blocks_.back().capacity() - blocks_.back().size() < text.size()) {
+            blocks_.emplace_back();
+            blocks_.back().reserve(std::max(block_bytes, text.size()));
+            bytes_ += blocks_.back().capacity();
+        }
+        std::string& block = blocks_.back();
+        size_t offset = block.size();
+        block.append(text.data(), text.size());  // Within capacity: earlier views stay valid
+        return std::string_view(block).substr(offset, text.size());
+    }
+
+    size_t bytes() const noexcept { return bytes_; }
+
+   private:
+    static constexpr size_t block_bytes = 1 << 20;
+    std::deque<std::string> blocks_;
+    size_t bytes_ = 0;
+};
+
+/**
+ * Partition files of a spilled --join, removed on destruction
+ *
+ * file1 records are "<id> <physical> <home> <line>" (home is 0 for the
+ * copy of an edge row in its neighbor partition), file2 records are
+ * "<physical> <line>".
+ */
+class JoinSpill {
+   public:
+    explicit JoinSpill(size_t n_partitions) {
+        static std::atomic<unsigned> counter{0};
+        dir_ = std::filesystem::temp_directory_path() /
+               ("diff-numerics-join-" + std::to_string(::getpid()) + "-" +
+                std::to_string(counter++));
+        std::filesystem::create_directories(dir_);
+        for (size_t p = 0; p < n_partitions; ++p) {
+            files1_.emplace_back(path(1, p), std::ios::binary);
+            files2_.emplace_back(path(2, p), std::ios::binary);
+            if (!files1_.back() || !files2_.back())
+                throw std::runtime_error("Error: could not create join partition in " +
+                                         dir_.string());
+        }
+    }
+    ~JoinSpill() {
+        files1_.clear();
+        files2_.clear();
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    JoinSpill(const JoinSpill&) = delete;
+    JoinSpill& operator=(const JoinSpill&) = delete;
+
+    void write1(size_t p, std::uint64_t id, std::uint64_t physical, bool home,
+                std::string_view line) {
+        write(files1_[p], {id, physical, home ? 1U : 0U}, 3, line);
+    }
+    void write2(size_t p, std::uint64_t physical, std::string_view line) {
+        write(files2_[p], {physical, 0, 0}, 1, line);
+    }
+
+    /** Flush and close the partitions for reading */
+    void finish() {
+        for (auto* files : {&files1_, &files2_}) {
+            for (std::ofstream& file : *files) {
+                file.close();
+                if (!file) throw std::runtime_error("Error: could not write join partition.");
+            }
+        }
+    }
+
+    std::string path(int side, size_t p) const {
+        return (dir_ / (std::to_string(side) + "-" + std::to_string(p))).string();
+    }
+
+   private:
+    static void write(std::ofstream& file, std::array<std::uint64_t, 3> fields, size_t n,
+                      std::string_view line) {
+        char head[80];
+        char* out = head;
+        for (size_t i = 0; i < n; ++i) {
+            out = std::to_chars(out, head + sizeof(head), fields[i]).ptr;
+            *out++ = ' ';
+        }
+        file.write(head, out - head);
+        file.write(line.data(), static_cast<std::streamsize>(line.size()));
+        file.put('\n');
+    }
+
+    std::filesystem::path dir_;
+    std::vector<std::ofstream> files1_, files2_;
+};
+
+// Heap order of a --top list: the front is the kept difference that ranks last
+bool ranks_before(const ValueDifference& a, const ValueDifference& b) noexcept {
+    return a.ranks_before(b);
+}
+
+// Keep difference if it is among the k highest ranked ones in heap
+void offer_top(std::vector<ValueDifference>& heap, size_t k, const ValueDifference& difference) {
+    if (heap.size() < k) {
+        heap.push_back(difference);
+        std::push_heap(heap.begin(), heap.end(), ranks_before);
+    } else if (k > 0 && difference.ranks_before(heap.front())) {
+        std::pop_heap(heap.begin(), heap.end(), ranks_before);
+        heap.back() = difference;
+        std::push_heap(heap.begin(), heap.end(), ranks_before);
+    }
+}
+
+// Split the leading number off a partition record
+std::uint64_t take_field(std::string_view& record) {
+    std::uint64_t value = 0;
+    const char* end = std::from_chars(record.data(), record.data() + record.size(), value).ptr;
+    record.remove_prefix(std::min(record.size(), static_cast<size_t>(end - record.data()) + 1));
+    return value;
+}
+
+// n distinct indices drawn uniformly from [0, population), in increasing order (Floyd's
+// algorithm: one draw per index, whatever the population); all of them if n >= population
+std::vector<std::uint64_t> sample_indices(std::uint64_t population, std::uint64_t n,
+                                          std::uint64_t seed) {
+    std::vector<std::uint64_t> picks;
+    if (n >= population) {
+        picks.resize(population);
+        std::iota(picks.begin(), picks.end(), std::uint64_t{0});
+        return picks;
+    }
+    std::mt19937_64 rng(seed);
+    std::unordered_set<std::uint64_t> chosen;
+    chosen.reserve(n);
+    picks.reserve(n);
+    for (std::uint64_t j = population - n; j < population; ++j) {
+        std::uint64_t pick = std::uniform_int_distribution<std::uint64_t>(0, j)(rng);
+        if (!chosen.insert(pick).second) {
+            pick = j;  // Taken already: j itself is new
+            chosen.insert(j);
+        }
+        picks.push_back(pick);
+    }
+    std::sort(picks.begin(), picks.end());
+    return picks;
+}
+
+// 95% Wilson score interval of the sampled rate, narrowed by the finite population correction
+// (exact when every line pair was compared)
+void estimate_rate(SampleEstimate& sample) {
+    if (sample.n_sampled == 0) return;
+    double n = static_cast<double>(sample.n_sampled);
+    double p = static_cast<double>(sample.n_different) / n;
+    sample.rate = sample.lower = sample.upper = p;
+    if (sample.n_sampled >= sample.population) return;
+    double N = static_cast<double>(sample.population);
+    double z2 = 1.959963984540054 * 1.959963984540054 * (N - n) / (N - 1.0);
+    double denominator = 1.0 + z2 / n;
+    double center = (p + z2 / (2.0 * n)) / denominator;
+    double half = std::sqrt(z2 * (p * (1.0 - p) / n + z2 / (4.0 * n * n))) / denominator;
+    sample.lower = std::max(0.0, center - half);
+    sample.upper = std::min(1.0, center + half);
+}
+}  // namespace
+
 // Constructor: initialize with options and stdout printer
-NumericDiff::NumericDiff(const NumericDiffOptions& opts) : options_(opts), printer_(std::cout) {}
+NumericDiff::NumericDiff(const NumericDiffOptions& opts)
+    : options_(opts), columns_(opts.columns_to_compare), printer_(std::cout) {}
 
-// Open a file for reading and validate that it opened successfully
-std::ifstream NumericDiff::open_and_validate_file(const std::string& file_path) const {
-    std::ifstream fs(file_path);
-    if (!fs) throw std::runtime_error("Error: could not open file: " + file_path);
-    return fs;
+// Open a file as a line source (with --prefetch read-ahead) and validate that it opened
+std::unique_ptr<LineSource> NumericDiff::open_and_validate_file(
+    const std::string& file_path) const {
+    // Throws runtime_error if the file cannot be opened
+    return LineSource::open(file_path, options_.prefetch_bytes);
+}
+
+// Advance a source past comment lines to the next data line (or EOF)
+bool NumericDiff::next_data_line(LineSource& source, std::string_view& line,
+                                 RunStats* stats) const {
+    StageTimer timer(stats, RunStats::Stage::read);
+    while (source.next_line(line)) {
+        if (stats != nullptr) stats->bytes_read += line.size() + 1;
+        if (options_.comment_prefix.empty() ||
+            !TextParser::line_is_comment(line, options_.comment_prefix))
+            return true;
+        if (stats != nullptr) stats->comment_lines++;
+    }
+    line = std::string_view();
+    return false;
+}
+// Start collecting statistics for one run (only column errors without --stats)
+void NumericDiff::begin_stats() {
+    column_stats_.clear();
+    if (stats() == nullptr) return;
+    stats_ = RunStats();
+    stats_start_ = std::chrono::steady_clock::now();
+    stats_bytes_before_ = printer_.bytes_written();
+}
+
+// Rank the --top heap, then fold this instance's statistics and column errors into the result
+// (those of chunks are merged already)
+void NumericDiff::finish_run(NumericDiffResult& result) {
+    std::sort_heap(result.top.begin(), result.top.end(), ranks_before);
+    merge_columns(result.columns, column_stats_);
+    if (stats() == nullptr) return;
+    result.stats.merge(stats_);
+    result.stats.bytes_written = printer_.bytes_written() - stats_bytes_before_;
+    result.stats.wall_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             stats_start_)
+            .count());
+}
+
+// Explicit --format wins; otherwise .npy/HDF5 files are recognized by their magic bytes
+// (standard input is read as text)
+InputFormat NumericDiff::resolve_format(const std::string& path) const {
+    if (options_.input_format != InputFormat::automatic) return options_.input_format;
+    if (LineSource::is_stdin(path)) return InputFormat::text;
+    return ArraySource::detect(path);
+}
+
+// Run-time view of the options tested for every line
+NumericDiff::DynamicMode NumericDiff::dynamic_mode() const {
+    DynamicMode mode;
+    mode.print = !options_.only_equal && options_.top_k == 0 &&
+                 options_.records == RecordFormat::none;
+    mode.print_equal = mode.print && options_.side_by_side && !options_.suppress_common_lines;
+    mode.all_columns = columns_.all();
+    mode.column_stats = options_.column_stats != StatsFormat::none;
+    mode.skip_identical = options_.tolerance >= 0.0 && !mode.print_equal && !mode.column_stats;
+    return mode;
 }
 
 /**
- * Main comparison algorithm
+ * Dispatch to the line loop specialized for the active options
+ * 
+ * Each combination of output style and column filtering gets its own
+ * StaticMode, so f is instantiated into a loop where the per-line and
+ * per-token option tests are constants and fold away: e.g. with
+ * --only-equal over all columns the loop is the bare
+ * tokenize-parse-compare kernel. Negative tolerances, --column-stats
+ * (every line is compared) and options.specialize = false (the
+ * reference path of the benchmarks) take the generic loop over run-time
+ * flags instead.
+ */
+template <class F>
+decltype(auto) NumericDiff::with_mode(F&& f) const {
+    DynamicMode mode = dynamic_mode();
+    if (!options_.specialize || options_.tolerance < 0.0 || mode.column_stats) return f(mode);
+    if (!mode.print) {
+        if (mode.all_columns) return f(StaticMode<false, false, true>());
+        return f(StaticMode<false, false, false>());
+    }
+    if (mode.print_equal) {
+        if (mode.all_columns) return f(StaticMode<true, true, true>());
+        return f(StaticMode<true, true, false>());
+    }
+    if (mode.all_columns) return f(StaticMode<true, false, true>());
+    return f(StaticMode<true, false, false>());
+}
+
+/**
+ * Main comparison entry point
  * 
- * Reads both files line-by-line, skipping comment lines, and compares
- * corresponding non-comment lines. Accumulates statistics about differences.
- * Throws an exception if files have different numbers of non-comment lines.
+ * Binary inputs (.npy, raw, HDF5) are opened as arrays and compared row
+ * by row without any text parsing. Text files are opened as line
+ * sources (memory-mapped when possible). Both files must use the same
+ * kind of encoding.
  */
 NumericDiffResult NumericDiff::run() {
+    InputFormat format1 = resolve_format(options_.file1);
+    InputFormat format2 = resolve_format(options_.file2);
+    if (format1 != InputFormat::text || format2 != InputFormat::text) {
+        if (format1 == InputFormat::text || format2 == InputFormat::text)
+            throw std::runtime_error("Error: cannot compare a binary array with a text file (" +
+                                     options_.file1 + " is " + ArraySource::format_name(format1) +
+                                     ", " + options_.file2 + " is " +
+                                     ArraySource::format_name(format2) + ").");
+        std::unique_ptr<ArraySource> array1 =
+            ArraySource::open(options_.file1, format1, options_.shape, options_.dataset);
+        std::unique_ptr<ArraySource> array2 =
+            ArraySource::open(options_.file2, format2, options_.shape, options_.dataset);
+        if (options_.sample_lines > 0)
+            throw std::runtime_error("Error: --sample compares text inputs only.");
+        return run(*array1, *array2);
+    }
+
+    std::unique_ptr<LineSource> source1 = open_and_validate_file(options_.file1);
+    std::unique_ptr<LineSource> source2 = open_and_validate_file(options_.file2);
+
+    // --cache: file1 is read from its parsed sidecar (mapped text files only)
+    std::optional<std::string_view> text1 = source1->remaining();
+    bool paired = options_.resync_window == 0 && options_.join_columns.empty();
+    if (!options_.reference_cache.empty() && paired && text1) {
+        FlushOnExit flush_on_exit(printer_);
+        begin_stats();
+        std::unique_ptr<ReferenceCache> reference;
+        {
+            StageTimer timer(stats(), RunStats::Stage::read);
+            reference = open_reference_cache(*text1);
+        }
+        NumericDiffResult result = compare_cached(*reference, *text1, *source2);
+        finish_run(result);
+        return result;
+    }
+    return run(*source1, *source2);
+}
+
+/**
+ * Load the sidecar cache of file1, or build and store it
+ * 
+ * A missing or stale cache (file1 changed, other comment prefix) is
+ * rebuilt from the text and written back for the next run. Failing to
+ * write it only costs that next run a rebuild.
+ */
+std::unique_ptr<ReferenceCache> NumericDiff::open_reference_cache(std::string_view text1) const {
+    const std::string& path = options_.reference_cache;
+    std::unique_ptr<ReferenceCache> reference =
+        ReferenceCache::load(path, text1, options_.comment_prefix);
+    if (reference) return reference;
+    reference = ReferenceCache::build(text1, options_.comment_prefix);
+    if (!reference->write(path)) std::cerr << "Warning: could not write cache " << path << "\n";
+    return reference;
+}
+
+/**
+ * Comparison of a cached reference against a text source
+ * 
+ * Same pairing of data lines as compare_sources() (sequential engine):
+ * reference lines left over compare against empty lines, as do lines
+ * left over in file2, so only blank lines may be left over.
+ */
+NumericDiffResult NumericDiff::compare_cached(const ReferenceCache& reference,
+                                              std::string_view text1, LineSource& source2) {
     NumericDiffResult result;
-    std::ifstream fs1 = open_and_validate_file(options_.file1);
-    std::ifstream fs2 = open_and_validate_file(options_.file2);
+    std::string_view line2;
+    for (size_t i = 0; i < reference.n_lines(); ++i) {
+        bool has_line2 = next_data_line(source2, line2, stats());
+        if (accumulate(result, compare_cached_line(reference, i, text1, line2),
+                       reference.line(i).physical, source2.line_number()))
+            return result;  // --first-diff: stop at the first difference
+        if (!has_line2) line2 = std::string_view();  // Leftover reference lines: empty peers
+    }
+    while (next_data_line(source2, line2, stats())) {
+        if (compare_lines("", line2).second > 0.0)
+            throw std::runtime_error("Error: compare line on empty line resulted wrong.");
+    }
+    return result;
+}
 
-    std::string line1, line2;
-    bool file1_has_line = true, file2_has_line = true;
+/**
+ * Main comparison algorithm
+ * 
+ * Reads both sources line-by-line, skipping comment lines, and compares
+ * corresponding non-comment lines. Lines are views into the sources'
+ * buffers, so no per-line copies are made. Accumulates statistics about
+ * differences. Throws an exception if files have different numbers of
+ * non-comment lines.
+ * 
+ * With options.threads > 1 and two in-memory (mapped) sources the work
+ * is delegated to run_parallel(), which produces the same output.
+ * 
+ * When identical lines produce no output, runs of byte-identical lines
+ * in mapped inputs are skipped at memcmp speed before each line pair.
+ */
+NumericDiffResult NumericDiff::run(LineSource& source1, LineSource& source2) {
+    FlushOnExit flush_on_exit(printer_);
+    begin_stats();
+    NumericDiffResult result = compare_sources(source1, source2);
+    finish_run(result);
+    return result;
+}
+
+// Body of run(LineSource&, LineSource&)
+NumericDiffResult NumericDiff::compare_sources(LineSource& source1, LineSource& source2) {
+    if (!options_.join_columns.empty()) return compare_joined(source1, source2);
+    if (options_.resync_window > 0) return compare_resync(source1, source2);
+    if (options_.sample_lines > 0) {
+        std::optional<std::string_view> data1 = source1.remaining();
+        std::optional<std::string_view> data2 = source2.remaining();
+        if (!data1 || !data2)
+            throw std::runtime_error(
+                "Error: --sample needs both inputs in memory (uncompressed regular files).");
+        return compare_sampled(*data1, *data2);
+    }
+
+    // Chunked parallel engine when requested and both inputs are fully in memory
+    if (options_.threads > 1) {
+        std::optional<std::string_view> data1 = source1.remaining();
+        std::optional<std::string_view> data2 = source2.remaining();
+        if (data1 && data2) return run_parallel(*data1, *data2);
+    }
+    return with_mode(
+        [&](const auto& mode) { return compare_sequential(mode, source1, source2); });
+}
+
+// Line-paired comparison loop, with the per-line option tests resolved by mode
+template <class Mode>
+NumericDiffResult NumericDiff::compare_sequential(const Mode& mode, LineSource& source1,
+                                                  LineSource& source2) {
+    NumericDiffResult result;
+    std::string_view line1, line2;
     
     // Main comparison loop: read and compare non-comment lines from both files
-    while (file1_has_line && file2_has_line) {
-        // Advance file1 to next non-comment line (or EOF)
-        while (file1_has_line) {
-            if (!std::getline(fs1, line1)) {
-                file1_has_line = false;
-                line1.clear();
-                break;
-            }
-            if (options_.comment_prefix.empty() ||
-                !TextParser::line_is_comment(line1, options_.comment_prefix))
-                break;
-        }
-        
-        // Advance file2 to next non-comment line (or EOF)
-        while (file2_has_line) {
-            if (!std::getline(fs2, line2)) {
-                file2_has_line = false;
-                line2.clear();
-                break;
-            }
-            if (options_.comment_prefix.empty() ||
-                !TextParser::line_is_comment(line2, options_.comment_prefix))
-                break;
-        }
+    for (;;) {
+        // Fast path: jump over byte-identical regions (they cannot contain differences)
+        if (mode.skip_identical && !learning_layout()) skip_identical_lines(source1, source2);
+
+        // Advance both files to their next non-comment line (or EOF)
+        bool file1_has_line = next_data_line(source1, line1, stats());
+        bool file2_has_line = next_data_line(source2, line2, stats());
 
         // Both files reached EOF simultaneously - normal exit
         if (!file1_has_line && !file2_has_line) break;
 
         // Compare the current pair of non-comment lines
-        auto [is_diff, perc_err] = compare_lines(line1, line2);
-        if (is_diff) {
-            result.n_different_lines++;
-            if (perc_err > result.max_percentage_err) result.max_percentage_err = perc_err;
-        }
+        if (accumulate(result, compare_lines(mode, line1, line2), source1.line_number(),
+                       source2.line_number()))
+            return result;  // --first-diff: stop at the first difference
+        if (!file1_has_line || !file2_has_line) break;
     }
 
     // Verify that file1 has no remaining non-comment lines
-    while (std::getline(fs1, line1)) {
-        if (!options_.comment_prefix.empty() &&
-            TextParser::line_is_comment(line1, options_.comment_prefix))
-            continue;
-        if (compare_lines(line1, "").second > 0.0)
+    while (next_data_line(source1, line1, stats())) {
+        if (compare_lines(mode, line1, "").second > 0.0)
             throw std::runtime_error("Error: compare line on empty line resulted wrong.");
     }
 
     // Verify that file2 has no remaining non-comment lines
-    while (std::getline(fs2, line2)) {
-        if (!options_.comment_prefix.empty() &&
-            TextParser::line_is_comment(line2, options_.comment_prefix))
-            continue;
-        if (compare_lines("", line2).second > 0.0)
+    while (next_data_line(source2, line2, stats())) {
+        if (compare_lines(mode, "", line2).second > 0.0)
             throw std::runtime_error("Error: compare line on empty line resulted wrong.");
     }
     return result;
 }
 
 /**
- * Compare two lines token-by-token
+ * Comparison with realignment of inserted and deleted lines (--resync)
  * 
- * Tokenizes both lines, compares corresponding tokens, and formats output based on options.
- * Numeric tokens are compared with tolerance/threshold; non-numeric tokens are copied.
- * Returns a pair: (has_differences, max_percentage_error_in_line)
+ * Line pairs are compared as usual while they match (same key column,
+ * or without a key, same layout and values within tolerance). When the
+ * front lines do not match, the next resync_window lines of both files
+ * are searched for the nearest matching pair (d1, d2), closest to the
+ * diagonal first: the min(d1, d2) lines before it are compared as
+ * changed pairs, and the surplus lines of one file are reported as
+ * present in that file only. Without a match in the window all its
+ * lines are compared as changed pairs.
+ * 
+ * A search probes at most (window + 1)^2 pairs of already parsed lines
+ * and consumes at least one line, or the whole window when it fails,
+ * so the run stays linear in the input size, and only
+ * 2 * (window + 1) lines are held in memory. While the files are in
+ * step, byte-identical regions are skipped as in compare_sources(). Blank lines without a peer
+ * are dropped silently, as the line-paired comparison allows.
  */
-std::pair<bool, double> NumericDiff::compare_lines(const std::string& line1,
-                                                   const std::string& line2) {
-    // Split lines into whitespace-separated tokens
-    std::vector<std::string> tokens1 = TextParser::tokenize(line1);
-    std::vector<std::string> tokens2 = TextParser::tokenize(line2);
+NumericDiffResult NumericDiff::compare_resync(LineSource& source1, LineSource& source2) {
+    size_t window = options_.resync_window;
+    ResyncWindow w1, w2;
+    w1.ring.resize(window + 1);
+    w2.ring.resize(window + 1);
+    w1.copy = !source1.remaining();  // Mapped lines stay valid, streamed ones do not
+    w2.copy = !source2.remaining();
+    NumericDiffResult result;
 
-    // Require same number of columns in both lines
-    if (tokens1.size() != tokens2.size()) throw std::runtime_error("Column count mismatch");
+    // Compare the front lines as a pair (reported unmatched if their layouts differ)
+    auto compare_fronts = [&]() {
+        ResyncLine& a = w1[0];
+        ResyncLine& b = w2[0];
+        bool stop;
+        bool same = a.text == b.text;
+        if (!same) {
+            parse_resync_line(a);
+            parse_resync_line(b);
+        }
+        if (same || a.tokens.size() == b.tokens.size()) {
+            stop = accumulate(result, compare_resync_lines(a, b), a.physical, b.physical);
+        } else {
+            stop = report_unmatched(result, a.text, a.physical, true, b.physical) ||
+                   report_unmatched(result, b.text, b.physical, false, a.physical);
+        }
+        w1.pop_front();
+        w2.pop_front();
+        return stop;
+    };
 
-    // Storage for formatted output tokens and error messages
-    std::vector<std::string> output1, output2, errors;
-    std::vector<bool> is_diff;
-    std::string toPrint1, toPrint2, toPrintErrors;
-    std::pair<bool, double> res{};  // Return value: (has_diff, max_error)
+    bool skip_identical = can_skip_identical();
+    for (;;) {
+        // In step with nothing buffered: jump over byte-identical regions
+        if (skip_identical && w1.size == 0 && w2.size == 0)
+            skip_identical_lines(source1, source2);
+        fill_window(w1, source1, 1);
+        fill_window(w2, source2, 1);
+        if (w1.size == 0 && w2.size == 0) break;
 
-    // Calculate column widths for aligned output
-    std::vector<size_t> col_widths = Formatter::calculate_col_widths(tokens1, tokens2);
-    size_t n = col_widths.size();
+        // One file ended: the rest of the other has no peers
+        if (w1.size == 0 || w2.size == 0) {
+            bool in_file1 = w2.size == 0;
+            ResyncWindow& w = in_file1 ? w1 : w2;
+            LineSource& other = in_file1 ? source2 : source1;
+            if (report_unmatched(result, w[0].text, w[0].physical, in_file1,
+                                 other.line_number()))
+                return result;
+            w.pop_front();
+            continue;
+        }
 
-    bool any_error = false;                // Track if any differences found on this line
-    double max_diff_this_line = 0.0;       // Maximum percentage diff on this line
-    
-    // Compare each column/token pair
-    for (size_t i = 0; i < n; ++i) {
-        // Skip columns not in the comparison set (if specified)
-        if (!options_.columns_to_compare.empty() && options_.columns_to_compare.count(i + 1) == 0) {
-            continue;  // Column filtering: skip this column entirely
-        }
-        
-        // Numeric comparison: both tokens must be parseable as numbers
-        if (TextParser::string_is_numeric(tokens1[i]) &&
-            TextParser::string_is_numeric(tokens2[i])) {
-            double v1 = std::stod(tokens1[i]);
-            double v2 = std::stod(tokens2[i]);
-            double diff = percentage_difference(v1, v2);
-            
-            // Check if difference exceeds tolerance
-            if (std::abs(diff) > options_.tolerance) {
-                any_error = true;
-                if (std::abs(diff) > max_diff_this_line) max_diff_this_line = std::abs(diff);
-                
-                // Apply color formatting to highlight differences
-                std::string& t1 = tokens1[i];
-                std::string& t2 = tokens2[i];
-                if (options_.color_diff_digits) {
-                    Formatter::colorize_different_digits(t1, t2);  // Colorize only differing digits
-                } else {
-                    Formatter::make_red(t1);  // Colorize entire numbers
-                    Formatter::make_red(t2);
+        // In step: byte-identical or matching lines are a pair
+        if (w1[0].text == w2[0].text || rows_match(w1[0], w2[0])) {
+            if (compare_fronts()) return result;
+            continue;
+        }
+
+        // Out of step: nearest matching pair of the window, closest to the diagonal first
+        fill_window(w1, source1, window + 1);
+        fill_window(w2, source2, window + 1);
+        bool found = false;
+        size_t d1 = 0, d2 = 0;
+        for (size_t sum = 1; sum <= 2 * window && !found; ++sum) {
+            // Candidates with d1 + d2 == sum, by increasing |d1 - d2|
+            for (size_t skew = sum % 2; skew <= sum && !found; skew += 2) {
+                for (size_t a : {(sum + skew) / 2, (sum - skew) / 2}) {
+                    size_t b = sum - a;
+                    if (a < w1.size && b < w2.size && rows_match(w1[a], w2[b])) {
+                        d1 = a;
+                        d2 = b;
+                        found = true;
+                        break;
+                    }
+                    if (skew == 0) break;  // Both candidates are the same pair
                 }
-                output1.push_back(t1);
-                output2.push_back(t2);
-                is_diff.push_back(true);
-                
-                // Format the percentage error for display
-                std::ostringstream oss;
-                oss << std::setw(static_cast<int>(col_widths[i])) << std::setfill(' ') << std::right
-                    << diff << "%";
-                errors.push_back(oss.str());
-            } else {
-                // Within tolerance: no difference
-                output1.push_back(tokens1[i]);
-                output2.push_back(tokens2[i]);
-                is_diff.push_back(false);
-                errors.push_back(std::string(col_widths[i], ' '));
             }
+        }
+        // No pair of the window matches: its lines are compared as changed pairs
+        if (!found) d1 = d2 = std::min(w1.size, w2.size);
+
+        for (size_t k = std::min(d1, d2); k > 0; --k) {
+            if (compare_fronts()) return result;
+        }
+        for (; d1 > d2; --d1) {
+            if (report_unmatched(result, w1[0].text, w1[0].physical, true, w2[0].physical))
+                return result;
+            w1.pop_front();
+        }
+        for (; d2 > d1; --d2) {
+            if (report_unmatched(result, w2[0].text, w2[0].physical, false, w1[0].physical))
+                return result;
+            w2.pop_front();
+        }
+    }
+    return result;
+}
+
+// Append data lines to the ring, copying them when the source reuses its buffer
+void NumericDiff::fill_window(ResyncWindow& window, LineSource& source, size_t n) {
+    std::string_view line;
+    while (window.size < n && window.size < window.ring.size()) {
+        if (!next_data_line(source, line, stats())) return;
+        ResyncLine& entry = window.ring[(window.head + window.size) % window.ring.size()];
+        if (window.copy) {
+            entry.storage.assign(line.data(), line.size());
+            entry.text = entry.storage;
         } else {
-            // Non-numeric comparison: just copy tokens verbatim (no comparison)
-            output1.push_back(tokens1[i]);
-            output2.push_back(tokens2[i]);
-            is_diff.push_back(false);
-            errors.push_back(std::string(col_widths[i], ' '));
+            entry.text = line;
         }
+        entry.physical = source.line_number();
+        entry.parsed = false;
+        window.size++;
     }
+}
 
-    // Set return value based on whether differences were found
-    if (any_error) {
-        res.first = true;
-        res.second = max_diff_this_line;
+// Tokens and values are kept with the line: a line is probed many times in a search
+void NumericDiff::parse_resync_line(ResyncLine& line) {
+    if (line.parsed) return;
+    RunStats* st = stats();
+    {
+        StageTimer timer(st, RunStats::Stage::tokenize);
+        TextParser::tokenize(line.text, line.tokens);
     }
+    if (st != nullptr) st->tokens += line.tokens.size();
+    StageTimer timer(st, RunStats::Stage::parse);
+    line.values.resize(line.tokens.size());
+    line.numeric.resize(line.tokens.size());
+    for (size_t i = 0; i < line.tokens.size(); ++i) {
+        std::optional<double> v = TextParser::try_parse_number(line.tokens[i]);
+        line.numeric[i] = v.has_value();
+        line.values[i] = v.value_or(0.0);
+    }
+    line.parsed = true;
+}
 
-    // Skip printing if only_equal mode (just accumulate statistics)
-    if (options_.only_equal) {
-        return res;
+/**
+ * Kernel for a pair of window lines (like compare_lines)
+ * 
+ * The values parsed for matching are fed to the kernel directly, so a
+ * line is tokenized and parsed once however often it was probed.
+ * Both lines must have the same number of tokens.
+ */
+std::pair<bool, double> NumericDiff::compare_resync_lines(ResyncLine& a, ResyncLine& b) {
+    RunStats* st = stats();
+    if (st != nullptr) st->lines++;
+    if (a.text == b.text && can_skip_identical()) {
+        if (st != nullptr) st->identical_lines++;
+        return {false, 0.0};
     }
+    parse_resync_line(a);
+    parse_resync_line(b);
 
-    // Format and print the comparison results
-    if (options_.side_by_side) {
-        // Side-by-side format: columns aligned horizontally
-        if (options_.suppress_common_lines) {
-            if (any_error) {
-                printer_.print_side_by_side_tokens(output1, output2, col_widths,
-                                                   options_.line_length);
-            }
-            // else: suppress common lines (print nothing)
-        } else {
-            // Print all lines, both matching and differing
-            printer_.print_side_by_side_tokens(output1, output2, col_widths, options_.line_length);
+    size_t n = a.tokens.size();
+    verdicts_.assign(n, ColumnVerdict{});
+    values1_.clear();
+    values2_.clear();
+    value_columns_.clear();
+    size_t n_text = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!columns_.contains(i)) continue;
+        if (a.numeric[i] == 0 || b.numeric[i] == 0) {
+            verdicts_[i].kind = ColumnVerdict::Kind::text;
+            n_text++;
+            continue;
+        }
+        verdicts_[i].kind = ColumnVerdict::Kind::equal;
+        values1_.push_back(a.values[i]);
+        values2_.push_back(b.values[i]);
+        value_columns_.push_back(i);
+    }
+    std::pair<bool, double> res = apply_verdicts(n_text);
+    if (line_must_be_printed(res.first)) {
+        StageTimer timer(st, RunStats::Stage::render);
+        tokens1_.assign(a.tokens.begin(), a.tokens.end());
+        tokens2_.assign(b.tokens.begin(), b.tokens.end());
+        render_line();
+    }
+    return res;
+}
+
+/**
+ * Decide whether two lines are the same row
+ * 
+ * With key_column, the keys must be equal (as numbers within
+ * key_tolerance when both are numeric, as text otherwise); lines too short to have the key match
+ * only on their whole content. Otherwise every selected column must
+ * agree: numbers within tolerance and other tokens byte for byte.
+ */
+bool NumericDiff::rows_match(ResyncLine& a, ResyncLine& b) {
+    parse_resync_line(a);
+    parse_resync_line(b);
+    size_t key = options_.key_column;
+    if (key > 0 && key <= a.tokens.size() && key <= b.tokens.size()) {
+        size_t k = key - 1;
+        if (a.numeric[k] != 0 && b.numeric[k] != 0)
+            return std::abs(a.values[k] - b.values[k]) <= options_.key_tolerance;
+        return a.tokens[k] == b.tokens[k];
+    }
+    if (key > 0 && (key <= a.tokens.size() || key <= b.tokens.size())) return false;
+
+    if (a.tokens.size() != b.tokens.size()) return false;
+    for (size_t i = 0; i < a.tokens.size(); ++i) {
+        if (!columns_.contains(i)) continue;
+        if (a.numeric[i] != 0 && b.numeric[i] != 0) {
+            double diff = ToleranceKernel::percentage_difference(
+                a.values[i], b.values[i], options_.tolerance, options_.threshold);
+            if (diff > options_.tolerance) return false;
+        } else if (a.tokens[i] != b.tokens[i]) {
+            return false;
         }
+    }
+    return true;
+}
+
+/**
+ * Count and print a line without a peer
+ * 
+ * It counts as a differing line without a column or percentage error;
+ * as the first difference it is located by its own line and the line of
+ * the other file it would precede. Blank lines are dropped.
+ */
+bool NumericDiff::report_unmatched(NumericDiffResult& result, std::string_view text,
+                                   std::uint64_t physical, bool in_file1,
+                                   std::uint64_t other_line) {
+    {
+        StageTimer timer(stats(), RunStats::Stage::tokenize);
+        TextParser::tokenize(text, tokens1_);
+    }
+    if (tokens1_.empty()) return false;
+    if (RunStats* st = stats()) st->lines++;
+    if (in_file1) {
+        result.n_only_in1++;
     } else {
-        // Traditional diff format: < line1 / > line2 / >> errors
-        // Join tokens back into complete lines for output
-        auto join = [](const std::vector<std::string>& v) {
-            std::string out;
-            for (size_t i = 0; i < v.size(); ++i) {
-                if (i > 0) out += " ";
-                out += v[i];
+        result.n_only_in2++;
+    }
+    if (line_must_be_printed(true)) {
+        StageTimer timer(stats(), RunStats::Stage::render);
+        if (RunStats* st = stats()) st->lines_printed++;
+        colored_.clear();
+        for (std::string_view token : tokens1_) {
+            Formatter::append_red(colored_.text(), token);
+            colored_.close();
+        }
+        cells1_.clear();
+        for (size_t i = 0; i < tokens1_.size(); ++i)
+            cells1_.push_back({colored_.token(i), Formatter::visible_width(tokens1_[i])});
+        printer_.print_unmatched_cells(cells1_, in_file1, options_.side_by_side,
+                                       options_.line_length);
+    }
+    verdicts_.clear();  // No column to report
+    line_diffs_.clear();
+    return in_file1 ? accumulate(result, {true, 0.0}, physical, other_line, true, false)
+                    : accumulate(result, {true, 0.0}, other_line, physical, false, true);
+}
+
+/**
+ * Comparison of unordered rows paired by key (--join)
+ * 
+ * The data lines of file1 are hashed on their key columns (KeyIndex),
+ * then every data line of file2 takes the first unpaired file1 line
+ * with a matching key and is compared with it; file2 lines without one
+ * are reported as they come, unpaired file1 lines at the end, in file
+ * order. File1 lines are views into the mapped input, or copies for
+ * streamed inputs. Expected time is linear in the input size.
+ * 
+ * When the index outgrows options.join_memory, the comparison moves to
+ * compare_spilled(), which partitions both files on disk.
+ */
+NumericDiffResult NumericDiff::compare_joined(LineSource& source1, LineSource& source2) {
+    KeyIndex index(options_.join_columns, options_.key_tolerance);
+    std::vector<JoinRow> rows1;
+    TextArena arena;
+    bool copy = !source1.remaining();
+    std::string_view line;
+    while (next_data_line(source1, line, stats())) {
+        if (copy) line = arena.store(line);
+        rows1.push_back({line, source1.line_number()});
+        {
+            StageTimer timer(stats(), RunStats::Stage::parse);
+            index.add(line);
+        }
+        size_t bytes = arena.bytes() + rows1.capacity() * sizeof(JoinRow) + index.memory_bytes();
+        if (bytes > options_.join_memory) return compare_spilled(rows1, source1, source2);
+    }
+    index.build();
+
+    NumericDiffResult result;
+    while (next_data_line(source2, line, stats())) {
+        std::uint32_t id;
+        {
+            StageTimer timer(stats(), RunStats::Stage::parse);
+            id = index.take(line);
+        }
+        bool stop = id == KeyIndex::npos
+                        ? report_unmatched(result, line, source2.line_number(), false, 0)
+                        : accumulate(result, compare_lines(rows1[id].text, line),
+                                     rows1[id].physical, source2.line_number());
+        if (stop) return result;
+    }
+    for (std::uint32_t id = 0; id < rows1.size(); ++id) {
+        if (!index.taken(id) && report_unmatched(result, rows1[id].text, rows1[id].physical,
+                                                 true, 0))
+            return result;
+    }
+    return result;
+}
+
+/**
+ * External (Grace) hash join for inputs beyond the memory budget
+ * 
+ * Both files are written to join_partitions partition files by the key
+ * of their rows (KeyIndex::route), file1 rows at a partition edge of a
+ * tolerant key to both adjacent partitions. Each partition is then
+ * joined in memory like compare_joined(); a global bitmap over file1
+ * rows keeps edge copies from pairing twice, and unpaired file1 rows are
+ * reported after all partitions, from their home partition. Output is
+ * grouped by partition instead of following file2.
+ */
+NumericDiffResult NumericDiff::compare_spilled(const std::vector<JoinRow>& rows1,
+                                               LineSource& source1, LineSource& source2) {
+    KeyIndex router(options_.join_columns, options_.key_tolerance);
+    JoinSpill spill(join_partitions);
+    std::uint64_t n_rows1 = 0;
+    auto spill1 = [&](std::string_view text, std::uint64_t physical) {
+        KeyIndex::Route route = router.route(text, join_partitions);
+        spill.write1(route.home, n_rows1, physical, true, text);
+        if (route.neighbor != route.home)
+            spill.write1(route.neighbor, n_rows1, physical, false, text);
+        n_rows1++;
+    };
+    {
+        StageTimer timer(stats(), RunStats::Stage::read);
+        for (const JoinRow& row : rows1) spill1(row.text, row.physical);
+    }
+    std::string_view line;
+    while (next_data_line(source1, line, stats())) {
+        StageTimer timer(stats(), RunStats::Stage::read);
+        spill1(line, source1.line_number());
+    }
+    while (next_data_line(source2, line, stats())) {
+        StageTimer timer(stats(), RunStats::Stage::read);
+        spill.write2(router.route(line, join_partitions).home, source2.line_number(), line);
+    }
+    spill.finish();
+
+    NumericDiffResult result;
+    std::vector<std::uint8_t> taken(n_rows1, 0);
+    std::string_view record;
+    for (size_t p = 0; p < join_partitions; ++p) {
+        std::unique_ptr<LineSource> part1 = LineSource::open(spill.path(1, p));
+        bool copy = !part1->remaining();
+        TextArena arena;
+        KeyIndex index(options_.join_columns, options_.key_tolerance);
+        std::vector<JoinRow> rows;
+        std::vector<std::uint64_t> ids;
+        while (part1->next_line(record)) {
+            if (copy) record = arena.store(record);
+            std::uint64_t id = take_field(record);
+            std::uint64_t physical = take_field(record);
+            take_field(record);  // Home flag
+            rows.push_back({record, physical});
+            ids.push_back(id);
+            StageTimer timer(stats(), RunStats::Stage::parse);
+            index.add(record);
+            if (taken[id] != 0) index.set_taken(static_cast<std::uint32_t>(rows.size() - 1));
+        }
+        index.build();
+
+        std::unique_ptr<LineSource> part2 = LineSource::open(spill.path(2, p));
+        while (part2->next_line(record)) {
+            std::uint64_t physical = take_field(record);
+            std::uint32_t local;
+            {
+                StageTimer timer(stats(), RunStats::Stage::parse);
+                local = index.take(record);
+            }
+            if (local != KeyIndex::npos) taken[ids[local]] = 1;
+            bool stop = local == KeyIndex::npos
+                            ? report_unmatched(result, record, physical, false, 0)
+                            : accumulate(result, compare_lines(rows[local].text, record),
+                                         rows[local].physical, physical);
+            if (stop) return result;
+        }
+    }
+    for (size_t p = 0; p < join_partitions; ++p) {
+        std::unique_ptr<LineSource> part1 = LineSource::open(spill.path(1, p));
+        while (part1->next_line(record)) {
+            std::uint64_t id = take_field(record);
+            std::uint64_t physical = take_field(record);
+            bool home = take_field(record) != 0;
+            if (home && taken[id] == 0 && report_unmatched(result, record, physical, true, 0))
+                return result;
+        }
+    }
+    return result;
+}
+
+/**
+ * Binary array comparison
+ * 
+ * Rows play the role of lines and columns the role of tokens, with the
+ * same tolerance, threshold and --columns semantics as text input.
+ * Values are fed to the tolerance kernel in blocks of several rows:
+ * straight from the mapping when the file already holds native float64
+ * rows, otherwise after gathering the selected columns. Only rows that
+ * are printed are converted to text.
+ */
+NumericDiffResult NumericDiff::run(const ArraySource& array1, const ArraySource& array2) {
+    FlushOnExit flush_on_exit(printer_);
+    begin_stats();
+    NumericDiffResult result = compare_arrays(array1, array2);
+    finish_run(result);
+    return result;
+}
+
+// Body of run(const ArraySource&, const ArraySource&)
+NumericDiffResult NumericDiff::compare_arrays(const ArraySource& array1, const ArraySource& array2) {
+    if (array1.cols() != array2.cols()) throw std::runtime_error("Column count mismatch");
+    if (array1.rows() != array2.rows())
+        throw std::runtime_error("Error: arrays have a different number of rows (" +
+                                 std::to_string(array1.rows()) + " and " +
+                                 std::to_string(array2.rows()) + ").");
+
+    // Compared columns (0-based) and the full row layout used for printing
+    size_t n_cols = array1.cols();
+    std::vector<size_t> all_columns(n_cols);
+    std::iota(all_columns.begin(), all_columns.end(), size_t{0});
+    std::vector<size_t> selected;
+    for (size_t c : all_columns) {
+        if (columns_.contains(c)) selected.push_back(c);
+    }
+    size_t m = selected.size();
+
+    bool in_place = m == n_cols && array1.native_row(0) != nullptr &&
+                    array2.native_row(0) != nullptr;
+    bool print_equal = line_must_be_printed(false);
+    size_t rows_per_block = std::max<size_t>(1, array_block_values / std::max<size_t>(m, 1));
+    NumericDiffResult result;
+
+    for (size_t first = 0; first < array1.rows(); first += rows_per_block) {
+        size_t n_rows = std::min(rows_per_block, array1.rows() - first);
+        size_t n = n_rows * m;
+        const double* block1 = in_place ? array1.native_row(first) : nullptr;
+        const double* block2 = in_place ? array2.native_row(first) : nullptr;
+        if (!in_place) {
+            StageTimer timer(stats(), RunStats::Stage::read);
+            values1_.resize(n);
+            values2_.resize(n);
+            array1.read_rows(first, n_rows, selected, values1_.data());
+            array2.read_rows(first, n_rows, selected, values2_.data());
+            block1 = values1_.data();
+            block2 = values2_.data();
+        }
+        if (RunStats* st = stats()) {
+            st->lines += n_rows;
+            st->bytes_read += 2 * n_rows * n_cols * sizeof(double);  // As decoded float64
+            st->numeric_columns += n;
+        }
+        diffs_.resize(n);
+        diff_mask_.resize(n);
+        ToleranceKernel::BlockResult block;
+        {
+            StageTimer timer(stats(), RunStats::Stage::compare);
+            block = ToleranceKernel::compare_block(block1, block2, n, options_.tolerance,
+                                                   options_.threshold, diffs_.data(),
+                                                   diff_mask_.data());
+        }
+        if (options_.column_stats != StatsFormat::none) {
+            for (size_t r = 0; r < n_rows; ++r) {
+                record_column_errors(block1 + r * m, block2 + r * m, diff_mask_.data() + r * m,
+                                     selected.data(), m);
+            }
+        }
+        if (block.n_different == 0 && !print_equal) continue;  // Nothing to report in this block
+
+        for (size_t r = 0; r < n_rows; ++r) {
+            const std::uint8_t* mask = diff_mask_.data() + r * m;
+            bool is_diff = m > 0 && std::memchr(mask, 1, m) != nullptr;
+            if (!is_diff && !print_equal) continue;
+
+            // Per-column verdicts of the row, as compare_tokens() produces for text lines
+            double max_diff = 0.0;
+            verdicts_.assign(n_cols, ColumnVerdict{});
+            line_diffs_.clear();
+            for (size_t k = 0; k < m; ++k) {
+                ColumnVerdict& verdict = verdicts_[selected[k]];
+                verdict.kind = mask[k] != 0 ? ColumnVerdict::Kind::different
+                                            : ColumnVerdict::Kind::equal;
+                if (mask[k] == 0) continue;
+                verdict.diff = diffs_[r * m + k];
+                max_diff = std::max(max_diff, verdict.diff);
+                if (collects_differences()) {
+                    line_diffs_.push_back({verdict.diff, 0, 0, selected[k] + 1, block1[r * m + k],
+                                         block2[r * m + k]});
+                }
+            }
+
+            size_t row = first + r;
+            if (line_must_be_printed(is_diff)) {
+                StageTimer timer(stats(), RunStats::Stage::render);
+                row_values_.resize(n_cols);
+                array1.read_rows(row, 1, all_columns, row_values_.data());
+                format_row(row_values_.data(), n_cols, row_text1_, tokens1_);
+                array2.read_rows(row, 1, all_columns, row_values_.data());
+                format_row(row_values_.data(), n_cols, row_text2_, tokens2_);
+                render_line();
+            }
+            if (accumulate(result, {is_diff, max_diff}, row + 1, row + 1)) return result;
+        }
+    }
+    return result;
+}
+
+/**
+ * Format values with the shortest representation that round-trips
+ * 
+ * All values are written into text first and the token views are taken
+ * afterwards, so growing text cannot invalidate them.
+ */
+void NumericDiff::format_row(const double* values, size_t n, std::string& text,
+                             std::vector<std::string_view>& tokens) {
+    constexpr size_t max_chars = 32;  // Longest shortest-form double is 24 characters
+    text.resize(n * max_chars);
+    std::vector<size_t> ends(n);
+    char* out = text.data();
+    for (size_t i = 0; i < n; ++i) {
+        out = std::to_chars(out, text.data() + text.size(), values[i]).ptr;
+        ends[i] = static_cast<size_t>(out - text.data());
+    }
+    tokens.clear();
+    size_t begin = 0;
+    for (size_t end : ends) {
+        tokens.emplace_back(text.data() + begin, end - begin);
+        begin = end;
+    }
+}
+
+/**
+ * Compare a fixed number of non-comment line pairs
+ * 
+ * Used by the parallel engine, where each chunk knows in advance how
+ * many line pairs it owns (both sources are guaranteed to have them).
+ * Stops early when `cancelled` is raised by an earlier chunk. Returns
+ * true if it stopped on a difference because of --first-diff.
+ */
+template <class Mode>
+bool NumericDiff::compare_range(const Mode& mode, LineSource& source1, LineSource& source2,
+                                std::uint64_t n_lines, NumericDiffResult& result,
+                                const std::atomic<bool>* cancelled) {
+    std::string_view line1, line2;
+    for (std::uint64_t i = 0; i < n_lines; ++i) {
+        if (cancelled != nullptr && cancelled->load(std::memory_order_relaxed)) return false;
+        if (mode.skip_identical && !learning_layout()) {
+            // source1 is bounded by the chunk, so this never overshoots n_lines
+            i += skip_identical_lines(source1, source2);
+            if (i >= n_lines) break;
+        }
+        if (!next_data_line(source1, line1, stats()) || !next_data_line(source2, line2, stats()))
+            throw std::runtime_error("Error: chunk ended before its last line.");
+        if (accumulate(result, compare_lines(mode, line1, line2), source1.line_number(),
+                       source2.line_number()))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Decide whether identical lines can bypass the comparison kernel
+ * 
+ * Byte-identical lines never differ (equal values give a zero or NaN
+ * difference, neither of which exceeds a non-negative tolerance), so
+ * they only need processing when they are printed.
+ */
+bool NumericDiff::can_skip_identical() const {
+    return dynamic_mode().skip_identical;
+}
+
+/**
+ * Skip the common byte-identical lines at the front of two sources
+ * 
+ * Only in-memory sources are inspected in place; the identical region
+ * ends at the last newline before the first differing byte (or at the
+ * end of both inputs). Comment lines inside it are identical too, so
+ * line pairing is preserved. Returns the non-comment lines skipped.
+ */
+std::uint64_t NumericDiff::skip_identical_lines(LineSource& source1, LineSource& source2) {
+    StageTimer timer(stats(), RunStats::Stage::identity);
+    std::optional<std::string_view> data1 = source1.remaining();
+    if (!data1) return 0;
+    std::optional<std::string_view> data2 = source2.remaining();
+    if (!data2) return 0;
+
+    size_t n_bytes = identical_line_prefix(*data1, *data2);
+    if (n_bytes == 0) return 0;
+
+    // Count physical and non-comment lines of the skipped region
+    BufferLineSource region(data1->substr(0, n_bytes));
+    std::string_view line;
+    std::uint64_t n_data = 0;
+    while (next_data_line(region, line)) ++n_data;
+
+    source1.skip(n_bytes, region.line_number());
+    source2.skip(n_bytes, region.line_number());
+    if (RunStats* st = stats()) {
+        st->bytes_read += 2 * n_bytes;
+        st->lines += n_data;
+        st->identical_lines += n_data;
+        st->comment_lines += 2 * (region.line_number() - n_data);
+    }
+    return n_data;
+}
+
+/**
+ * Longest identical prefix of two buffers made of whole lines
+ * 
+ * Compares identity_block_bytes at a time with memcmp and narrows down
+ * the first differing byte only inside the block that contains it, so
+ * long identical regions are scanned at memory bandwidth. The result is
+ * cut back to just after the last newline, unless both buffers are
+ * identical to their very end.
+ */
+size_t NumericDiff::identical_line_prefix(std::string_view a, std::string_view b) noexcept {
+    size_t n = std::min(a.size(), b.size());
+    size_t pos = 0;
+    for (size_t stride = identity_block_bytes; stride > 0; stride /= 16) {
+        while (pos + stride <= n && std::memcmp(a.data() + pos, b.data() + pos, stride) == 0)
+            pos += stride;
+    }
+    // Strides go 4096, 256, 16, 1: pos is now the first difference (or n)
+
+    if (pos == a.size() && pos == b.size()) return pos;  // Identical to the end
+    size_t nl = pos == 0 ? std::string_view::npos : a.rfind('\n', pos - 1);
+    return nl == std::string_view::npos ? 0 : nl + 1;
+}
+
+/**
+ * Fold the outcome of one compared line pair into the running result
+ * 
+ * Records the location (file1 line, file2 line, column) of the first
+ * difference. Returns true when the caller must stop because
+ * --first-diff is set and this line differs.
+ */
+bool NumericDiff::accumulate(NumericDiffResult& result, std::pair<bool, double> line_result,
+                             std::uint64_t line1, std::uint64_t line2, bool only_in1,
+                             bool only_in2) {
+    auto [is_diff, perc_err] = line_result;
+    if (!is_diff) return false;
+
+    result.n_different_lines++;
+    if (perc_err > result.max_percentage_err) result.max_percentage_err = perc_err;
+    for (ValueDifference& difference : line_diffs_) {
+        difference.line1 = line1;
+        difference.line2 = line2;
+        offer_top(result.top, options_.top_k, difference);
+    }
+    if (options_.records != RecordFormat::none) {
+        if (line_diffs_.empty()) {  // Line in one file only (--resync, --join): 0 for the other
+            constexpr double none = std::numeric_limits<double>::quiet_NaN();
+            line_diffs_.push_back(
+                {perc_err, only_in2 ? 0 : line1, only_in1 ? 0 : line2, 0, none, none});
+        }
+        printer_.print_records(line_diffs_, options_.records);
+    }
+    if (result.n_different_lines == 1) {
+        result.first_diff.line1 = line1;
+        result.first_diff.line2 = line2;
+        for (size_t i = 0; i < verdicts_.size(); ++i) {
+            if (verdicts_[i].kind == ColumnVerdict::Kind::different) {
+                result.first_diff.column = i + 1;
+                break;
+            }
+        }
+    }
+    return options_.first_diff;
+}
+
+/**
+ * Split an input into byte ranges made of whole lines
+ * 
+ * Targets n_chunks equal-sized ranges, moving each cut forward to just
+ * after the next newline. Ranges may be empty for inputs with very long
+ * lines. Line counts are filled in later by count_lines().
+ */
+std::vector<NumericDiff::LineChunk> NumericDiff::split_into_chunks(std::string_view data,
+                                                                   size_t n_chunks) {
+    std::vector<LineChunk> chunks(n_chunks);
+    size_t begin = 0;
+    for (size_t k = 0; k < n_chunks; ++k) {
+        size_t end = data.size();
+        if (k + 1 < n_chunks) {
+            size_t target = std::max(begin, data.size() / n_chunks * (k + 1));
+            size_t nl = data.find('\n', target);
+            end = (nl == std::string_view::npos) ? data.size() : nl + 1;
+        }
+        chunks[k].bytes = data.substr(begin, end - begin);
+        begin = end;
+    }
+    return chunks;
+}
+
+// Count the non-comment and physical lines of a chunk
+void NumericDiff::count_lines(LineChunk& chunk) const {
+    BufferLineSource source(chunk.bytes);
+    std::string_view line;
+    std::uint64_t n = 0;
+    while (next_data_line(source, line)) ++n;
+    chunk.n_lines = n;
+    chunk.n_physical = source.line_number();
+}
+
+// Count the chunks of each input (in parallel with a pool), then number their lines
+void NumericDiff::count_chunks(std::initializer_list<std::vector<LineChunk>*> inputs,
+                               ThreadPool* pool) const {
+    if (pool != nullptr) {
+        std::vector<std::future<void>> counting;
+        for (std::vector<LineChunk>* chunks : inputs) {
+            for (LineChunk& chunk : *chunks) {
+                counting.push_back(pool->submit([this, &chunk] { count_lines(chunk); }));
+            }
+        }
+        for (std::future<void>& done : counting) {
+            pool->wait(done);
+            done.get();
+        }
+    }
+    for (std::vector<LineChunk>* chunks : inputs) {
+        std::uint64_t total = 0, physical = 0;
+        for (LineChunk& chunk : *chunks) {
+            if (pool == nullptr) count_lines(chunk);
+            chunk.first_line = std::exchange(total, total + chunk.n_lines);
+            chunk.first_physical = std::exchange(physical, physical + chunk.n_physical);
+        }
+    }
+}
+
+/**
+ * Create a source positioned on a given non-comment line
+ * 
+ * Finds the chunk that contains the line through its first_line index
+ * and skips the preceding lines of that chunk only.
+ */
+BufferLineSource NumericDiff::seek_data_line(std::string_view data,
+                                             const std::vector<LineChunk>& chunks,
+                                             std::uint64_t index) const {
+    auto it = std::upper_bound(chunks.begin(), chunks.end(), index,
+                               [](std::uint64_t i, const LineChunk& c) { return i < c.first_line; });
+    const LineChunk& chunk = *(it - 1);  // chunks[0].first_line == 0, so it > begin()
+
+    size_t offset = static_cast<size_t>(chunk.bytes.data() - data.data());
+    BufferLineSource source(data.substr(offset), chunk.first_physical);
+    std::string_view line;
+    for (std::uint64_t i = chunk.first_line; i < index; ++i) next_data_line(source, line);
+    return source;
+}
+
+/**
+ * Approximate comparison of a random sample of line pairs (--sample)
+ * 
+ * sample_lines distinct indices are drawn from the data lines present
+ * in both files (with a fixed seed, so reruns compare the same lines),
+ * and only those line pairs are compared. Lines are found through a
+ * line index of each input: with --fixed-width, a file whose data lines
+ * all have the length of its first one is indexed by arithmetic and only
+ * the sampled lines are read; otherwise the lines of fine chunks are
+ * counted first (in parallel with options.threads > 1), one pass at
+ * newline-scan speed instead of a full comparison. A sampled record that
+ * is not a data line (a comment, a newline inside) makes that file fall
+ * back to counting. The result holds the estimated difference rate and
+ * its confidence bounds; line numbers are physical, as in a full run.
+ */
+NumericDiffResult NumericDiff::compare_sampled(std::string_view data1, std::string_view data2) {
+    std::optional<ThreadPool> own_pool;
+    ThreadPool* pool = pool_;
+    if (pool == nullptr && options_.threads > 1) pool = &own_pool.emplace(options_.threads);
+    bool records = options_.fixed_width_lines > 0;
+    LineIndex index1, index2;
+    std::vector<std::uint64_t> picks;
+    {
+        StageTimer timer(stats(), RunStats::Stage::read);
+        index1 = index_lines(data1, records, pool);
+        index2 = index_lines(data2, records, pool);
+        for (bool aligned = false; !aligned;) {
+            picks = sample_indices(std::min(index1.n_lines, index2.n_lines),
+                                   options_.sample_lines, sample_seed);
+            aligned = true;
+            for (LineIndex* index : {&index1, &index2}) {
+                if (index->record_length == 0) continue;
+                if (std::all_of(picks.begin(), picks.end(),
+                                [&](std::uint64_t k) { return record_fits(*index, k); }))
+                    continue;
+                *index = index_lines(index->data, false, pool);
+                aligned = false;  // Line counts may change: draw again
+            }
+        }
+    }
+
+    NumericDiffResult result;
+    SampleEstimate& sample = result.sample;
+    sample.n_lines1 = index1.n_lines;
+    sample.n_lines2 = index2.n_lines;
+    sample.population = std::min(index1.n_lines, index2.n_lines);
+    for (std::uint64_t k : picks) {
+        std::uint64_t physical1 = 0, physical2 = 0;
+        std::string_view line1 = data_line(index1, k, physical1);
+        std::string_view line2 = data_line(index2, k, physical2);
+        if (RunStats* st = stats()) st->bytes_read += line1.size() + line2.size() + 2;
+        sample.n_sampled++;
+        if (accumulate(result, compare_lines(line1, line2), physical1, physical2))
+            break;  // --first-diff: stop at the first difference
+    }
+    sample.n_different = result.n_different_lines;
+    estimate_rate(sample);
+    return result;
+}
+
+// Records of one length when allowed and the input is laid out so, else counted chunks
+NumericDiff::LineIndex NumericDiff::index_lines(std::string_view data, bool records,
+                                                ThreadPool* pool) const {
+    LineIndex index;
+    index.data = data;
+    if (records && index_records(index)) return index;
+    index.record_length = 0;
+    index.chunks = split_into_chunks(data, std::max<size_t>(1, data.size() / sample_chunk_bytes));
+    count_chunks({&index.chunks}, pool);
+    index.n_lines = index.chunks.back().first_line + index.chunks.back().n_lines;
+    return index;
+}
+
+/**
+ * Index an input as fixed-length records
+ * 
+ * The first data line (after the header comments) gives the record
+ * length; the rest of the input must be a whole number of records, and
+ * the first fixed_width_lines of them must be back-to-back lines of that
+ * length. Later records are checked only when sampled (record_fits).
+ */
+bool NumericDiff::index_records(LineIndex& index) const {
+    BufferLineSource source(index.data);
+    std::string_view line;
+    if (!next_data_line(source, line)) return false;
+    index.first_physical = source.line_number() - 1;
+    index.record_offset = static_cast<size_t>(line.data() - index.data.data());
+    index.record_length = line.size() + 1;
+    size_t body = index.data.size() - index.record_offset;
+    if (body % index.record_length != 0) return false;
+    index.n_lines = body / index.record_length;
+    std::uint64_t n_checked = std::min<std::uint64_t>(options_.fixed_width_lines, index.n_lines);
+    for (std::uint64_t k = 1; k < n_checked; ++k) {
+        if (!source.next_line(line) || line.size() + 1 != index.record_length) return false;
+    }
+    return true;
+}
+
+// A record is a data line when it starts and ends one line, and is not a comment
+bool NumericDiff::record_fits(const LineIndex& index, std::uint64_t k) const {
+    size_t offset = index.record_offset + static_cast<size_t>(k) * index.record_length;
+    std::string_view line = index.data.substr(offset, index.record_length - 1);
+    bool starts_line = offset == 0 || index.data[offset - 1] == '\n';
+    bool ends_line = index.data[offset + line.size()] == '\n';
+    if (!starts_line || !ends_line || line.find('\n') != std::string_view::npos) return false;
+    return options_.comment_prefix.empty() ||
+           !TextParser::line_is_comment(line, options_.comment_prefix);
+}
+
+// Records are found by offset, counted lines by seeking from the start of their chunk
+std::string_view NumericDiff::data_line(const LineIndex& index, std::uint64_t k,
+                                        std::uint64_t& physical) const {
+    if (index.record_length > 0) {
+        physical = index.first_physical + k + 1;
+        return index.data.substr(index.record_offset + static_cast<size_t>(k) * index.record_length,
+                                 index.record_length - 1);
+    }
+    BufferLineSource source = seek_data_line(index.data, index.chunks, k);
+    std::string_view line;
+    next_data_line(source, line);
+    physical = source.line_number();
+    return line;
+}
+
+/**
+ * Chunked parallel comparison
+ * 
+ * 1. Split both inputs into line-aligned byte chunks and count their
+ *    non-comment lines in parallel, giving a global line numbering.
+ * 2. For each chunk of file1, a worker (its own NumericDiff with a
+ *    private output buffer) compares that chunk's line pairs, starting
+ *    file2 at the matching global line index.
+ * 3. Chunk outputs and results are merged in file order, so the printed
+ *    output is identical to the sequential engine.
+ * 
+ * Chunks run on a private pool of options.threads workers, or on the
+ * pool given to set_pool(); there this run is usually a task itself and
+ * waits by running chunks, while idle workers steal the others.
+ * 
+ * Errors (e.g. column count mismatch) surface in the same place as in
+ * the sequential engine: output before the failing line is printed,
+ * then the exception is rethrown.
+ */
+NumericDiffResult NumericDiff::run_parallel(std::string_view data1, std::string_view data2) {
+    size_t n_chunks = std::min(options_.threads * chunks_per_thread,
+                               std::max<size_t>(1, data1.size() / min_chunk_bytes));
+    std::optional<ThreadPool> own_pool;
+    ThreadPool& pool = pool_ != nullptr ? *pool_ : own_pool.emplace(options_.threads);
+
+    // Phase 1: line-aligned chunks and their non-comment line counts
+    std::vector<LineChunk> chunks1 = split_into_chunks(data1, n_chunks);
+    std::vector<LineChunk> chunks2 = split_into_chunks(data2, n_chunks);
+    count_chunks({&chunks1, &chunks2}, &pool);
+    std::uint64_t total1 = chunks1.back().first_line + chunks1.back().n_lines;
+    std::uint64_t total2 = chunks2.back().first_line + chunks2.back().n_lines;
+    std::uint64_t common = std::min(total1, total2);
+
+    // Phase 2: compare chunks of file1 against the aligned lines of file2
+    struct ChunkOutput {
+        OutputBuffer out;  // Collect-only buffer, merged in file order
+        NumericDiffResult result;
+    };
+    std::vector<ChunkOutput> outputs(chunks1.size());
+    std::vector<std::future<void>> work(chunks1.size());
+    NumericDiffOptions worker_options = options_;
+    worker_options.threads = 1;
+
+    // --first-diff: a chunk that trips cancels all later chunks (earlier ones must finish,
+    // since they may hold an even earlier difference)
+    std::unique_ptr<std::atomic<bool>[]> cancelled(new std::atomic<bool>[chunks1.size()]);
+    for (size_t j = 0; j < chunks1.size(); ++j) cancelled[j] = false;
+    auto cancel_after = [&](size_t j) {
+        for (size_t k = j + 1; k < chunks1.size(); ++k) cancelled[k] = true;
+    };
+
+    for (size_t j = 0; j < chunks1.size(); ++j) {
+        std::uint64_t first = chunks1[j].first_line;
+        std::uint64_t last = std::min(first + chunks1[j].n_lines, common);
+        if (first >= last) continue;
+        work[j] = pool.submit([&, j, first, last] {
+            NumericDiff worker(worker_options, outputs[j].out);
+            BufferLineSource source1(chunks1[j].bytes, chunks1[j].first_physical);
+            BufferLineSource source2 = seek_data_line(data2, chunks2, first);
+            bool stopped = worker.with_mode([&](const auto& mode) {
+                return worker.compare_range(mode, source1, source2, last - first,
+                                            outputs[j].result, &cancelled[j]);
+            });
+            outputs[j].result.stats = worker.stats_;
+            outputs[j].result.columns = std::move(worker.column_stats_);
+            if (stopped) cancel_after(j);
+        });
+    }
+
+    // Phase 3: ordered merge of outputs and results
+    NumericDiffResult result;
+    for (size_t j = 0; j < work.size(); ++j) {
+        if (!work[j].valid()) continue;
+        try {
+            pool.wait(work[j]);
+            work[j].get();
+        } catch (...) {
+            // Keep sequential semantics: print what preceded the error, then rethrow
+            printer_.print_raw(outputs[j].out.view());
+            cancel_after(j);
+            for (size_t k = j + 1; k < work.size(); ++k) {
+                if (work[k].valid()) pool.wait(work[k]);
+            }
+            throw;
+        }
+        printer_.print_raw(outputs[j].out.view());
+        std::string().swap(outputs[j].out.data());  // Release the chunk's buffer early
+
+        const NumericDiffResult& part = outputs[j].result;
+        result.n_different_lines += part.n_different_lines;
+        result.max_percentage_err = std::max(result.max_percentage_err, part.max_percentage_err);
+        if (result.first_diff.line1 == 0) result.first_diff = part.first_diff;
+        for (const ValueDifference& difference : part.top) {
+            offer_top(result.top, options_.top_k, difference);
+        }
+        result.stats.merge(part.stats);
+        merge_columns(result.columns, part.columns);
+
+        // --first-diff: this is the earliest difference, drop the remaining chunks
+        if (options_.first_diff && part.n_different_lines > 0) {
+            for (size_t k = j + 1; k < work.size(); ++k) {
+                if (work[k].valid()) pool.wait(work[k]);
             }
-            return out;
-        };
-        toPrint1 = join(output1);
-        toPrint2 = join(output2);
-        toPrintErrors = join(errors);
-        printer_.print_diff(toPrint1, toPrint2, toPrintErrors);
+            return result;
+        }
+    }
+
+    // Lines left over in the longer file must be blank (as in the sequential engine)
+    if (total1 != total2) {
+        bool file1_longer = total1 > total2;
+        BufferLineSource tail = file1_longer ? seek_data_line(data1, chunks1, common)
+                                             : seek_data_line(data2, chunks2, common);
+        std::string_view line;
+        while (next_data_line(tail, line)) {
+            auto [is_diff, perc_err] = file1_longer ? compare_lines(line, "") : compare_lines("", line);
+            if (is_diff || perc_err > 0.0)
+                throw std::runtime_error("Error: compare line on empty line resulted wrong.");
+        }
+    }
+    return result;
+}
+
+/**
+ * Compare two lines token-by-token
+ * 
+ * Two-phase design:
+ * 1. compare_tokens(): numeric-only kernel producing one verdict per column
+ * 2. render_line(): builds colored output strings, only for lines that
+ *    will actually be printed
+ * 
+ * In --only-equal mode, and for matching lines that would be
+ * suppressed anyway, the rendering stage is never entered, so a
+ * comparison is a pure tokenize-parse-compare loop, and byte-identical
+ * lines are not even tokenized. With --columns, lines that are only
+ * printed when they differ are first tokenized keeping just the
+ * selected columns; only a differing line is redone in full layout.
+ * 
+ * The option tests come from mode (see with_mode()), so the loops of
+ * compare_sequential() and compare_range() get a copy of this function
+ * without them. The overload without a mode dispatches per call, for the
+ * engines that compare lines one at a time (streaming, resync, join).
+ * Returns a pair: (has_differences, max_percentage_error_in_line)
+ */
+std::pair<bool, double> NumericDiff::compare_lines(std::string_view line1,
+                                                   std::string_view line2) {
+    return with_mode([&](const auto& mode) { return compare_lines(mode, line1, line2); });
+}
+
+template <class Mode>
+std::pair<bool, double> NumericDiff::compare_lines(const Mode& mode, std::string_view line1,
+                                                   std::string_view line2) {
+    // Identical bytes cannot differ: skip the kernel unless the line is printed anyway (or
+    // --fixed-width is still learning from the first lines)
+    RunStats* st = stats();
+    if (st != nullptr) st->lines++;
+    if (mode.skip_identical && line1 == line2 && !learning_layout()) {
+        if (st != nullptr) st->identical_lines++;
+        return {false, 0.0};
+    }
+
+    // Selected columns only, while the line is not known to be printed
+    if (!mode.all_columns && !mode.column_stats && !must_print(mode, false)) {
+        size_t n1, n2;
+        {
+            StageTimer timer(st, RunStats::Stage::tokenize);
+            n1 = split_selected(layout1_, line1, tokens1_);
+            n2 = split_selected(layout2_, line2, tokens2_);
+        }
+        if (st != nullptr) st->tokens += tokens1_.size() + tokens2_.size();
+        if (n1 != n2) throw std::runtime_error("Column count mismatch");
+        if (!compare_selected_tokens().first) return {false, 0.0};
+        // Differences are rare: redo the line below for verdicts and rendering
+    }
+
+    // Split lines into whitespace-separated tokens (views into the lines, buffers reused)
+    {
+        StageTimer timer(st, RunStats::Stage::tokenize);
+        split_line(layout1_, line1, tokens1_);
+        split_line(layout2_, line2, tokens2_);
+    }
+    if (st != nullptr) st->tokens += tokens1_.size() + tokens2_.size();
+
+    // Require same number of columns in both lines
+    if (tokens1_.size() != tokens2_.size()) throw std::runtime_error("Column count mismatch");
+
+    std::pair<bool, double> res = compare_tokens(mode);
+    if (must_print(mode, res.first)) {
+        StageTimer timer(st, RunStats::Stage::render);
+        render_line();
     }
     return res;
 }
 
 /**
- * Calculate percentage difference between two numeric values
+ * Numeric comparison kernel
+ * 
+ * Fills verdicts_ with one entry per token pair of tokens1_/tokens2_:
+ * skipped (column not selected), text (at least one side non-numeric),
+ * equal (within tolerance) or different (with its percentage error).
  * 
- * Handles special cases:
- * - Both near zero: returns 0 (no difference)
- * - One near zero, other not: returns "big" (infinite difference)
- * - Otherwise: returns |v1-v2| / max(|v1|,|v2|) * 100
+ * Works in two steps: numeric pairs are first parsed into contiguous
+ * value blocks, then the whole block goes through the batch tolerance
+ * kernel (SIMD when available). Performs no formatting and no allocation
+ * once the reused buffers have grown.
+ * Returns a pair: (has_differences, max_percentage_error_in_line)
  */
-double NumericDiff::percentage_difference(double value1, double value2) const {
-    // Both values near zero: treat as equal
-    if (std::abs(value1) < options_.threshold && std::abs(value2) < options_.threshold) {
-        return 0.0;
+template <class Mode>
+std::pair<bool, double> NumericDiff::compare_tokens(const Mode& mode) {
+    size_t n = tokens1_.size();
+    verdicts_.assign(n, ColumnVerdict{});
+    values1_.clear();
+    values2_.clear();
+    value_columns_.clear();
+
+    // Parse each selected column/token pair
+    size_t n_text = 0;
+    {
+        StageTimer timer(stats(), RunStats::Stage::parse);
+        for (size_t i = 0; i < n; ++i) {
+            // Skip columns not in the comparison set (if specified)
+            if (!mode.all_columns && !columns_.contains(i)) continue;  // Column filtering
+
+            // Numeric comparison: both tokens must be parseable as numbers (parsed once each)
+            std::optional<double> v1 = TextParser::try_parse_number(tokens1_[i]);
+            std::optional<double> v2 =
+                v1 ? TextParser::try_parse_number(tokens2_[i]) : std::nullopt;
+            if (!v1 || !v2) {
+                verdicts_[i].kind = ColumnVerdict::Kind::text;  // Non-numeric: copied verbatim
+                n_text++;
+                continue;
+            }
+            verdicts_[i].kind = ColumnVerdict::Kind::equal;  // Until the kernel says otherwise
+            values1_.push_back(*v1);
+            values2_.push_back(*v2);
+            value_columns_.push_back(i);
+        }
     }
-    
-    // One value near zero, other significant: treat as max difference
-    if ((std::abs(value1) < options_.threshold && std::abs(value2) >= options_.threshold) ||
-        (std::abs(value2) < options_.threshold && std::abs(value1) >= options_.threshold)) {
-        return big;
+    return apply_verdicts(n_text);
+}
+
+// Shared tail of the kernels with per-column verdicts
+std::pair<bool, double> NumericDiff::apply_verdicts(size_t n_text) {
+    if (RunStats* st = stats()) {
+        st->numeric_columns += values1_.size();
+        st->text_columns += n_text;
     }
-    
-    // Calculate relative percentage difference
-    double percentage_diff =
-        std::abs(value1 - value2) / std::max(std::abs(value1), std::abs(value2)) * 100.0;
-    
-    // Return 0 if within tolerance (treat as equal)
-    if (percentage_diff < options_.tolerance) {
-        return 0.0;
+
+    // Apply tolerance/threshold to the whole block at once
+    ToleranceKernel::BlockResult block = compare_values();
+    if (options_.column_stats != StatsFormat::none) {
+        record_column_errors(values1_.data(), values2_.data(), diff_mask_.data(),
+                             value_columns_.data(), values1_.size());
+    }
+    line_diffs_.clear();
+    if (block.n_different == 0) return {false, 0.0};
+
+    for (size_t k = 0; k < values1_.size(); ++k) {
+        if (diff_mask_[k] == 0) continue;
+        ColumnVerdict& verdict = verdicts_[value_columns_[k]];
+        verdict.kind = ColumnVerdict::Kind::different;
+        verdict.diff = diffs_[k];
+        if (collects_differences())
+            line_diffs_.push_back({diffs_[k], 0, 0, value_columns_[k] + 1, values1_[k], values2_[k]});
+    }
+    return {true, block.max_diff};
+}
+
+/**
+ * Comparison kernel for a cached reference line
+ * 
+ * Like compare_tokens(), with the file1 side taken from the cache:
+ * only line2 is tokenized and parsed. The reference line itself is
+ * tokenized only when it has to be printed (or for identity checks,
+ * which are a memcmp against the mapped text).
+ */
+std::pair<bool, double> NumericDiff::compare_cached_line(const ReferenceCache& reference,
+                                                         size_t index, std::string_view text1,
+                                                         std::string_view line2) {
+    const ReferenceCache::Line& cached = reference.line(index);
+    std::string_view line1 = text1.substr(cached.offset, cached.length);
+    RunStats* st = stats();
+    if (st != nullptr) st->lines++;
+    if (line1 == line2 && can_skip_identical() && !layout2_.learning()) {
+        if (st != nullptr) st->identical_lines++;
+        return {false, 0.0};
+    }
+    {
+        StageTimer timer(st, RunStats::Stage::tokenize);
+        split_line(layout2_, line2, tokens2_);
+    }
+    if (st != nullptr) st->tokens += cached.n_tokens + tokens2_.size();
+    if (tokens2_.size() != cached.n_tokens) throw std::runtime_error("Column count mismatch");
+
+    size_t n = tokens2_.size();
+    const double* values = reference.values() + cached.first_token;
+    const std::uint8_t* numeric = reference.numeric() + cached.first_token;
+    verdicts_.assign(n, ColumnVerdict{});
+    values1_.clear();
+    values2_.clear();
+    value_columns_.clear();
+    size_t n_text = 0;
+    {
+        StageTimer timer(st, RunStats::Stage::parse);
+        for (size_t i = 0; i < n; ++i) {
+            if (!columns_.contains(i)) continue;
+            std::optional<double> v2 =
+                numeric[i] != 0 ? TextParser::try_parse_number(tokens2_[i]) : std::nullopt;
+            if (!v2) {
+                verdicts_[i].kind = ColumnVerdict::Kind::text;
+                n_text++;
+                continue;
+            }
+            verdicts_[i].kind = ColumnVerdict::Kind::equal;
+            values1_.push_back(values[i]);
+            values2_.push_back(*v2);
+            value_columns_.push_back(i);
+        }
+    }
+    std::pair<bool, double> res = apply_verdicts(n_text);
+    if (line_must_be_printed(res.first)) {
+        StageTimer timer(st, RunStats::Stage::render);
+        split_line(layout1_, line1, tokens1_);
+        render_line();
+    }
+    return res;
+}
+
+/**
+ * Numeric kernel over pre-selected tokens
+ * 
+ * tokens1_/tokens2_ hold only selected columns (see tokenize_selected),
+ * so every pair is parsed and non-numeric pairs are ignored, as in
+ * compare_tokens(), but no per-column verdicts are recorded.
+ * Returns a pair: (has_differences, max_percentage_error_in_line)
+ */
+std::pair<bool, double> NumericDiff::compare_selected_tokens() {
+    values1_.clear();
+    values2_.clear();
+    {
+        StageTimer timer(stats(), RunStats::Stage::parse);
+        for (size_t i = 0; i < tokens1_.size(); ++i) {
+            std::optional<double> v1 = TextParser::try_parse_number(tokens1_[i]);
+            std::optional<double> v2 =
+                v1 ? TextParser::try_parse_number(tokens2_[i]) : std::nullopt;
+            if (!v1 || !v2) continue;
+            values1_.push_back(*v1);
+            values2_.push_back(*v2);
+        }
+    }
+    if (RunStats* st = stats()) {
+        st->numeric_columns += values1_.size();
+        st->text_columns += tokens1_.size() - values1_.size();
+    }
+    ToleranceKernel::BlockResult block = compare_values();
+    return {block.n_different > 0, block.max_diff};
+}
+
+// The table grows to the widest column seen
+void NumericDiff::record_column_errors(const double* values1, const double* values2,
+                                       const std::uint8_t* mask, const size_t* columns,
+                                       size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        if (columns[k] >= column_stats_.size()) column_stats_.resize(columns[k] + 1);
+        column_stats_[columns[k]].add(values1[k], values2[k], mask[k] != 0);
+    }
+}
+
+// Tolerance/threshold check of the gathered value block (SIMD when available)
+ToleranceKernel::BlockResult NumericDiff::compare_values() {
+    StageTimer timer(stats(), RunStats::Stage::compare);
+    size_t m = values1_.size();
+    diffs_.resize(m);
+    diff_mask_.resize(m);
+    return ToleranceKernel::compare_block(values1_.data(), values2_.data(), m, options_.tolerance,
+                                          options_.threshold, diffs_.data(), diff_mask_.data());
+}
+
+/**
+ * Decide whether the current line pair produces any output
+ * 
+ * - only_equal: never (only the final summary is printed)
+ * - side-by-side: every line, unless common lines are suppressed
+ * - unified diff: only lines with differences
+ */
+bool NumericDiff::line_must_be_printed(bool any_error) const {
+    if (options_.only_equal || options_.top_k > 0 || options_.records != RecordFormat::none)
+        return false;
+    if (options_.side_by_side && !options_.suppress_common_lines) return true;
+    return any_error;
+}
+
+/**
+ * Split a line of one file into tokens
+ *
+ * Once the file's --fixed-width layout is learned, lines that fit it are
+ * cut by offset; the others, and every line while the layout is still
+ * being learned (or without --fixed-width), go through the tokenizer.
+ */
+void NumericDiff::split_line(FixedWidthLayout& layout, std::string_view line,
+                             std::vector<std::string_view>& tokens) {
+    static const ColumnSelection every_column;
+    if (layout.slice(line, every_column, tokens)) {
+        if (RunStats* st = stats()) st->sliced_lines++;
+        return;
+    }
+    TextParser::tokenize(line, tokens);
+    layout.observe(line, tokens);
+}
+
+// Lines being learned from are tokenized whole, then narrowed to the selected columns
+size_t NumericDiff::split_selected(FixedWidthLayout& layout, std::string_view line,
+                                   std::vector<std::string_view>& tokens) {
+    if (layout.slice(line, columns_, tokens)) {
+        if (RunStats* st = stats()) st->sliced_lines++;
+        return layout.size();
+    }
+    if (!layout.learning()) return TextParser::tokenize_selected(line, columns_, tokens);
+    TextParser::tokenize(line, tokens);
+    layout.observe(line, tokens);
+    size_t n = tokens.size(), kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (columns_.contains(i)) tokens[kept++] = tokens[i];
+    }
+    tokens.resize(kept);
+    return n;
+}
+
+/**
+ * Rendering stage for one line pair
+ * 
+ * Builds the colored tokens and percentage error strings from the
+ * verdicts computed by compare_tokens() and hands them to the printer.
+ * Differing numbers are colored entirely, or only from the first
+ * differing digit when color_diff_digits is set.
+ * 
+ * Tokens within tolerance are passed as views of the input. Colored
+ * copies and error texts are rendered into reused arenas (TokenArena),
+ * and every cell carries its visible width, so no per-token strings are
+ * allocated once the buffers have grown.
+ */
+void NumericDiff::render_line() {
+    if (RunStats* st = stats()) st->lines_printed++;
+    const std::vector<std::string_view>& tokens1 = tokens1_;
+    const std::vector<std::string_view>& tokens2 = tokens2_;
+
+    // Calculate column widths for aligned output
+    Formatter::calculate_col_widths(tokens1, tokens2, col_widths_);
+    const std::vector<size_t>& col_widths = col_widths_;
+    size_t n = col_widths.size();
+    size_t max_width =
+        col_widths.empty() ? 0 : *std::max_element(col_widths.begin(), col_widths.end());
+    if (blanks_.size() < max_width) blanks_.assign(max_width, ' ');
+    cells1_.clear();
+    cells2_.clear();
+    error_cells_.clear();
+    colored_.clear();
+    errors_.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+        const ColumnVerdict& verdict = verdicts_[i];
+        if (verdict.kind == ColumnVerdict::Kind::skipped) continue;
+
+        if (verdict.kind == ColumnVerdict::Kind::different) {
+            // Apply color formatting to highlight differences
+            if (options_.color_diff_digits) {
+                // Colorize only differing digits
+                Formatter::append_different_digits(colored_, tokens1[i], tokens2[i]);
+            } else {
+                Formatter::append_red(colored_.text(), tokens1[i]);  // Colorize entire numbers
+                colored_.close();
+                Formatter::append_red(colored_.text(), tokens2[i]);
+                colored_.close();
+            }
+            cells1_.push_back({{}, Formatter::visible_width(tokens1[i])});  // Text set below
+            cells2_.push_back({{}, Formatter::visible_width(tokens2[i])});
+
+            // Format the percentage error for display, right-aligned in its column
+            char text[64];
+            int len = std::snprintf(text, sizeof(text), "%*g%%", static_cast<int>(col_widths[i]),
+                                    verdict.diff);
+            errors_.text().append(text, static_cast<size_t>(std::max(len, 0)));
+            errors_.close();
+            error_cells_.push_back({});  // Text set below once errors_ stops growing
+        } else {
+            // Within tolerance or non-numeric: tokens verbatim
+            cells1_.push_back({tokens1[i], Formatter::visible_width(tokens1[i])});
+            cells2_.push_back({tokens2[i], Formatter::visible_width(tokens2[i])});
+            error_cells_.push_back({std::string_view(blanks_.data(), col_widths[i]),
+                                    col_widths[i]});
+        }
+    }
+
+    // Point the colored and error cells into the finished arenas
+    size_t k = 0;
+    for (size_t c = 0; c < cells1_.size(); ++c) {
+        if (cells1_[c].text.data() != nullptr) continue;
+        cells1_[c].text = colored_.token(k++);
+        cells2_[c].text = colored_.token(k++);
+    }
+    k = 0;
+    for (Printer::Cell& cell : error_cells_) {
+        if (cell.text.data() != nullptr) continue;
+        std::string_view text = errors_.token(k++);
+        cell = {text, text.size()};
+    }
+
+    // Format and print the comparison results
+    if (options_.side_by_side) {
+        // Side-by-side format: columns aligned horizontally
+        printer_.print_side_by_side_cells(cells1_, cells2_, col_widths, options_.line_length);
+    } else {
+        // Traditional diff format: < line1 / > line2 / >> errors, tokens joined by spaces
+        printer_.print_diff_cells(cells1_, cells2_, error_cells_);
     }
-    
-    return percentage_diff;
 }
 
 }  // namespace numdiff
\ No newline at end of file
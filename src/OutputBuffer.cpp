@@ -0,0 +1,25 @@
+// OutputBuffer.cpp
+// -------------------------------------------------------------
+// Implementation of the batched output sink
+// -------------------------------------------------------------
+
+#include "OutputBuffer.hpp"
+
+// Reserve the first block up front
+OutputBuffer::OutputBuffer(std::ostream* os, size_t flush_threshold)
+    : os_(os), flush_threshold_(flush_threshold) {
+    if (os_ != nullptr) data_.reserve(flush_threshold_ + flush_threshold_ / 4);
+}
+
+// Never drop output that was committed to a stream
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+// One write(2)-sized block per call instead of one stream insertion per token
+void OutputBuffer::flush() {
+    if (os_ == nullptr || data_.empty()) return;
+    os_->write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    flushed_bytes_ += data_.size();
+    data_.clear();
+}
@@ -10,12 +10,20 @@
 #include "Printer.hpp"
 
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
 #include "Formatter.hpp"
 #include "NumericDiff.hpp"
 
+// Own a buffer over the stream
+Printer::Printer(std::ostream& os)
+    : owned_(std::make_unique<OutputBuffer>(&os)), out_(owned_.get()) {}
+
 /**
  * Print summary or detailed comparison results
  * 
@@ -30,30 +38,161 @@
  */
 void Printer::print(const numdiff::NumericDiffResult& result,
                     const numdiff::NumericDiffOptions& opts) {
+    std::ostringstream os;  // Summary lines are rare: format them with a stream
+    print_summary(os, result, opts);
+    print_raw(os.str());
+}
+
+// Values are printed with 17 significant digits: enough to tell any two doubles apart
+void Printer::print_top(std::ostream& os, const numdiff::NumericDiffResult& result,
+                        const numdiff::NumericDiffOptions& opts) {
+    os << "Comparing " << opts.file1 << " and " << opts.file2 << "\n";
+    os << "Tolerance: " << opts.tolerance << ", Threshold: " << opts.threshold << "\n";
+    if (result.n_different_lines == 0) {
+        os << "Files are EQUAL within tolerance.\n";
+        return;
+    }
+    os << "Files DIFFER: " << result.n_different_lines
+       << " lines differ, max percentage error: " << result.max_percentage_err << "%\n";
+    print_unmatched(os, result, opts);
+    if (result.top.empty()) return;  // Only unmatched lines differ
+
+    os << "Largest " << result.top.size() << " differences:\n";
+    os << std::setw(6) << "rank" << std::setw(10) << "line1" << std::setw(10) << "line2"
+       << std::setw(8) << "column" << std::setw(25) << "value1" << std::setw(25) << "value2"
+       << "  error (%)\n";
+    for (size_t i = 0; i < result.top.size(); ++i) {
+        const numdiff::ValueDifference& d = result.top[i];
+        os << std::setw(6) << i + 1 << std::setw(10) << d.line1 << std::setw(10) << d.line2
+           << std::setw(8) << d.column << std::setprecision(17) << std::setw(25) << d.value1
+           << std::setw(25) << d.value2 << std::setprecision(6) << "  " << d.error << "\n";
+    }
+}
+
+// Rates are printed as percentages
+void Printer::print_sample(std::ostream& os, const numdiff::NumericDiffResult& result,
+                           const numdiff::NumericDiffOptions& opts) {
+    const numdiff::SampleEstimate& sample = result.sample;
+    os << "Sampled " << sample.n_sampled << " of " << sample.population << " line pairs of "
+       << opts.file1 << " and " << opts.file2 << ": " << sample.n_different << " differ\n";
+    os << "Estimated difference rate: " << 100.0 * sample.rate << "% (95% confidence: "
+       << 100.0 * sample.lower << "% to " << 100.0 * sample.upper << "%)\n";
+    if (sample.n_lines1 != sample.n_lines2)
+        os << "Warning: " << opts.file1 << " has " << sample.n_lines1 << " data lines, "
+           << opts.file2 << " has " << sample.n_lines2 << "; only the first "
+           << sample.population << " were sampled\n";
+}
+
+// Columns that were never compared as numbers are left out
+void Printer::print_column_stats(std::ostream& os, const numdiff::NumericDiffResult& result,
+                                 const numdiff::NumericDiffOptions& opts) {
+    using numdiff::ColumnErrorStats;
+    auto compared = [](const ColumnErrorStats& c) { return c.pairs > 0 || c.nonfinite > 0; };
+    auto label = [](size_t k) {  // "[lower, upper)"; the last bin is closed at 200%
+        bool last = k + 1 == ColumnErrorStats::n_bins;
+        std::ostringstream text;
+        text << '[' << ColumnErrorStats::bin_lower_edge(k) << ", "
+             << (last ? 200.0 : ColumnErrorStats::bin_lower_edge(k + 1)) << (last ? ']' : ')');
+        return text.str();
+    };
+
+    std::ostringstream out;
+    if (opts.column_stats == numdiff::StatsFormat::json) {
+        auto quoted = [](const std::string& text) {
+            std::string q = "\"";
+            for (char c : text) {
+                if (c == '"' || c == '\\') q += '\\';
+                q += c;
+            }
+            return q + '"';
+        };
+        out << std::setprecision(17);
+        out << "{\"file1\":" << quoted(opts.file1) << ",\"file2\":" << quoted(opts.file2)
+            << ",\"histogram_edges\":[";
+        for (size_t k = 1; k < ColumnErrorStats::n_bins; ++k) {
+            out << (k > 1 ? "," : "") << ColumnErrorStats::bin_lower_edge(k);
+        }
+        out << "],\"columns\":[";
+        bool first = true;
+        for (size_t i = 0; i < result.columns.size(); ++i) {
+            const ColumnErrorStats& c = result.columns[i];
+            if (!compared(c)) continue;
+            out << (first ? "" : ",") << "{\"column\":" << i + 1 << ",\"pairs\":" << c.pairs
+                << ",\"different\":" << c.different << ",\"nonfinite\":" << c.nonfinite
+                << ",\"max_abs\":" << c.max_abs << ",\"mean_abs\":" << c.mean_abs
+                << ",\"rms_abs\":" << c.rms_abs() << ",\"max_rel\":" << c.max_rel
+                << ",\"mean_rel\":" << c.mean_rel << ",\"rms_rel\":" << c.rms_rel()
+                << ",\"histogram\":[";
+            for (size_t k = 0; k < ColumnErrorStats::n_bins; ++k) {
+                out << (k > 0 ? "," : "") << c.histogram[k];
+            }
+            out << "]}";
+            first = false;
+        }
+        out << "]}\n";
+    } else {
+        out << "Column error statistics of " << opts.file1 << " and " << opts.file2 << ":\n";
+        out << std::setw(8) << "column" << std::setw(12) << "pairs" << std::setw(11)
+            << "different" << std::setw(11) << "nonfinite" << std::setw(12) << "max abs"
+            << std::setw(12) << "mean abs" << std::setw(12) << "rms abs" << std::setw(12)
+            << "max rel %" << std::setw(12) << "mean rel %" << std::setw(12) << "rms rel %"
+            << "\n";
+        out << std::scientific << std::setprecision(3);
+        for (size_t i = 0; i < result.columns.size(); ++i) {
+            const ColumnErrorStats& c = result.columns[i];
+            if (!compared(c)) continue;
+            out << std::setw(8) << i + 1 << std::setw(12) << c.pairs << std::setw(11)
+                << c.different << std::setw(11) << c.nonfinite << std::setw(12) << c.max_abs
+                << std::setw(12) << c.mean_abs << std::setw(12) << c.rms_abs() << std::setw(12)
+                << c.max_rel << std::setw(12) << c.mean_rel << std::setw(12) << c.rms_rel()
+                << "\n";
+        }
+        out << std::defaultfloat << "Relative error histogram (%, pairs per bin):\n";
+        for (size_t i = 0; i < result.columns.size(); ++i) {
+            const ColumnErrorStats& c = result.columns[i];
+            if (c.pairs == 0) continue;
+            out << "  column " << i + 1 << ":";
+            const char* separator = " ";
+            for (size_t k = 0; k < ColumnErrorStats::n_bins; ++k) {
+                if (c.histogram[k] == 0) continue;
+                out << separator << label(k) << " " << c.histogram[k];
+                separator = ", ";
+            }
+            out << "\n";
+        }
+    }
+    os << out.str();
+}
+
+// Summary text for quiet and only-equal modes
+void Printer::print_summary(std::ostream& os, const numdiff::NumericDiffResult& result,
+                            const numdiff::NumericDiffOptions& opts) {
     // Quiet mode: suppress all output if files match
     if (opts.quiet) {
         if (result.n_different_lines == 0) {
             return;  // Files match, print nothing
         } else {
             // Files differ: print brief summary
-            os_ << "Comparing " << opts.file1 << " and " << opts.file2 << "\n";
-            os_ << "Tolerance: " << opts.tolerance << ", Threshold: " << opts.threshold << "\n";
-            os_ << "Files DIFFER: " << result.n_different_lines
+            os << "Comparing " << opts.file1 << " and " << opts.file2 << "\n";
+            os << "Tolerance: " << opts.tolerance << ", Threshold: " << opts.threshold << "\n";
+            os << "Files DIFFER: " << result.n_different_lines
                 << " lines differ, max percentage error: " << result.max_percentage_err << "%\n";
+            print_unmatched(os, result, opts);
         }
         return;
     }
 
     // Only-equal mode: just report whether files match or differ
     if (opts.only_equal) {
-        os_ << "Comparing " << opts.file1 << " and " << opts.file1 << "\n";
-        os_ << "Tolerance: " << opts.tolerance << ", Threshold: " << opts.threshold << "\n";
+        os << "Comparing " << opts.file1 << " and " << opts.file1 << "\n";
+        os << "Tolerance: " << opts.tolerance << ", Threshold: " << opts.threshold << "\n";
         if (result.n_different_lines == 0) {
-            os_ << "Files are EQUAL within tolerance.\n";
+            os << "Files are EQUAL within tolerance.\n";
             return;
         } else {
-            os_ << "Files DIFFER: " << result.n_different_lines
+            os << "Files DIFFER: " << result.n_different_lines
                 << " lines differ, max percentage error: " << result.max_percentage_err << "%\n";
+            print_unmatched(os, result, opts);
         }
         return;
     }
@@ -75,53 +214,61 @@ void Printer::print(const numdiff::NumericDiffResult& result,
 void Printer::print_side_by_side_tokens(const std::vector<std::string>& tokens1,
                                         const std::vector<std::string>& tokens2,
                                         const std::vector<size_t>& col_widths, int line_length) {
-    std::ostringstream oss1, oss2;  // Build output strings for both files
-    size_t ncols = std::max(tokens1.size(), tokens2.size());
-    
+    // Measure each token once (visible width excludes ANSI codes)
+    cells1_.clear();
+    cells2_.clear();
+    for (const std::string& t : tokens1) cells1_.push_back({t, Formatter::visible_width(t)});
+    for (const std::string& t : tokens2) cells2_.push_back({t, Formatter::visible_width(t)});
+    print_side_by_side_cells(cells1_, cells2_, col_widths, line_length);
+}
+
+/**
+ * Print cells side-by-side with column alignment
+ * 
+ * Builds both lines in reusable buffers, padding each column to the
+ * larger of its width and the cells' visible widths, then appends them
+ * truncated to line_length visible characters (colors preserved) to the
+ * output buffer, separated by "|" if the line has differences.
+ */
+void Printer::print_side_by_side_cells(const std::vector<Cell>& cells1,
+                                       const std::vector<Cell>& cells2,
+                                       const std::vector<size_t>& col_widths, int line_length) {
+    line1_.clear();
+    line2_.clear();
+    size_t ncols = std::max(cells1.size(), cells2.size());
+
     // Build each column with proper padding
     for (size_t i = 0; i < ncols; ++i) {
-        // Get tokens for this column (empty string if column doesn't exist)
-        std::string t1 = (i < tokens1.size()) ? tokens1[i] : "";
-        std::string t2 = (i < tokens2.size()) ? tokens2[i] : "";
-        
-        // Strip ANSI codes to get actual visible width
-        std::string t1_stripped = Formatter::strip_ansi(t1);
-        std::string t2_stripped = Formatter::strip_ansi(t2);
-        
+        // Get cells for this column (empty if column doesn't exist)
+        Cell c1 = (i < cells1.size()) ? cells1[i] : Cell{{}, 0};
+        Cell c2 = (i < cells2.size()) ? cells2[i] : Cell{{}, 0};
+
         // Determine column width: max of specified width and actual token widths
         // This ensures values are never truncated
         size_t colw = (i < col_widths.size()) ? col_widths[i] : static_cast<size_t>(line_length);
-        colw = std::max({colw, t1_stripped.size(), t2_stripped.size()});
-        
-        // Add token to first file's output with padding
-        oss1 << t1;
-        if (t1_stripped.size() < colw) oss1 << std::string(colw - t1_stripped.size(), ' ');
-        
-        // Add token to second file's output with padding
-        oss2 << t2;
-        if (t2_stripped.size() < colw) oss2 << std::string(colw - t2_stripped.size(), ' ');
-        
+        colw = std::max({colw, c1.width, c2.width});
+
+        line1_.append(c1.text.data(), c1.text.size()).append(colw - c1.width, ' ');
+        line2_.append(c2.text.data(), c2.text.size()).append(colw - c2.width, ' ');
+
         // Add space between columns (except after last column)
         if (i + 1 < ncols) {
-            oss1 << " ";
-            oss2 << " ";
+            line1_ += ' ';
+            line2_ += ' ';
         }
     }
-    
-    std::string l1 = oss1.str();
-    std::string l2 = oss2.str();
-    
-    // Choose separator based on whether differences exist
-    // Red color indicates differences
-    bool has_red = (Formatter::string_is_red(l1) || Formatter::string_is_red(l2));
-    const char* sep = has_red ? "   |   " : "       ";  // | for diffs, spaces for matches
-    
-    // Truncate lines to specified visible length (preserving ANSI codes)
-    l1 = Formatter::extract_visible_prefix(l1, static_cast<size_t>(line_length));
-    l2 = Formatter::extract_visible_prefix(l2, static_cast<size_t>(line_length));
-    
-    // Print: file1_line   separator   file2_line
-    os_ << l1 << sep << l2 << "\n";
+
+    // Choose separator based on whether differences exist (red color present)
+    bool has_red = cells_are_red(cells1) || cells_are_red(cells2);
+    std::string_view sep = has_red ? "   |   " : "       ";
+
+    // Print: file1_line   separator   file2_line (each truncated to line_length)
+    std::string& out = out_->data();
+    Formatter::append_visible_prefix(out, line1_, static_cast<size_t>(line_length));
+    out.append(sep.data(), sep.size());
+    Formatter::append_visible_prefix(out, line2_, static_cast<size_t>(line_length));
+    out += '\n';
+    out_->commit();
 }
 
 /**
@@ -137,15 +284,198 @@ void Printer::print_side_by_side_tokens(const std::vector<std::string>& tokens1,
  */
 void Printer::print_diff(const std::string& output1, const std::string& output2,
                          const std::string& errors) {
-    // Check if either line contains differences (has red highlighting)
-    bool has_red1 = Formatter::string_is_red(output1);
-    bool has_red2 = Formatter::string_is_red(output2);
-    
-    // Only print if differences exist
-    if (has_red1 || has_red2) {
-        os_ << '\n';                       // Blank line before diff block
-        os_ << "< " << output1 << "\n";   // File 1 line
-        os_ << "> " << output2 << "\n";   // File 2 line
-        os_ << ">>" << errors << "\n";     // Percentage errors
+    // Only print if either line contains differences (has red highlighting)
+    if (!Formatter::string_is_red(output1) && !Formatter::string_is_red(output2)) return;
+
+    out_->append('\n');   // Blank line before diff block
+    out_->append("< ");    // File 1 line
+    out_->append(output1);
+    out_->append("\n> ");  // File 2 line
+    out_->append(output2);
+    out_->append("\n>>");  // Percentage errors
+    out_->append(errors);
+    out_->append('\n');
+    out_->commit();
+}
+
+// Unified diff from cells: same layout as print_diff on the space-joined cells
+void Printer::print_diff_cells(const std::vector<Cell>& cells1, const std::vector<Cell>& cells2,
+                               const std::vector<Cell>& errors) {
+    if (!cells_are_red(cells1) && !cells_are_red(cells2)) return;
+
+    auto join = [this](const std::vector<Cell>& cells) {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            if (i > 0) out_->append(' ');
+            out_->append(cells[i].text);
+        }
+    };
+    out_->append("\n< ");
+    join(cells1);
+    out_->append("\n> ");
+    join(cells2);
+    out_->append("\n>>");
+    join(errors);
+    out_->append('\n');
+    out_->commit();
+}
+
+// Unmatched lines carry no error line: there is no peer to compare with
+void Printer::print_unmatched_cells(const std::vector<Cell>& cells, bool in_file1,
+                                    bool side_by_side, int line_length) {
+    line1_.clear();
+    size_t width = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (i > 0) line1_ += ' ';
+        line1_.append(cells[i].text.data(), cells[i].text.size());
+        width += cells[i].width + (i > 0 ? 1 : 0);
+    }
+
+    std::string& out = out_->data();
+    if (!side_by_side) {
+        out.append(in_file1 ? "\n< " : "\n> ");
+        out.append(line1_);
+    } else if (in_file1) {
+        Formatter::append_visible_prefix(out, line1_, static_cast<size_t>(line_length));
+        out.append("   <");
+    } else {
+        out.append(std::min(width, static_cast<size_t>(line_length)), ' ');
+        out.append("   >   ");
+        Formatter::append_visible_prefix(out, line1_, static_cast<size_t>(line_length));
+    }
+    out += '\n';
+    out_->commit();
+}
+
+namespace {
+// Shortest round-trip text of a JSON number (null if not finite)
+void append_json_number(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    char buffer[32];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    out.append(buffer, static_cast<size_t>(end - buffer));
+}
+
+void append_json_number(std::string& out, std::uint64_t value) {
+    char buffer[24];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    out.append(buffer, static_cast<size_t>(end - buffer));
+}
+}  // namespace
+
+// Records are built straight into the output buffer: no stream, ANSI or width work
+void Printer::print_records(const std::vector<numdiff::ValueDifference>& differences,
+                            numdiff::RecordFormat format) {
+    std::string& out = out_->data();
+    auto append_line = [&out](std::uint64_t line) {  // 1-based: 0 is a line missing from the file
+        if (line > 0) {
+            append_json_number(out, line);
+        } else {
+            out.append("null");
+        }
+    };
+    for (const numdiff::ValueDifference& d : differences) {
+        if (format == numdiff::RecordFormat::binary) {
+            char record[record_size];
+            auto column = static_cast<std::uint32_t>(d.column);
+            std::memcpy(record, &d.line1, 8);
+            std::memcpy(record + 8, &d.line2, 8);
+            std::memcpy(record + 16, &column, 4);
+            std::memcpy(record + 20, &d.value1, 8);
+            std::memcpy(record + 28, &d.value2, 8);
+            std::memcpy(record + 36, &d.error, 8);
+            out.append(record, record_size);
+            continue;
+        }
+        out.append("{\"line1\":");
+        append_line(d.line1);
+        out.append(",\"line2\":");
+        append_line(d.line2);
+        out.append(",\"column\":");
+        append_json_number(out, static_cast<std::uint64_t>(d.column));
+        out.append(",\"v1\":");
+        append_json_number(out, d.value1);
+        out.append(",\"v2\":");
+        append_json_number(out, d.value2);
+        out.append(",\"err\":");
+        append_json_number(out, d.error);
+        out.append("}\n");
     }
-}
\ No newline at end of file
+    out_->commit();
+}
+
+// Lines without a peer (--resync), after the DIFFER line
+void Printer::print_unmatched(std::ostream& os, const numdiff::NumericDiffResult& result,
+                              const numdiff::NumericDiffOptions& opts) {
+    if (result.n_only_in1 == 0 && result.n_only_in2 == 0) return;
+    os << "Unmatched lines: " << result.n_only_in1 << " only in " << opts.file1 << ", "
+       << result.n_only_in2 << " only in " << opts.file2 << "\n";
+}
+
+// Red can only come from colored tokens, so each cell is checked on its own
+bool Printer::cells_are_red(const std::vector<Cell>& cells) noexcept {
+    for (const Cell& cell : cells) {
+        if (Formatter::string_is_red(cell.text)) return true;
+    }
+    return false;
+}
+
+/**
+ * Print run statistics (--stats)
+ * 
+ * Text: one line per stage with its time and share of the wall time,
+ * then the counters. JSON: a single object with the same fields, times
+ * in milliseconds. Throughput figures use the wall time.
+ */
+void Printer::print_stats(std::ostream& os, const numdiff::RunStats& stats,
+                          numdiff::StatsFormat format) {
+    using numdiff::RunStats;
+    auto ms = [](std::uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    double wall_s = static_cast<double>(stats.wall_ns) / 1e9;
+    double mb_per_s = wall_s > 0 ? static_cast<double>(stats.bytes_read) / 1e6 / wall_s : 0.0;
+    double lines_per_s = wall_s > 0 ? static_cast<double>(stats.lines) / wall_s : 0.0;
+    const std::pair<const char*, std::uint64_t> counters[] = {
+        {"bytes_read", stats.bytes_read},       {"lines", stats.lines},
+        {"identical_lines", stats.identical_lines}, {"comment_lines", stats.comment_lines},
+        {"tokens", stats.tokens},               {"sliced_lines", stats.sliced_lines},
+        {"numeric_columns", stats.numeric_columns}, {"text_columns", stats.text_columns},
+        {"lines_printed", stats.lines_printed}, {"bytes_written", stats.bytes_written},
+    };
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    if (format == numdiff::StatsFormat::json) {
+        out << "{\"wall_ms\":" << ms(stats.wall_ns) << ",\"stages_ms\":{";
+        for (size_t i = 0; i < RunStats::n_stages; ++i) {
+            if (i > 0) out << ',';
+            out << '"' << RunStats::stage_name(static_cast<RunStats::Stage>(i))
+                << "\":" << ms(stats.stage_ns[i]);
+        }
+        out << '}';
+        for (const auto& [name, value] : counters) out << ",\"" << name << "\":" << value;
+        out << ",\"mb_per_s\":" << mb_per_s << ",\"lines_per_s\":" << lines_per_s << "}\n";
+    } else {
+        out << "Statistics (stage times summed over threads):\n";
+        out << "  " << std::left << std::setw(16) << "wall" << std::right << std::setw(12)
+            << ms(stats.wall_ns) << " ms\n";
+        for (size_t i = 0; i < RunStats::n_stages; ++i) {
+            double share = stats.wall_ns > 0 ? 100.0 * static_cast<double>(stats.stage_ns[i]) /
+                                                   static_cast<double>(stats.wall_ns)
+                                             : 0.0;
+            out << "  " << std::left << std::setw(16)
+                << RunStats::stage_name(static_cast<RunStats::Stage>(i)) << std::right
+                << std::setw(12) << ms(stats.stage_ns[i]) << " ms  " << std::setw(6)
+                << std::setprecision(1) << share << "%\n"
+                << std::setprecision(3);
+        }
+        for (const auto& [name, value] : counters) {
+            out << "  " << std::left << std::setw(16) << name << std::right << std::setw(12)
+                << value << "\n";
+        }
+        out << "  " << std::left << std::setw(16) << "throughput" << std::right
+            << std::setw(12) << mb_per_s << " MB/s, " << lines_per_s << " lines/s\n";
+    }
+    os << out.str();
+}
@@ -0,0 +1,231 @@
+// ReferenceCache.cpp
+// -------------------------------------------------------------
+// Implementation of the parsed-reference sidecar cache
+//
+// Image layout (all sections 8-byte aligned):
+//   Header | comment prefix | Line[n_lines] | double[n_tokens] | uint8[n_tokens]
+// -------------------------------------------------------------
+
+#include "ReferenceCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+
+#include "LineSource.hpp"
+#include "TextParser.hpp"
+
+namespace {
+
+constexpr char cache_magic[8] = {'D', 'N', 'C', 'A', 'C', 'H', 'E', '\0'};
+
+constexpr size_t align8(size_t n) noexcept { return (n + 7) & ~size_t{7}; }
+
+constexpr std::uint64_t rotl(std::uint64_t x, int r) noexcept {
+    return (x << r) | (x >> (64 - r));
+}
+
+}  // namespace
+
+ReferenceCache::~ReferenceCache() {
+    if (mapping_ != nullptr) ::munmap(mapping_, mapping_length_);
+}
+
+/**
+ * Hash the text in four independent 64-bit lanes
+ *
+ * Each lane mixes one 8-byte word per 32-byte block (multiply, rotate),
+ * so the loop runs at memory speed; the lanes and the length are folded
+ * together at the end. Detects any edit of a reference, but only
+ * accidental ones: this is not a cryptographic hash.
+ */
+std::uint64_t ReferenceCache::content_hash(std::string_view data) noexcept {
+    constexpr std::uint64_t k1 = 0x9E3779B97F4A7C15ULL;
+    constexpr std::uint64_t k2 = 0xC2B2AE3D27D4EB4FULL;
+    std::uint64_t lanes[4] = {k1, k2, k1 ^ k2, ~k1};
+    const char* p = data.data();
+    size_t n = data.size();
+    for (; n >= 32; p += 32, n -= 32) {
+        for (size_t j = 0; j < 4; ++j) {
+            std::uint64_t word;
+            std::memcpy(&word, p + 8 * j, sizeof(word));
+            lanes[j] = rotl(lanes[j] ^ (word * k2), 31) * k1;
+        }
+    }
+    std::uint64_t h = static_cast<std::uint64_t>(data.size()) * k1;
+    for (std::uint64_t lane : lanes) h = rotl(h ^ (lane * k2), 27) * k1 + k2;
+    for (; n > 0; ++p, --n) h = (h ^ static_cast<unsigned char>(*p)) * k1;
+    h ^= h >> 33;
+    h *= k2;
+    h ^= h >> 29;
+    return h;
+}
+
+size_t ReferenceCache::image_size(size_t prefix_size, size_t n_lines, size_t n_tokens) noexcept {
+    return sizeof(Header) + align8(prefix_size) + n_lines * sizeof(Line) +
+           n_tokens * sizeof(double) + align8(n_tokens);
+}
+
+// Sections follow the header in a fixed order
+void ReferenceCache::attach(const char* image) {
+    Header header;
+    std::memcpy(&header, image, sizeof(header));
+    const char* p = image + sizeof(Header) + align8(header.prefix_size);
+    n_lines_ = header.n_lines;
+    lines_ = reinterpret_cast<const Line*>(p);
+    p += header.n_lines * sizeof(Line);
+    values_ = reinterpret_cast<const double*>(p);
+    p += header.n_tokens * sizeof(double);
+    numeric_ = reinterpret_cast<const std::uint8_t*>(p);
+}
+
+// A corrupted image must not drive out-of-range reads of the text or the token arrays
+bool ReferenceCache::consistent(size_t text_size, size_t n_tokens) const noexcept {
+    std::uint64_t next_token = 0;
+    for (size_t i = 0; i < n_lines_; ++i) {
+        const Line& entry = lines_[i];
+        if (entry.offset > text_size || entry.length > text_size - entry.offset ||
+            entry.first_token != next_token || entry.n_tokens > n_tokens - next_token)
+            return false;
+        next_token += entry.n_tokens;
+    }
+    if (next_token != n_tokens) return false;
+    for (size_t i = 0; i < n_tokens; ++i)
+        if (numeric_[i] > 1) return false;
+    return true;
+}
+
+/**
+ * Parse a reference text into an image
+ *
+ * Lines are split and comment lines skipped exactly as NumericDiff
+ * reads a text input, and tokens are parsed with the same parser, so a
+ * cached comparison sees the same values as a text one.
+ */
+std::unique_ptr<ReferenceCache> ReferenceCache::build(std::string_view text,
+                                                      std::string_view comment_prefix) {
+    std::vector<Line> lines;
+    std::vector<double> values;
+    std::vector<std::uint8_t> numeric;
+    std::vector<std::string_view> tokens;
+    BufferLineSource source(text);
+    std::string_view line;
+    while (source.next_line(line)) {
+        if (!comment_prefix.empty() && TextParser::line_is_comment(line, comment_prefix)) continue;
+        TextParser::tokenize(line, tokens);
+        Line entry{};
+        entry.offset = static_cast<std::uint64_t>(line.data() - text.data());
+        entry.physical = source.line_number();
+        entry.first_token = values.size();
+        entry.length = static_cast<std::uint32_t>(line.size());
+        entry.n_tokens = static_cast<std::uint32_t>(tokens.size());
+        lines.push_back(entry);
+        for (std::string_view token : tokens) {
+            std::optional<double> value = TextParser::try_parse_number(token);
+            values.push_back(value ? *value : 0.0);
+            numeric.push_back(value ? 1 : 0);
+        }
+    }
+
+    Header header{};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = format_version;
+    header.byte_order = byte_order_mark;
+    header.text_size = text.size();
+    header.text_hash = content_hash(text);
+    header.n_lines = lines.size();
+    header.n_tokens = values.size();
+    header.prefix_size = comment_prefix.size();
+
+    auto cache = std::unique_ptr<ReferenceCache>(new ReferenceCache());
+    cache->storage_.assign(image_size(comment_prefix.size(), lines.size(), values.size()), '\0');
+    char* p = cache->storage_.data();
+    std::memcpy(p, &header, sizeof(header));
+    p += sizeof(Header);
+    std::memcpy(p, comment_prefix.data(), comment_prefix.size());
+    p += align8(comment_prefix.size());
+    std::memcpy(p, lines.data(), lines.size() * sizeof(Line));
+    p += lines.size() * sizeof(Line);
+    std::memcpy(p, values.data(), values.size() * sizeof(double));
+    p += values.size() * sizeof(double);
+    std::memcpy(p, numeric.data(), numeric.size());
+    cache->attach(cache->storage_.data());
+    return cache;
+}
+
+/**
+ * Map and validate a cache file
+ *
+ * Header checks (magic, version, byte order, sizes) come first and are
+ * free; the content hash of the text is computed only when they pass,
+ * and the line records are checked against the text and the token
+ * arrays last, once per load.
+ */
+std::unique_ptr<ReferenceCache> ReferenceCache::load(const std::string& path,
+                                                     std::string_view text,
+                                                     std::string_view comment_prefix) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return nullptr;
+    }
+    size_t length = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    auto cache = std::unique_ptr<ReferenceCache>(new ReferenceCache());
+    cache->mapping_ = mapping;  // Unmapped by the destructor on every path below
+    cache->mapping_length_ = length;
+
+    const char* image = static_cast<const char*>(mapping);
+    Header header;
+    std::memcpy(&header, image, sizeof(header));
+    bool valid = std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0 &&
+                 header.version == format_version && header.byte_order == byte_order_mark &&
+                 header.text_size == text.size() && header.prefix_size == comment_prefix.size() &&
+                 header.n_lines <= length / sizeof(Line) &&
+                 header.n_tokens <= length / sizeof(double) &&
+                 image_size(comment_prefix.size(), header.n_lines, header.n_tokens) == length &&
+                 std::memcmp(image + sizeof(Header), comment_prefix.data(),
+                             comment_prefix.size()) == 0;
+    if (!valid || header.text_hash != content_hash(text)) return nullptr;
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+    cache->attach(image);
+    if (!cache->consistent(text.size(), header.n_tokens)) return nullptr;
+    return cache;
+}
+
+// A process reading the cache keeps its mapping of the old file across the rename
+bool ReferenceCache::write(const std::string& path) const {
+    const char* image = storage_.data();
+    size_t size = storage_.size();
+    if (mapping_ != nullptr) {
+        image = static_cast<const char*>(mapping_);
+        size = mapping_length_;
+    }
+    std::string temporary = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(image, static_cast<std::streamsize>(size));
+        out.close();
+        if (out.fail()) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+// RunStats.cpp
+// -------------------------------------------------------------
+// Implementation of the --stats counters
+// -------------------------------------------------------------
+
+#include "RunStats.hpp"
+
+namespace numdiff {
+
+// Counters and stage times add up; wall time is measured by the caller
+void RunStats::merge(const RunStats& other) noexcept {
+    for (size_t i = 0; i < n_stages; ++i) stage_ns[i] += other.stage_ns[i];
+    bytes_read += other.bytes_read;
+    lines += other.lines;
+    identical_lines += other.identical_lines;
+    comment_lines += other.comment_lines;
+    tokens += other.tokens;
+    sliced_lines += other.sliced_lines;
+    numeric_columns += other.numeric_columns;
+    text_columns += other.text_columns;
+    lines_printed += other.lines_printed;
+    bytes_written += other.bytes_written;
+}
+
+const char* RunStats::stage_name(Stage stage) noexcept {
+    switch (stage) {
+        case Stage::read:
+            return "read";
+        case Stage::identity:
+            return "identity";
+        case Stage::tokenize:
+            return "tokenize";
+        case Stage::parse:
+            return "parse";
+        case Stage::compare:
+            return "compare";
+        case Stage::render:
+            return "render";
+    }
+    return "unknown";
+}
+
+}  // namespace numdiff
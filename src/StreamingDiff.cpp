@@ -0,0 +1,169 @@
+// StreamingDiff.cpp
+// -------------------------------------------------------------
+// Implementation of the incremental comparison API
+// -------------------------------------------------------------
+
+#include "StreamingDiff.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "TextParser.hpp"
+
+namespace numdiff {
+
+// Files, threads and binary formats belong to run(); only-equal mode disables rendering
+NumericDiffOptions StreamingDiff::streaming_options(const NumericDiffOptions& opts, bool render) {
+    NumericDiffOptions streaming = opts;
+    streaming.file1.clear();
+    streaming.file2.clear();
+    streaming.threads = 1;
+    streaming.input_format = InputFormat::text;
+    streaming.reference_cache.clear();
+    streaming.resync_window = 0;  // Lines are paired as they complete
+    if (!render) streaming.only_equal = true;
+    return streaming;
+}
+
+StreamingDiff::StreamingDiff(const NumericDiffOptions& opts, DiffCallback on_diff)
+    : diff_(streaming_options(opts, false), discard_), on_diff_(std::move(on_diff)) {
+    diff_.begin_stats();
+}
+
+StreamingDiff::StreamingDiff(const NumericDiffOptions& opts, std::ostream& os,
+                             DiffCallback on_diff)
+    : diff_(streaming_options(opts, true), os), on_diff_(std::move(on_diff)) {
+    diff_.begin_stats();
+}
+
+// Buffer the bytes, then compare every line pair they complete
+void StreamingDiff::feed(Side& side, std::string_view bytes) {
+    if (finished_) throw std::runtime_error("Error: StreamingDiff fed after finish().");
+    if (stopped_) return;
+    side.data.append(bytes.data(), bytes.size());
+    pump(false);
+}
+
+void StreamingDiff::feed_line(Side& side, std::string_view line) {
+    if (finished_) throw std::runtime_error("Error: StreamingDiff fed after finish().");
+    if (stopped_) return;
+    side.data.reserve(side.data.size() + line.size() + 1);
+    side.data.append(line.data(), line.size());
+    side.data.push_back('\n');
+    pump(false);
+}
+
+/**
+ * Advance a side to its next non-comment line
+ *
+ * Lines are only taken once their newline has arrived; the search for
+ * it resumes where the last one stopped. Comment lines are consumed
+ * (counted in the line numbering and statistics) and skipped.
+ */
+bool StreamingDiff::fetch(Side& side, bool at_end) {
+    if (side.ready) return true;
+    const std::string& comment = diff_.options_.comment_prefix;
+    RunStats* stats = diff_.stats();
+    while (side.pos < side.data.size()) {
+        size_t from = side.pos + side.scanned;
+        const void* nl = std::memchr(side.data.data() + from, '\n', side.data.size() - from);
+        size_t end;
+        if (nl != nullptr) {
+            end = static_cast<size_t>(static_cast<const char*>(nl) - side.data.data());
+        } else if (at_end) {
+            end = side.data.size();
+        } else {
+            side.scanned = side.data.size() - side.pos;
+            return false;
+        }
+        std::string_view line(side.data.data() + side.pos, end - side.pos);
+        size_t begin = side.pos;
+        side.pos = std::min(end + 1, side.data.size());
+        side.scanned = 0;
+        side.line_number++;
+        if (stats != nullptr) stats->bytes_read += line.size() + 1;
+        if (!comment.empty() && TextParser::line_is_comment(line, comment)) {
+            if (stats != nullptr) stats->comment_lines++;
+            continue;
+        }
+        side.ready = true;
+        side.line_begin = begin;
+        side.line_size = line.size();
+        side.ready_line_number = side.line_number;
+        return true;
+    }
+    return false;
+}
+
+// Pairs are compared in input order, exactly like the sequential engine
+void StreamingDiff::pump(bool at_end) {
+    while (!stopped_ && fetch(side1_, at_end) && fetch(side2_, at_end)) {
+        compare_ready(std::string_view(side1_.data).substr(side1_.line_begin, side1_.line_size),
+                      std::string_view(side2_.data).substr(side2_.line_begin, side2_.line_size));
+        side1_.ready = side2_.ready = false;
+    }
+    compact(side1_);
+    compact(side2_);
+}
+
+// Kernel verdicts of a differing line are complete (the selected-columns path redoes it)
+void StreamingDiff::compare_ready(std::string_view line1, std::string_view line2) {
+    std::pair<bool, double> line_result = diff_.compare_lines(line1, line2);
+    if (line_result.first && on_diff_) {
+        for (size_t i = 0; i < diff_.verdicts_.size(); ++i) {
+            const ColumnVerdict& verdict = diff_.verdicts_[i];
+            if (verdict.kind != ColumnVerdict::Kind::different) continue;
+            DiffEvent event;
+            event.line1 = side1_.ready_line_number;
+            event.line2 = side2_.ready_line_number;
+            event.column = i + 1;
+            event.token1 = diff_.tokens1_[i];
+            event.token2 = diff_.tokens2_[i];
+            event.percentage_err = verdict.diff;
+            on_diff_(event);
+        }
+    }
+    if (diff_.accumulate(result_, line_result, side1_.ready_line_number,
+                         side2_.ready_line_number))
+        stopped_ = true;
+}
+
+/**
+ * End of input on both sides
+ *
+ * Remaining lines of the longer input are compared against empty
+ * lines: blank lines pass, anything else is a column count mismatch,
+ * as in NumericDiff::run().
+ */
+NumericDiffResult StreamingDiff::finish() {
+    if (!finished_) {
+        finished_ = true;
+        pump(true);
+        while (!stopped_) {
+            bool has1 = fetch(side1_, true), has2 = fetch(side2_, true);
+            if (!has1 && !has2) break;
+            std::string_view line1, line2;
+            if (has1) line1 = std::string_view(side1_.data).substr(side1_.line_begin,
+                                                                    side1_.line_size);
+            if (has2) line2 = std::string_view(side2_.data).substr(side2_.line_begin,
+                                                                    side2_.line_size);
+            compare_ready(line1, line2);
+            side1_.ready = side2_.ready = false;
+        }
+        diff_.finish_run(result_);
+        diff_.printer_.flush();
+    }
+    return result_;
+}
+
+// Move the unconsumed tail (and a waiting line) to the front of the buffer
+void StreamingDiff::compact(Side& side) {
+    size_t cut = side.ready ? side.line_begin : side.pos;
+    if (cut < compact_bytes || cut < side.data.size() / 2) return;
+    side.data.erase(0, cut);
+    side.pos -= cut;
+    if (side.ready) side.line_begin -= cut;
+}
+
+}  // namespace numdiff
@@ -2,14 +2,13 @@
 // -------------------------------------------------------------
 // Implementation of text parsing utilities for diff-numerics
 //
-// Provides core text processing: tokenization, comment detection,
-// and numeric validation using modern C++ features (from_chars).
+// Provides core text processing: allocation-free tokenization,
+// comment detection, and numeric validation (FloatParser).
 // -------------------------------------------------------------
 
 #include "TextParser.hpp"
 
-#include <charconv>
-#include <sstream>
+#include "FloatParser.hpp"
 
 /**
  * Determine if a line is a comment line
@@ -21,57 +20,130 @@
  * This allows for leading whitespace before comments.
  * Empty or all-whitespace lines return false.
  */
-bool TextParser::line_is_comment(const std::string& line, std::string_view prefix) {
+bool TextParser::line_is_comment(std::string_view line, std::string_view prefix) {
     // Skip leading whitespace
     size_t pos = line.find_first_not_of(" \t");
     
     // Empty line or all whitespace: not a comment
-    if (pos == std::string::npos) return false;
+    if (pos == std::string_view::npos) return false;
     
     // Check if prefix matches at first non-whitespace position
-    return line.compare(pos, std::string(prefix).size(), std::string(prefix)) == 0;
+    return line.compare(pos, prefix.size(), prefix) == 0;
 }
 
 /**
- * Validate whether a string represents a numeric value
+ * Parse a string as a double, requiring the whole string to be consumed
  * 
- * Uses C++17's std::from_chars for:
+ * Uses FloatParser for:
  * - High performance (no locale, no exceptions, no memory allocation)
- * - Exact parsing (returns where parsing stopped)
- * - Support for all numeric formats (int, float, scientific notation)
+ * - Correct rounding, identical to std::from_chars
+ * - Decimal and scientific notation, including Fortran D exponents
  * 
- * The string must be entirely consumed for successful validation.
- * Partial numeric strings like "123abc" are rejected.
+ * Partial numeric strings like "123abc" are rejected, as are values
+ * that overflow or underflow a double (from_chars reports ERANGE).
  */
-bool TextParser::string_is_numeric(const std::string& str) {
-    double value;  // Parse target (actual value not used, only validity checked)
-    
-    // Attempt to parse the entire string as a double
-    auto result = std::from_chars(str.c_str(), str.c_str() + str.size(), value);
+std::optional<double> TextParser::try_parse_number(std::string_view str) noexcept {
+    return FloatParser::parse(str);
+}
+
+/**
+ * Validate whether a string represents a numeric value
+ * 
+ * Thin wrapper over try_parse_number() for callers that only need the
+ * verdict and not the value.
+ */
+bool TextParser::string_is_numeric(std::string_view str) {
+    return try_parse_number(str).has_value();
+}
+
+namespace {
 
-    // Success requires: no error AND parsing consumed entire string
-    return result.ec == std::errc() && result.ptr == str.c_str() + str.size();
+// Whitespace as recognized by operator>> in the C locale
+inline bool is_space(char c) noexcept {
+    return c == ' ' || (c >= '\t' && c <= '\r');
 }
 
+}  // namespace
+
 /**
- * Tokenize a line into whitespace-separated tokens
+ * Tokenize a line into whitespace-separated views
  * 
- * Uses std::istringstream with operator>> for standard whitespace tokenization.
- * This approach:
+ * Hand-written scan over the line: skip a whitespace run, then extend
+ * the token until the next whitespace character. This approach:
  * - Treats any sequence of whitespace (space, tab, newline) as separator
  * - Automatically trims leading and trailing whitespace
  * - Splits on consecutive whitespace without creating empty tokens
  * 
+ * Tokens are views into `line`, so no characters are copied and the
+ * only allocation is growth of the caller's vector on wider lines.
+ */
+void TextParser::tokenize(std::string_view line, std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    const char* p = line.data();
+    const char* end = p + line.size();
+
+    while (p != end) {
+        // Skip separator run
+        while (p != end && is_space(*p)) ++p;
+        if (p == end) break;
+
+        // Extend token until the next separator
+        const char* start = p;
+        while (p != end && !is_space(*p)) ++p;
+        tokens.emplace_back(start, static_cast<size_t>(p - start));
+    }
+}
+
+/**
+ * Tokenize a line, emitting only the selected columns
+ * 
+ * Walks the line exactly like the view-based tokenizer, testing each
+ * token index against the selection bitmap before emitting it. Once
+ * the last selected column is passed, the rest of the line is scanned
+ * with a branch-free token counter. Returns the number of tokens on the line (selected or not).
+ */
+size_t TextParser::tokenize_selected(std::string_view line, const ColumnSelection& selection,
+                                     std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    const char* p = line.data();
+    const char* end = p + line.size();
+    size_t column = 0;
+    size_t last = selection.end();
+
+    while (p != end && column < last) {
+        // Skip separator run
+        while (p != end && is_space(*p)) ++p;
+        if (p == end) break;
+
+        // Extend token until the next separator, keep it only if selected
+        const char* start = p;
+        while (p != end && !is_space(*p)) ++p;
+        if (selection.contains(column)) tokens.emplace_back(start, static_cast<size_t>(p - start));
+        ++column;
+    }
+
+    // Past the last selected column tokens are only counted: a token starts at every
+    // non-space preceded by a space. p is at a separator (or the line start), and the
+    // loop has no carried state, so the compiler can vectorize it.
+    size_t n = static_cast<size_t>(end - p);
+    if (n > 0 && !is_space(p[0])) ++column;
+    for (size_t i = 1; i < n; ++i) {
+        column += static_cast<size_t>(is_space(p[i - 1]) & !is_space(p[i]));
+    }
+    return column;
+}
+
+/**
+ * Tokenize a line into whitespace-separated tokens
+ * 
+ * Convenience wrapper around the view-based tokenizer that returns
+ * owned strings. Prefer the view overload on hot paths.
+ * 
  * Returns a vector of tokens in the order they appear.
  * Empty or all-whitespace lines return an empty vector.
  */
-std::vector<std::string> TextParser::tokenize(const std::string& line) {
-    std::istringstream iss(line);
-    std::vector<std::string> tokens;
-    std::string token;
-    
-    // operator>> automatically handles whitespace separation
-    while (iss >> token) tokens.push_back(token);
-    
-    return tokens;
-}
\ No newline at end of file
+std::vector<std::string> TextParser::tokenize(std::string_view line) {
+    std::vector<std::string_view> views;
+    tokenize(line, views);
+    return std::vector<std::string>(views.begin(), views.end());
+}
@@ -0,0 +1,162 @@
+// ThreadPool.cpp
+// -------------------------------------------------------------
+// Implementation of the work-stealing worker pool
+// -------------------------------------------------------------
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Pool and worker index of the calling thread (nested pools each see their own workers)
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+}  // namespace
+
+// Start the workers
+ThreadPool::ThreadPool(size_t n_threads) {
+    n_threads = std::max<size_t>(n_threads, 1);
+    local_.resize(n_threads);
+    workers_.reserve(n_threads);
+    for (size_t i = 0; i < n_threads; ++i) workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+// Let the workers drain the queues, then join them
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+// Fall back to a single thread if the hardware concurrency is unknown
+size_t ThreadPool::hardware_threads() noexcept {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+size_t ThreadPool::current_worker() const noexcept {
+    return current_pool == this ? current_index : workers_.size();
+}
+
+// Subtasks stay with the worker that created them; waiters must see them too
+void ThreadPool::enqueue(std::function<void()> task) {
+    size_t self = current_worker();
+    bool wake_all;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (self < local_.size()) {
+            local_[self].push_back(std::move(task));
+            n_local_++;
+        } else {
+            tasks_.push_back(std::move(task));
+        }
+        wake_all = n_waiting_ > 0;
+    }
+    if (wake_all) {
+        cv_.notify_all();
+    } else {
+        cv_.notify_one();
+    }
+}
+
+/**
+ * Select the next task for a worker
+ *
+ * Order: the worker's own newest subtask (depth first, its data is
+ * hot), the oldest subtask of another worker (the largest remaining
+ * piece of its work), then the shared queue.
+ */
+bool ThreadPool::pop_task(size_t self, bool shared, std::function<void()>& task) {
+    if (n_local_ > 0) {
+        if (!local_[self].empty()) {
+            task = std::move(local_[self].back());
+            local_[self].pop_back();
+            n_local_--;
+            return true;
+        }
+        for (size_t k = 1; k < local_.size(); ++k) {
+            std::deque<std::function<void()>>& victim = local_[(self + k) % local_.size()];
+            if (victim.empty()) continue;
+            task = std::move(victim.front());
+            victim.pop_front();
+            n_local_--;
+            return true;
+        }
+    }
+    if (!shared || tasks_.empty()) return false;
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+    return true;
+}
+
+// A finished task may be what a waiting worker is blocked on
+void ThreadPool::run_task(std::function<void()>& task) {
+    task();  // packaged_task captures exceptions into the future
+    task = nullptr;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake = n_waiting_ > 0;
+    }
+    if (wake) cv_.notify_all();
+}
+
+/**
+ * Wait for a future, helping with queued subtasks
+ *
+ * Only subtasks are taken while waiting, never new work from the shared
+ * queue: a task that waits for its chunks should not start a whole new
+ * file pair in the meantime.
+ */
+void ThreadPool::wait(const std::future<void>& done) {
+    size_t self = current_worker();
+    if (self >= local_.size()) {
+        done.wait();
+        return;
+    }
+    auto ready = [&done] {
+        return done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            n_waiting_++;
+            cv_.wait(lock, [&] { return ready() || n_local_ > 0; });
+            n_waiting_--;
+            if (ready()) return;
+            if (!pop_task(self, false, task)) continue;
+        }
+        run_task(task);
+    }
+}
+
+/**
+ * Worker main loop
+ *
+ * Sleeps until a task is available or the pool is stopping. Remaining
+ * tasks are still executed after stop is requested, so that no future
+ * is left unsatisfied.
+ */
+void ThreadPool::worker_loop(size_t index) {
+    current_pool = this;
+    current_index = index;
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || n_local_ > 0 || !tasks_.empty(); });
+            if (!pop_task(index, true, task)) {
+                if (stopping_) return;  // Stopping and drained
+                continue;
+            }
+        }
+        run_task(task);
+    }
+}
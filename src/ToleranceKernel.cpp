@@ -0,0 +1,279 @@
+// ToleranceKernel.cpp
+// -------------------------------------------------------------
+// Implementation of the batch tolerance kernel
+//
+// Each vector path mirrors percentage_difference() lane-wise:
+//   both below threshold     -> 0
+//   exactly one below        -> big
+//   otherwise                -> |v1-v2| / max(|v1|,|v2|) * 100, 0 if < tolerance
+// using ordered comparisons so that NaN lanes behave like the scalar
+// code (never "different"). Remainders are handled by the scalar loop.
+// -------------------------------------------------------------
+
+#include "ToleranceKernel.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DIFF_NUMERICS_X86_KERNELS 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define DIFF_NUMERICS_NEON_KERNEL 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+using BlockResult = ToleranceKernel::BlockResult;
+using KernelFn = BlockResult (*)(const double*, const double*, size_t, double, double, double*,
+                                 std::uint8_t*);
+
+// Scalar loop over [begin, n), shared by the reference and the vector tails
+inline void scalar_range(const double* values1, const double* values2, size_t begin, size_t n,
+                         double tolerance, double threshold, double* diff_out,
+                         std::uint8_t* mask_out, BlockResult& result) noexcept {
+    for (size_t i = begin; i < n; ++i) {
+        double diff =
+            ToleranceKernel::percentage_difference(values1[i], values2[i], tolerance, threshold);
+        bool is_diff = std::abs(diff) > tolerance;
+        if (diff_out != nullptr) diff_out[i] = diff;
+        if (mask_out != nullptr) mask_out[i] = is_diff ? 1 : 0;
+        if (is_diff) {
+            ++result.n_different;
+            if (std::abs(diff) > result.max_diff) result.max_diff = std::abs(diff);
+        }
+    }
+}
+
+#ifdef DIFF_NUMERICS_X86_KERNELS
+
+// AVX2: 4 lanes per iteration
+__attribute__((target("avx2"))) BlockResult compare_block_avx2(
+    const double* values1, const double* values2, size_t n, double tolerance, double threshold,
+    double* diff_out, std::uint8_t* mask_out) noexcept {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d thr = _mm256_set1_pd(threshold);
+    const __m256d tol = _mm256_set1_pd(tolerance);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d big = _mm256_set1_pd(ToleranceKernel::big);
+    const __m256d hundred = _mm256_set1_pd(100.0);
+    __m256d running_max = zero;
+    BlockResult result;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v1 = _mm256_loadu_pd(values1 + i);
+        __m256d v2 = _mm256_loadu_pd(values2 + i);
+        __m256d abs1 = _mm256_andnot_pd(sign, v1);
+        __m256d abs2 = _mm256_andnot_pd(sign, v2);
+        __m256d small1 = _mm256_cmp_pd(abs1, thr, _CMP_LT_OQ);
+        __m256d small2 = _mm256_cmp_pd(abs2, thr, _CMP_LT_OQ);
+        __m256d large1 = _mm256_cmp_pd(abs1, thr, _CMP_GE_OQ);
+        __m256d large2 = _mm256_cmp_pd(abs2, thr, _CMP_GE_OQ);
+        __m256d both_small = _mm256_and_pd(small1, small2);
+        __m256d one_small =
+            _mm256_or_pd(_mm256_and_pd(small1, large2), _mm256_and_pd(small2, large1));
+
+        __m256d delta = _mm256_andnot_pd(sign, _mm256_sub_pd(v1, v2));
+        __m256d pd = _mm256_mul_pd(_mm256_div_pd(delta, _mm256_max_pd(abs2, abs1)), hundred);
+        __m256d within = _mm256_cmp_pd(pd, tol, _CMP_LT_OQ);
+
+        __m256d diff = _mm256_blendv_pd(pd, zero, within);
+        diff = _mm256_blendv_pd(diff, big, one_small);
+        diff = _mm256_blendv_pd(diff, zero, both_small);
+
+        __m256d is_diff = _mm256_cmp_pd(diff, tol, _CMP_GT_OQ);
+        running_max = _mm256_max_pd(running_max, _mm256_and_pd(diff, is_diff));
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_pd(is_diff));
+        result.n_different += static_cast<size_t>(__builtin_popcount(bits));
+
+        if (diff_out != nullptr) _mm256_storeu_pd(diff_out + i, diff);
+        if (mask_out != nullptr) {
+            for (unsigned k = 0; k < 4; ++k)
+                mask_out[i + k] = static_cast<std::uint8_t>((bits >> k) & 1u);
+        }
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, running_max);
+    for (double lane : lanes) result.max_diff = std::max(result.max_diff, lane);
+
+    scalar_range(values1, values2, i, n, tolerance, threshold, diff_out, mask_out, result);
+    return result;
+}
+
+// AVX-512F: 8 lanes per iteration, comparisons produce bit masks directly
+__attribute__((target("avx512f"))) BlockResult compare_block_avx512(
+    const double* values1, const double* values2, size_t n, double tolerance, double threshold,
+    double* diff_out, std::uint8_t* mask_out) noexcept {
+    const __m512d thr = _mm512_set1_pd(threshold);
+    const __m512d tol = _mm512_set1_pd(tolerance);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d big = _mm512_set1_pd(ToleranceKernel::big);
+    const __m512d hundred = _mm512_set1_pd(100.0);
+    __m512d running_max = zero;
+    BlockResult result;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v1 = _mm512_loadu_pd(values1 + i);
+        __m512d v2 = _mm512_loadu_pd(values2 + i);
+        __m512d abs1 = _mm512_abs_pd(v1);
+        __m512d abs2 = _mm512_abs_pd(v2);
+        __mmask8 small1 = _mm512_cmp_pd_mask(abs1, thr, _CMP_LT_OQ);
+        __mmask8 small2 = _mm512_cmp_pd_mask(abs2, thr, _CMP_LT_OQ);
+        __mmask8 large1 = _mm512_cmp_pd_mask(abs1, thr, _CMP_GE_OQ);
+        __mmask8 large2 = _mm512_cmp_pd_mask(abs2, thr, _CMP_GE_OQ);
+        __mmask8 both_small = static_cast<__mmask8>(small1 & small2);
+        __mmask8 one_small = static_cast<__mmask8>((small1 & large2) | (small2 & large1));
+
+        __m512d delta = _mm512_abs_pd(_mm512_sub_pd(v1, v2));
+        // max via blend: GCC's _mm512_max_pd trips -Wmaybe-uninitialized in its own header
+        __m512d larger =
+            _mm512_mask_blend_pd(_mm512_cmp_pd_mask(abs2, abs1, _CMP_GT_OQ), abs1, abs2);
+        __m512d pd = _mm512_mul_pd(_mm512_div_pd(delta, larger), hundred);
+        __mmask8 within = _mm512_cmp_pd_mask(pd, tol, _CMP_LT_OQ);
+
+        __m512d diff = _mm512_mask_blend_pd(within, pd, zero);
+        diff = _mm512_mask_blend_pd(one_small, diff, big);
+        diff = _mm512_mask_blend_pd(both_small, diff, zero);
+
+        __mmask8 is_diff = _mm512_cmp_pd_mask(diff, tol, _CMP_GT_OQ);
+        running_max = _mm512_mask_blend_pd(
+            static_cast<__mmask8>(is_diff & _mm512_cmp_pd_mask(diff, running_max, _CMP_GT_OQ)),
+            running_max, diff);
+        unsigned bits = static_cast<unsigned>(is_diff);
+        result.n_different += static_cast<size_t>(__builtin_popcount(bits));
+
+        if (diff_out != nullptr) _mm512_storeu_pd(diff_out + i, diff);
+        if (mask_out != nullptr) {
+            for (unsigned k = 0; k < 8; ++k)
+                mask_out[i + k] = static_cast<std::uint8_t>((bits >> k) & 1u);
+        }
+    }
+
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, running_max);
+    for (double lane : lanes) result.max_diff = std::max(result.max_diff, lane);
+
+    scalar_range(values1, values2, i, n, tolerance, threshold, diff_out, mask_out, result);
+    return result;
+}
+
+#endif  // DIFF_NUMERICS_X86_KERNELS
+
+#ifdef DIFF_NUMERICS_NEON_KERNEL
+
+// NEON (AArch64): 2 lanes per iteration
+BlockResult compare_block_neon(const double* values1, const double* values2, size_t n,
+                               double tolerance, double threshold, double* diff_out,
+                               std::uint8_t* mask_out) noexcept {
+    const float64x2_t thr = vdupq_n_f64(threshold);
+    const float64x2_t tol = vdupq_n_f64(tolerance);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const float64x2_t big = vdupq_n_f64(ToleranceKernel::big);
+    const float64x2_t hundred = vdupq_n_f64(100.0);
+    float64x2_t running_max = zero;
+    BlockResult result;
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v1 = vld1q_f64(values1 + i);
+        float64x2_t v2 = vld1q_f64(values2 + i);
+        float64x2_t abs1 = vabsq_f64(v1);
+        float64x2_t abs2 = vabsq_f64(v2);
+        uint64x2_t small1 = vcltq_f64(abs1, thr);
+        uint64x2_t small2 = vcltq_f64(abs2, thr);
+        uint64x2_t large1 = vcgeq_f64(abs1, thr);
+        uint64x2_t large2 = vcgeq_f64(abs2, thr);
+        uint64x2_t both_small = vandq_u64(small1, small2);
+        uint64x2_t one_small = vorrq_u64(vandq_u64(small1, large2), vandq_u64(small2, large1));
+
+        float64x2_t delta = vabsq_f64(vsubq_f64(v1, v2));
+        float64x2_t pd = vmulq_f64(vdivq_f64(delta, vmaxq_f64(abs2, abs1)), hundred);
+        uint64x2_t within = vcltq_f64(pd, tol);
+
+        float64x2_t diff = vbslq_f64(within, zero, pd);
+        diff = vbslq_f64(one_small, big, diff);
+        diff = vbslq_f64(both_small, zero, diff);
+
+        uint64x2_t is_diff = vcgtq_f64(diff, tol);
+        running_max = vmaxq_f64(running_max, vbslq_f64(is_diff, diff, zero));
+        std::uint8_t lane0 = static_cast<std::uint8_t>(vgetq_lane_u64(is_diff, 0) & 1u);
+        std::uint8_t lane1 = static_cast<std::uint8_t>(vgetq_lane_u64(is_diff, 1) & 1u);
+        result.n_different += static_cast<size_t>(lane0 + lane1);
+
+        if (diff_out != nullptr) vst1q_f64(diff_out + i, diff);
+        if (mask_out != nullptr) {
+            mask_out[i] = lane0;
+            mask_out[i + 1] = lane1;
+        }
+    }
+
+    result.max_diff = std::max(result.max_diff, vmaxvq_f64(running_max));
+
+    scalar_range(values1, values2, i, n, tolerance, threshold, diff_out, mask_out, result);
+    return result;
+}
+
+#endif  // DIFF_NUMERICS_NEON_KERNEL
+
+// Implementation chosen once at startup; blocks narrower than the widest vector (a typical
+// 4-column line on AVX-512) go to the next narrower implementation instead of the scalar tail
+struct SelectedKernel {
+    KernelFn fn;
+    const char* name;
+    size_t width;      // Lanes per iteration of fn
+    KernelFn narrow;   // Used for blocks shorter than width
+};
+
+SelectedKernel select_kernel() noexcept {
+#ifdef DIFF_NUMERICS_X86_KERNELS
+    __builtin_cpu_init();
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (__builtin_cpu_supports("avx512f"))
+        return {compare_block_avx512, "avx512", 8,
+                has_avx2 ? compare_block_avx2 : ToleranceKernel::compare_block_scalar};
+    if (has_avx2) return {compare_block_avx2, "avx2", 4, ToleranceKernel::compare_block_scalar};
+#endif
+#ifdef DIFF_NUMERICS_NEON_KERNEL
+    return {compare_block_neon, "neon", 2, ToleranceKernel::compare_block_scalar};
+#endif
+    return {ToleranceKernel::compare_block_scalar, "scalar", 1,
+            ToleranceKernel::compare_block_scalar};
+}
+
+const SelectedKernel& selected_kernel() noexcept {
+    static const SelectedKernel kernel = select_kernel();
+    return kernel;
+}
+
+}  // namespace
+
+/**
+ * Portable scalar block comparison
+ *
+ * Applies percentage_difference() element by element. This is the
+ * reference the vector implementations are tested against.
+ */
+ToleranceKernel::BlockResult ToleranceKernel::compare_block_scalar(
+    const double* values1, const double* values2, size_t n, double tolerance, double threshold,
+    double* diff_out, std::uint8_t* mask_out) noexcept {
+    BlockResult result;
+    scalar_range(values1, values2, 0, n, tolerance, threshold, diff_out, mask_out, result);
+    return result;
+}
+
+// Dispatch to the implementation selected for this CPU
+ToleranceKernel::BlockResult ToleranceKernel::compare_block(const double* values1,
+                                                            const double* values2, size_t n,
+                                                            double tolerance, double threshold,
+                                                            double* diff_out,
+                                                            std::uint8_t* mask_out) noexcept {
+    const SelectedKernel& kernel = selected_kernel();
+    KernelFn fn = n < kernel.width ? kernel.narrow : kernel.fn;
+    return fn(values1, values2, n, tolerance, threshold, diff_out, mask_out);
+}
+
+// Report which implementation compare_block() dispatches to
+const char* ToleranceKernel::active_isa() noexcept {
+    return selected_kernel().name;
+}
@@ -7,14 +7,87 @@
 // Usage and options are printed if arguments are missing or invalid.
 // -------------------------------------------------------------
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "ArgParser.hpp"
+#include "BatchRunner.hpp"
 #include "NumericDiff.hpp"
 
 using namespace numdiff;
 
+namespace {
+
+/**
+ * Compare pairs on one worker pool, printing their outputs and the summary table
+ * -j of the pairs sizes the shared pool; the largest request wins.
+ * Returns the exit code: -1 if any pair failed.
+ */
+int compare_pairs(const std::vector<NumericDiffOptions>& pairs, const DirectoryPairing* dirs,
+                  const NumericDiffOptions& defaults) {
+    size_t n_threads = defaults.threads;
+    StatsFormat stats = defaults.stats;
+    for (const NumericDiffOptions& pair : pairs) {
+        n_threads = std::max(n_threads, pair.threads);
+        if (stats == StatsFormat::none) stats = pair.stats;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BatchOutcome> outcomes = BatchRunner(n_threads).run(pairs, &std::cout);
+    BatchRunner::print_summary(std::cout, pairs, outcomes);
+    if (dirs != nullptr) BatchRunner::print_unpaired(std::cout, defaults, *dirs);
+
+    bool failed = false;
+    RunStats total;
+    for (const BatchOutcome& outcome : outcomes) {
+        failed = failed || outcome.failed;
+        total.merge(outcome.result.stats);
+    }
+    total.wall_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             start)
+            .count());
+    if (stats != StatsFormat::none) Printer::print_stats(std::cerr, total, stats);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (pairs[i].column_stats != StatsFormat::none && !outcomes[i].failed)
+            Printer::print_column_stats(std::cerr, outcomes[i].result, pairs[i]);
+    }
+    return failed ? -1 : 0;
+}
+
+/**
+ * --batch mode: compare every pair of the manifest
+ * args are the remaining command-line options, applied to every pair.
+ */
+int run_batch(const std::string& manifest, const std::vector<std::string>& args) {
+    std::vector<NumericDiffOptions> pairs;
+    try {
+        pairs = BatchRunner::read_manifest(manifest, args);
+    } catch (const std::runtime_error& e) {
+        std::cout << e.what() << '\n';
+        return -1;
+    }
+    return compare_pairs(pairs, nullptr, NumericDiffOptions{});
+}
+
+/** Directory mode: compare the files of two trees that share a relative path */
+int run_directories(const NumericDiffOptions& opts) {
+    DirectoryPairing pairing;
+    try {
+        pairing = BatchRunner::pair_directories(opts);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << '\n';
+        return -1;
+    }
+    return compare_pairs(pairing.pairs, &pairing, opts);
+}
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -23,6 +96,17 @@ int main(int argc, char* argv[]) {
             return 0;
         }
     }
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--batch") continue;
+        if (i + 1 >= argc) {
+            std::cout << "Error: Missing value for --batch option.";
+            ArgParser::print_usage();
+            return -1;
+        }
+        std::vector<std::string> args(argv + 1, argv + i);
+        args.insert(args.end(), argv + i + 2, argv + argc);
+        return run_batch(argv[i + 1], args);
+    }
     NumericDiffOptions opts;
     try {
         opts = ArgParser::parse(argc, argv);
@@ -31,6 +115,8 @@ int main(int argc, char* argv[]) {
         ArgParser::print_usage();
         return -1;
     }
+    if (std::filesystem::is_directory(opts.file1) && std::filesystem::is_directory(opts.file2))
+        return run_directories(opts);
 
     NumericDiff diff(opts);
 
@@ -41,6 +127,43 @@ int main(int argc, char* argv[]) {
         std::cerr << e.what() << '\n';
         return -1;
     }
+    if (opts.stats != StatsFormat::none) Printer::print_stats(std::cerr, r.stats, opts.stats);
+    if (opts.column_stats != StatsFormat::none) Printer::print_column_stats(std::cerr, r, opts);
+
+    // Fail-fast mode: report where the comparison stopped
+    auto print_first_diff = [&]() {
+        if (!opts.first_diff || r.n_different_lines == 0) return;
+        std::cout << "First difference at line " << r.first_diff.line1 << " of " << opts.file1
+                  << " (line " << r.first_diff.line2 << " of " << opts.file2 << "), ";
+        if (r.first_diff.column == 0) {
+            std::cout << "line present in one file only\n";  // --resync
+        } else {
+            std::cout << "column " << r.first_diff.column << "\n";
+        }
+    };
+
+    // Resync mode: lines without a peer are part of the differing lines
+    auto print_unmatched = [&]() {
+        if (r.n_only_in1 == 0 && r.n_only_in2 == 0) return;
+        std::cout << "Unmatched lines: " << r.n_only_in1 << " only in " << opts.file1 << ", "
+                  << r.n_only_in2 << " only in " << opts.file2 << "\n";
+    };
+
+    if (opts.records != RecordFormat::none) return 0;  // Records only: no text around them
+
+    // Sampled comparison: only the estimate (unless quiet and no sampled line differs), never
+    // the EQUAL/DIFFER verdict of a full run
+    if (opts.sample_lines > 0) {
+        if (!(opts.quiet && r.n_different_lines == 0)) Printer::print_sample(std::cout, r, opts);
+        print_first_diff();
+        return 0;
+    }
+
+    if (opts.top_k > 0) {
+        Printer::print_top(std::cout, r, opts);
+        print_first_diff();
+        return 0;
+    }
 
     if (opts.quiet) {
         // Print nothing if files are equal, otherwise print as normal (with all options except
@@ -54,6 +177,8 @@ int main(int argc, char* argv[]) {
                       << "\n";
             std::cout << "Files DIFFER: " << r.n_different_lines
                       << " lines differ, max percentage error: " << r.max_percentage_err << "%\n";
+            print_unmatched();
+            print_first_diff();
         }
         return 0;
     }
@@ -67,9 +192,12 @@ int main(int argc, char* argv[]) {
         } else {
             std::cout << "Files DIFFER: " << r.n_different_lines
                       << " lines differ, max percentage error: " << r.max_percentage_err << "%\n";
+            print_unmatched();
+            print_first_diff();
         }
         return 0;
     }
 
+    print_first_diff();
     return 0;
 }
\ No newline at end of file
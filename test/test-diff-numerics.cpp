@@ -10,14 +10,54 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef DIFF_NUMERICS_WITH_HDF5
+#include <hdf5.h>
+#endif
+#ifdef DIFF_NUMERICS_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DIFF_NUMERICS_WITH_XZ
+#include <lzma.h>
+#endif
+
+#include "ArraySource.hpp"
+#include "BatchRunner.hpp"
+#include "ByteReader.hpp"
+#include "ColumnErrorStats.hpp"
+#include "ColumnSelection.hpp"
+#include "FixedWidthLayout.hpp"
+#include "FloatParser.hpp"
+#include "Formatter.hpp"
+#include "KeyIndex.hpp"
+#include "LineSource.hpp"
 #include "NumericDiff.hpp"
+#include "OutputBuffer.hpp"
 #include "Printer.hpp"
+#include "ReferenceCache.hpp"
+#include "StreamingDiff.hpp"
+#include "TextParser.hpp"
+#include "ThreadPool.hpp"
+#include "ToleranceKernel.hpp"
 
 namespace fs = std::filesystem;
 using namespace numdiff;
@@ -27,7 +67,7 @@ struct FullOutput {
     NumericDiffResult result;
 };
 
-// Helper to copy test data to a temp file (not used in current tests)
+// Helper to copy test data to a temp file
 void copy_file(const std::string& src, const std::string& dst) {
     std::ifstream in(src);
     std::ofstream out(dst);
@@ -126,11 +166,20 @@ TEST(DiffNumerics, SuppressCommonLines) {
     EXPECT_NE(result.result.n_different_lines, 0);
 }
 
-// Test: Quiet mode (should still be non-empty for different files)
+// Test: Quiet mode (should still be non-empty for different files: -q prints the differing lines
+// as without it, and only adds the summary)
 TEST(DiffNumerics, QuietMode) {
     auto result = run_diff(test_data_path("delta_3D2_2.dat"), test_data_path("delta_3D2.dat"), 1E-2,
                            1E-6, false, false, false, true);
     EXPECT_NE(result.result.n_different_lines, 0);
+    EXPECT_FALSE(result.output.empty());
+    auto loud = run_diff(test_data_path("delta_3D2_2.dat"), test_data_path("delta_3D2.dat"), 1E-2,
+                         1E-6, false, false, false, false);
+    EXPECT_EQ(result.output, loud.output);
+    std::string out = run_diff_numerics_cli("-q " + test_data_path("delta_3D2_2.dat") + " " +
+                                            test_data_path("delta_3D2.dat"));
+    EXPECT_NE(out.find("\n< "), std::string::npos);
+    EXPECT_NE(out.find("Files DIFFER"), std::string::npos);
 }
 
 // Test: Invalid column width
@@ -218,12 +267,14 @@ TEST(DiffNumerics, P2F2_SuppressCommonLines) {
     EXPECT_NE(output.output.find("|"), std::string::npos);
 }
 
-// Test: Quiet mode
+// Test: Quiet mode prints the same differing lines as the default mode
 TEST(DiffNumerics, P2F2_QuietMode) {
     std::string file1 = test_data_path("delta_3P2-3F2.dat");
     std::string file2 = test_data_path("delta_3P2-3F2_2.dat");
     FullOutput output = run_diff(file1, file2, 1E-2, 1E-6, false, false, false, true);
     EXPECT_NE(output.result.n_different_lines, 0);
+    EXPECT_FALSE(output.output.empty());
+    EXPECT_EQ(output.output, run_diff(file1, file2, 1E-2, 1E-6, false, false, false, false).output);
 }
 
 // Test: CLI summary output for these files
@@ -278,3 +329,1636 @@ TEST(DiffNumerics, P2F2_Columns1_2_4_Equal) {
 }
 
 // Add more tests for different tolerances, thresholds, and options as needed
+
+// --- Tests for the LineSource backends ---
+
+// Helper to drain a line source into a vector of owned strings
+std::vector<std::string> read_all_lines(LineSource& source) {
+    std::vector<std::string> lines;
+    std::string_view line;
+    while (source.next_line(line)) lines.emplace_back(line);
+    return lines;
+}
+
+// Test: Buffer source follows std::getline semantics for the final line
+TEST(LineSource, BufferSourceSplitsLines) {
+    BufferLineSource with_newline("1 2\n\n3 4\n");
+    EXPECT_EQ(read_all_lines(with_newline), (std::vector<std::string>{"1 2", "", "3 4"}));
+
+    BufferLineSource without_newline("1 2\n3 4");
+    EXPECT_EQ(read_all_lines(without_newline), (std::vector<std::string>{"1 2", "3 4"}));
+
+    std::string_view line;
+    EXPECT_FALSE(without_newline.next_line(line));  // Stays exhausted
+}
+
+// Test: Mapped and streamed backends yield the same lines as std::getline
+TEST(LineSource, FileBackendsMatchGetline) {
+    std::string path = test_data_path("delta_3P2-3F2.dat");
+    std::vector<std::string> expected;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) expected.push_back(line);
+
+    auto mapped = LineSource::open(path);
+    EXPECT_EQ(read_all_lines(*mapped), expected);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    std::string content;
+    for (const auto& line : expected) content += line + "\n";
+    ASSERT_EQ(write(fds[1], content.data(), content.size()),
+              static_cast<ssize_t>(content.size()));
+    close(fds[1]);
+    StreamLineSource streamed(fds[0], "pipe");
+    EXPECT_EQ(read_all_lines(streamed), expected);
+}
+
+// Test: read-ahead leaves the lines unchanged, for a mapping (window smaller than the file, also
+// across a skip) and for a FIFO read through a PrefetchReader
+TEST(LineSource, ReadAheadMatchesPlainRead) {
+    std::string path = test_data_path("delta_3P2-3F2.dat");
+    std::vector<std::string> expected = read_all_lines(*LineSource::open(path));
+    EXPECT_EQ(read_all_lines(*LineSource::open(path, 4096)), expected);
+
+    auto mapped = LineSource::open(path, 4096);
+    std::string_view data = *mapped->remaining();
+    size_t skipped = data.find('\n', 10000) + 1;
+    mapped->skip(skipped, static_cast<std::uint64_t>(std::count(
+                              data.begin(), data.begin() + static_cast<long>(skipped), '\n')));
+    std::vector<std::string> rest = read_all_lines(*mapped);
+    EXPECT_EQ(rest, std::vector<std::string>(expected.end() - static_cast<long>(rest.size()),
+                                             expected.end()));
+    EXPECT_EQ(mapped->line_number(), expected.size());
+
+    std::string fifo = (fs::temp_directory_path() / "dn_prefetch_fifo").string();
+    fs::remove(fifo);
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    std::thread writer([&] {
+        std::ofstream out(fifo);
+        for (const std::string& line : expected) out << line << "\n";
+    });
+    auto streamed = LineSource::open(fifo, 1 << 16);
+    EXPECT_FALSE(streamed->remaining());
+    EXPECT_EQ(read_all_lines(*streamed), expected);
+    writer.join();
+    fs::remove(fifo);
+}
+
+// Test: Comparison over in-memory sources, with comment lines on one side only
+TEST(DiffNumerics, RunOverBufferSources) {
+    NumericDiffOptions opts;
+    opts.only_equal = true;
+    BufferLineSource source1("# header\n1.0 2.0\n3.0 4.0\n");
+    BufferLineSource source2("1.0 2.0\n# interleaved\n3.0 4.5\n");
+    std::ostringstream oss;
+    NumericDiff diff(opts, oss);
+    NumericDiffResult result = diff.run(source1, source2);
+    EXPECT_EQ(result.n_different_lines, 1u);
+    EXPECT_GT(result.max_percentage_err, 10.0);
+}
+
+// --- Tests for TextParser ---
+
+// Test: View tokenizer matches the owning tokenizer and reuses the caller's buffer
+TEST(TextParser, TokenizeIntoViews) {
+    std::vector<std::string_view> tokens;
+    TextParser::tokenize("  1.23\t4.56 \r\n  abc\v", tokens);
+    EXPECT_EQ(tokens, (std::vector<std::string_view>{"1.23", "4.56", "abc"}));
+    EXPECT_EQ(TextParser::tokenize("  1.23\t4.56 \r\n  abc\v"),
+              (std::vector<std::string>{"1.23", "4.56", "abc"}));
+
+    TextParser::tokenize("   \t ", tokens);
+    EXPECT_TRUE(tokens.empty());
+
+    TextParser::tokenize("1 2 3 4", tokens);
+    const std::string_view* storage = tokens.data();
+    TextParser::tokenize("5 6 7", tokens);
+    EXPECT_EQ(tokens.data(), storage);  // No reallocation for a narrower line
+    EXPECT_EQ(tokens.size(), 3u);
+}
+
+// Test: Selected tokenization emits only the chosen columns and counts all of them
+TEST(TextParser, TokenizeSelectedColumns) {
+    ColumnSelection selection(std::set<size_t>{2, 4, 100000});
+    EXPECT_FALSE(selection.all());
+    EXPECT_TRUE(selection.contains(1));
+    EXPECT_FALSE(selection.contains(2));
+    EXPECT_TRUE(selection.contains(99999));  // Beyond the bitmap
+    EXPECT_TRUE(ColumnSelection().contains(12345));
+
+    std::vector<std::string_view> tokens;
+    EXPECT_EQ(TextParser::tokenize_selected(" a\tb c  d e f ", selection, tokens), 6u);
+    EXPECT_EQ(tokens, (std::vector<std::string_view>{"b", "d"}));
+
+    ColumnSelection first(std::set<size_t>{1});
+    EXPECT_EQ(TextParser::tokenize_selected("x  y\tz\n", first, tokens), 3u);
+    EXPECT_EQ(tokens, (std::vector<std::string_view>{"x"}));
+    EXPECT_EQ(TextParser::tokenize_selected("   ", first, tokens), 0u);
+    EXPECT_TRUE(tokens.empty());
+}
+
+// Test: Single-pass number parsing accepts whole numeric tokens only
+TEST(TextParser, TryParseNumber) {
+    EXPECT_DOUBLE_EQ(TextParser::try_parse_number("5.0000000000000001E-003").value(), 5e-3);
+    EXPECT_DOUBLE_EQ(TextParser::try_parse_number("-42").value(), -42.0);
+    EXPECT_FALSE(TextParser::try_parse_number("12abc").has_value());
+    EXPECT_FALSE(TextParser::try_parse_number("").has_value());
+    EXPECT_FALSE(TextParser::try_parse_number("1e400").has_value());  // Out of range
+    EXPECT_TRUE(TextParser::string_is_numeric("0.46500000000000002"));
+    EXPECT_FALSE(TextParser::string_is_numeric("abc"));
+}
+
+// Test: the fast parser agrees bit for bit with std::from_chars on random mantissas and exponents,
+// and reads Fortran D exponents and letterless 3-digit exponents
+TEST(FloatParser, MatchesFromChars) {
+    auto expect_from_chars = [](std::string_view token) {
+        double expected = 0.0;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), expected);
+        bool valid = ec == std::errc() && ptr == token.data() + token.size();
+        std::optional<double> parsed = FloatParser::parse(token);
+        ASSERT_EQ(parsed.has_value(), valid) << token;
+        if (valid) ASSERT_EQ(std::memcmp(&*parsed, &expected, sizeof(double)), 0) << token;
+    };
+    std::mt19937_64 rng(42);
+    char text[64];
+    for (int i = 0; i < 50000; ++i) {
+        // Random digit strings with a decimal point anywhere and a wide exponent range
+        std::string mantissa = std::to_string(rng()).substr(0, 1 + rng() % 19);
+        mantissa.insert(rng() % (mantissa.size() + 1), ".");
+        int len = std::snprintf(text, sizeof(text), "%s%se%d", (i & 1) ? "-" : "",
+                                mantissa.c_str(), static_cast<int>(rng() % 700) - 350);
+        expect_from_chars(std::string_view(text, static_cast<size_t>(len)));
+
+        // Shortest round-trip forms of random doubles, as dumps write them
+        double value;
+        std::uint64_t bits = rng();
+        std::memcpy(&value, &bits, sizeof(value));
+        len = std::snprintf(text, sizeof(text), "%.17E", value);
+        expect_from_chars(std::string_view(text, static_cast<size_t>(len)));
+    }
+
+    EXPECT_EQ(FloatParser::parse("5.0000000000000001E-003"), 5.0000000000000001E-003);
+    EXPECT_EQ(FloatParser::parse("1.25D-03"), 1.25e-3);
+    EXPECT_EQ(FloatParser::parse("-7.5d+2"), -750.0);
+    EXPECT_EQ(FloatParser::parse("0.1234567-100"), 0.1234567e-100);
+    EXPECT_EQ(FloatParser::parse("0.1234567+100"), 0.1234567e100);
+    EXPECT_EQ(FloatParser::parse("1.2345678901234567890123D+05"), 123456.78901234567890123);
+    EXPECT_EQ(FloatParser::parse("-.5"), -0.5);
+    EXPECT_TRUE(std::signbit(FloatParser::parse("-0.000").value()));
+    EXPECT_TRUE(std::isinf(FloatParser::parse("-inf").value()));
+    for (const char* text_token : {"1-100", "1.5-10", "1.5e", "1.5D", "+1", ".", "1e5x",
+                                   "2024-01-05", "1e400", "1D400", "abc", ""}) {
+        EXPECT_FALSE(FloatParser::parse(text_token).has_value()) << text_token;
+    }
+}
+
+// --- Tests for the parallel chunked engine ---
+
+// Helper to write a synthetic multi-megabyte data file; every `diff_every`-th row is perturbed
+// and comment lines are interleaved at a file-specific stride
+std::string write_large_file(const std::string& name, size_t rows, size_t diff_every,
+                             size_t comment_every) {
+    std::string path = (fs::temp_directory_path() / name).string();
+    std::ofstream out(path);
+    out << std::scientific;
+    out.precision(16);
+    for (size_t i = 0; i < rows; ++i) {
+        if (comment_every != 0 && i % comment_every == 0) out << "# block " << i << "\n";
+        double value = 1.0 + static_cast<double>(i % 977) * 1e-3;
+        if (diff_every != 0 && i % diff_every == diff_every - 1) value *= 1.5;
+        out << "   " << static_cast<double>(i) * 5e-3 << "   " << value << "   0.0\n";
+    }
+    return path;
+}
+
+// Test: Multi-threaded comparison prints the same output and statistics as the sequential one
+TEST(DiffNumerics, ParallelMatchesSequential) {
+    std::string file1 = write_large_file("dn_parallel_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_parallel_2.dat", 60000, 997, 5003);
+    for (bool side_by_side : {false, true}) {
+        NumericDiffOptions opts;
+        opts.file1 = file1;
+        opts.file2 = file2;
+        opts.side_by_side = side_by_side;
+        opts.suppress_common_lines = side_by_side;
+
+        std::ostringstream sequential_out, parallel_out;
+        NumericDiffResult sequential = NumericDiff(opts, sequential_out).run();
+        opts.threads = 4;
+        NumericDiffResult parallel = NumericDiff(opts, parallel_out).run();
+
+        EXPECT_GT(sequential.n_different_lines, 0u);
+        EXPECT_EQ(parallel.n_different_lines, sequential.n_different_lines);
+        EXPECT_DOUBLE_EQ(parallel.max_percentage_err, sequential.max_percentage_err);
+        EXPECT_EQ(parallel_out.str(), sequential_out.str());
+    }
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// Test: Column count mismatch is still reported by the parallel engine
+TEST(DiffNumerics, ParallelReportsColumnMismatch) {
+    std::string file1 = write_large_file("dn_parallel_3.dat", 60000, 0, 0);
+    std::string file2 = write_large_file("dn_parallel_4.dat", 60000, 0, 0);
+    std::ofstream(file2, std::ios::app) << "1.0 2.0\n";
+    std::ofstream(file1, std::ios::app) << "1.0 2.0 3.0\n";
+
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.threads = 4;
+    std::ostringstream oss;
+    NumericDiff diff(opts, oss);
+    EXPECT_THROW(diff.run(), std::runtime_error);
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for fail-fast mode ---
+
+// Test: First difference location is reported, and --first-diff stops there
+TEST(DiffNumerics, FirstDiffStopsEarly) {
+    NumericDiffOptions opts;
+    opts.only_equal = true;
+    std::ostringstream oss;
+
+    BufferLineSource full1("# header\n1.0 2.0\n3.0 4.0\n5.0 6.0\n");
+    BufferLineSource full2("1.0 2.0\n3.0 4.5\n5.0 7.0\n");
+    NumericDiffResult all = NumericDiff(opts, oss).run(full1, full2);
+    EXPECT_EQ(all.n_different_lines, 2u);
+    EXPECT_EQ(all.first_diff.line1, 3u);  // Comment lines are counted
+    EXPECT_EQ(all.first_diff.line2, 2u);
+    EXPECT_EQ(all.first_diff.column, 2u);
+
+    opts.first_diff = true;
+    BufferLineSource fast1("# header\n1.0 2.0\n3.0 4.0\n5.0 6.0\n");
+    BufferLineSource fast2("1.0 2.0\n3.0 4.5\n5.0 7.0 8.0\n");  // Mismatch after the first diff
+    NumericDiffResult first = NumericDiff(opts, oss).run(fast1, fast2);
+    EXPECT_EQ(first.n_different_lines, 1u);
+    EXPECT_EQ(first.first_diff.line1, 3u);
+}
+
+// Test: Parallel fail-fast reports the same first difference as the sequential engine
+TEST(DiffNumerics, ParallelFirstDiffMatchesSequential) {
+    std::string file1 = write_large_file("dn_first_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_first_2.dat", 60000, 20011, 5003);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.first_diff = true;
+
+    std::ostringstream sequential_out, parallel_out;
+    NumericDiffResult sequential = NumericDiff(opts, sequential_out).run();
+    opts.threads = 4;
+    NumericDiffResult parallel = NumericDiff(opts, parallel_out).run();
+
+    EXPECT_EQ(sequential.n_different_lines, 1u);
+    EXPECT_EQ(parallel.n_different_lines, 1u);
+    EXPECT_EQ(parallel.first_diff.line1, sequential.first_diff.line1);
+    EXPECT_EQ(parallel.first_diff.line2, sequential.first_diff.line2);
+    EXPECT_EQ(parallel.first_diff.column, 2u);
+    EXPECT_EQ(parallel_out.str(), sequential_out.str());
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for the batch tolerance kernel ---
+
+// Test: Runtime-selected kernel is bit-identical to the scalar reference, including edge cases
+TEST(ToleranceKernel, DispatchedMatchesScalar) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> a = {0.0, 1e-7, 1e-7, 1.0, 1.0,  -2.0, inf, nan, 1.0, 5e-3, 0.0};
+    std::vector<double> b = {0.0, 2e-7, 1e-5, 1.0, 1.02, 2.0,  1.0, 1.0, nan, 5e-3, -0.0};
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (int i = 0; i < 997; ++i) {
+        double v = dist(rng);
+        a.push_back(v);
+        b.push_back(i % 3 == 0 ? v * (1.0 + dist(rng) * 1e-3) : v);
+    }
+
+    for (double threshold : {0.0, 1e-6}) {
+        size_t n = a.size();
+        std::vector<double> diff_simd(n), diff_ref(n);
+        std::vector<std::uint8_t> mask_simd(n), mask_ref(n);
+        auto simd = ToleranceKernel::compare_block(a.data(), b.data(), n, 1e-2, threshold,
+                                                   diff_simd.data(), mask_simd.data());
+        auto ref = ToleranceKernel::compare_block_scalar(a.data(), b.data(), n, 1e-2, threshold,
+                                                         diff_ref.data(), mask_ref.data());
+        EXPECT_EQ(simd.n_different, ref.n_different) << ToleranceKernel::active_isa();
+        EXPECT_EQ(simd.max_diff, ref.max_diff);
+        EXPECT_EQ(mask_simd, mask_ref);
+        for (size_t i = 0; i < n; ++i) {
+            if (std::isnan(diff_ref[i])) {
+                EXPECT_TRUE(std::isnan(diff_simd[i])) << i;
+            } else {
+                EXPECT_EQ(diff_simd[i], diff_ref[i]) << i;
+            }
+        }
+    }
+    EXPECT_EQ(ToleranceKernel::percentage_difference(1e-7, 1e-5, 1e-2, 1e-6), ToleranceKernel::big);
+    EXPECT_EQ(ToleranceKernel::percentage_difference(1e-7, 2e-7, 1e-2, 1e-6), 0.0);
+}
+
+// --- Tests for the identical-line fast path ---
+
+// Line source without remaining(), forcing the line-by-line comparison path
+class ForwardOnlySource : public LineSource {
+   public:
+    explicit ForwardOnlySource(std::string_view buffer) : inner_(buffer) {}
+    bool next_line(std::string_view& line) override {
+        bool ok = inner_.next_line(line);
+        line_number_ = inner_.line_number();
+        return ok;
+    }
+
+   private:
+    BufferLineSource inner_;
+};
+
+// Test: Skipping identical regions preserves statistics, line numbers and output
+TEST(DiffNumerics, IdenticalRegionSkipMatchesLineByLine) {
+    auto slurp = [](const std::string& path) {
+        std::ifstream in(path);
+        std::ostringstream content;
+        content << in.rdbuf();
+        return content.str();
+    };
+    // Same comment layout on both sides, so only the perturbed rows differ in bytes
+    std::string data1 = slurp(write_large_file("dn_identical_1.dat", 20000, 0, 3001));
+    std::string data2 = slurp(write_large_file("dn_identical_2.dat", 20000, 4999, 3001));
+    data1 += "# trailer\n7.0 8.0";  // Identical unterminated last line
+    data2 += "# trailer\n7.0 8.0";
+
+    for (bool first_diff : {false, true}) {
+        NumericDiffOptions opts;
+        opts.first_diff = first_diff;
+        std::ostringstream skipped_out, line_out;
+
+        BufferLineSource mapped1(data1), mapped2(data2);
+        NumericDiffResult skipped = NumericDiff(opts, skipped_out).run(mapped1, mapped2);
+        ForwardOnlySource forward1(data1), forward2(data2);
+        NumericDiffResult by_line = NumericDiff(opts, line_out).run(forward1, forward2);
+
+        EXPECT_EQ(skipped.n_different_lines, first_diff ? 1u : 4u);
+        EXPECT_EQ(skipped.n_different_lines, by_line.n_different_lines);
+        EXPECT_EQ(skipped.first_diff.line1, by_line.first_diff.line1);
+        EXPECT_EQ(skipped.first_diff.line2, by_line.first_diff.line2);
+        EXPECT_EQ(skipped.first_diff.column, by_line.first_diff.column);
+        EXPECT_EQ(skipped_out.str(), line_out.str());
+    }
+}
+
+// --- Tests for binary array inputs ---
+
+// Helper to write a rows x cols array as .npy; descr is e.g. "<f8" or ">f4"
+std::string write_npy(const std::string& name, const std::string& descr, bool fortran_order,
+                      size_t rows, size_t cols, const std::vector<double>& values) {
+    std::string header = "{'descr': '" + descr + "', 'fortran_order': " +
+                         (fortran_order ? "True" : "False") + ", 'shape': (" +
+                         std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+    header.append(64 - (10 + header.size() + 1) % 64, ' ');  // Align the data to 64 bytes
+    header += '\n';
+
+    bool big_endian = descr[0] == '>';
+    std::string payload;
+    for (size_t k = 0; k < rows * cols; ++k) {
+        size_t index = fortran_order ? (k % rows) * cols + k / rows : k;  // Element stored k-th
+        char bytes[8];
+        size_t width = descr[2] == '4' ? 4 : 8;
+        if (width == 4) {
+            float f = static_cast<float>(values[index]);
+            std::memcpy(bytes, &f, 4);
+        } else {
+            std::memcpy(bytes, &values[index], 8);
+        }
+        if (big_endian) std::reverse(bytes, bytes + width);
+        payload.append(bytes, width);
+    }
+
+    std::string path = (fs::temp_directory_path() / name).string();
+    std::ofstream out(path, std::ios::binary);
+    out << "\x93NUMPY" << '\x01' << '\x00';
+    out << static_cast<char>(header.size() & 0xff) << static_cast<char>(header.size() >> 8);
+    out << header << payload;
+    return path;
+}
+
+// Rows x 3 values; every 7th row perturbed by 10% in its last column when perturb is set
+std::vector<double> array_values(size_t rows, bool perturb) {
+    std::vector<double> values;
+    for (size_t r = 0; r < rows; ++r) {
+        double last = 0.25 + static_cast<double>(r);
+        if (perturb && r % 7 == 6) last *= 1.1;
+        values.insert(values.end(), {static_cast<double>(r), 1e-9 * static_cast<double>(r), last});
+    }
+    return values;
+}
+
+// Test: .npy arrays give the same statistics as the equivalent text files
+TEST(ArraySource, NpyMatchesText) {
+    std::vector<double> v1 = array_values(50, false), v2 = array_values(50, true);
+    std::string npy1 = write_npy("dn_array_1.npy", "<f8", false, 50, 3, v1);
+    std::string npy2 = write_npy("dn_array_2.npy", ">f8", true, 50, 3, v2);  // Byte-swapped, column-major
+    EXPECT_EQ(ArraySource::detect(npy1), InputFormat::npy);
+
+    auto to_text = [](const std::vector<double>& v) {
+        std::ostringstream text;
+        text.precision(17);
+        for (size_t k = 0; k < v.size(); ++k) text << v[k] << (k % 3 == 2 ? "\n" : " ");
+        return text.str();
+    };
+    std::string text1 = to_text(v1), text2 = to_text(v2);
+
+    for (bool first_diff : {false, true}) {
+        NumericDiffOptions opts;
+        opts.only_equal = true;
+        opts.first_diff = first_diff;
+        opts.file1 = npy1;
+        opts.file2 = npy2;
+        std::ostringstream oss;
+        NumericDiffResult binary = NumericDiff(opts, oss).run();
+        BufferLineSource source1(text1), source2(text2);
+        NumericDiffResult text = NumericDiff(opts, oss).run(source1, source2);
+
+        EXPECT_EQ(binary.n_different_lines, first_diff ? 1u : 7u);
+        EXPECT_EQ(binary.n_different_lines, text.n_different_lines);
+        EXPECT_DOUBLE_EQ(binary.max_percentage_err, text.max_percentage_err);
+        EXPECT_EQ(binary.first_diff.line1, 7u);
+        EXPECT_EQ(binary.first_diff.column, 3u);
+    }
+}
+
+// Test: Raw float32 input with a declared shape, column selection and shape errors
+TEST(ArraySource, RawFloat32WithShape) {
+    auto write_raw = [](const std::string& name, const std::vector<double>& values) {
+        std::string path = (fs::temp_directory_path() / name).string();
+        std::ofstream out(path, std::ios::binary);
+        for (double v : values) {
+            float f = static_cast<float>(v);
+            out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+        }
+        return path;
+    };
+    NumericDiffOptions opts;
+    opts.only_equal = true;
+    opts.input_format = InputFormat::raw_f32;
+    opts.shape = {3};
+    opts.file1 = write_raw("dn_raw_1.f32", array_values(40, false));
+    opts.file2 = write_raw("dn_raw_2.f32", array_values(40, true));
+    std::ostringstream oss;
+    EXPECT_EQ(NumericDiff(opts, oss).run().n_different_lines, 5u);
+
+    opts.columns_to_compare = {1, 2};  // The perturbed column is not compared
+    EXPECT_EQ(NumericDiff(opts, oss).run().n_different_lines, 0u);
+
+    opts.shape = {41, 3};
+    EXPECT_THROW(NumericDiff(opts, oss).run(), std::runtime_error);
+    opts.shape = {7};  // 40 * 3 values are not whole rows of 7
+    EXPECT_THROW(NumericDiff(opts, oss).run(), std::runtime_error);
+}
+
+#ifdef DIFF_NUMERICS_WITH_HDF5
+// Test: HDF5 datasets are compared like arrays, and printed rows are rendered as text
+TEST(ArraySource, Hdf5Dataset) {
+    auto write_h5 = [](const std::string& name, const std::vector<double>& values) {
+        std::string path = (fs::temp_directory_path() / name).string();
+        hid_t file = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        hsize_t dims[2] = {values.size() / 3, 3};
+        hid_t space = H5Screate_simple(2, dims, nullptr);
+        hid_t data = H5Dcreate2(file, "/field", H5T_IEEE_F64LE, space, H5P_DEFAULT,
+                                H5P_DEFAULT, H5P_DEFAULT);
+        H5Dwrite(data, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+        H5Dclose(data);
+        H5Sclose(space);
+        H5Fclose(file);
+        return path;
+    };
+    NumericDiffOptions opts;
+    opts.dataset = "/field";
+    opts.file1 = write_h5("dn_array_1.h5", array_values(20, false));
+    opts.file2 = write_h5("dn_array_2.h5", array_values(20, true));
+    EXPECT_EQ(ArraySource::detect(opts.file1), InputFormat::hdf5);
+    std::ostringstream oss;
+    NumericDiffResult result = NumericDiff(opts, oss).run();
+    EXPECT_EQ(result.n_different_lines, 2u);
+    EXPECT_NE(oss.str().find("6.25"), std::string::npos);  // Row 7 of file1, as text
+
+    opts.dataset = "/missing";
+    EXPECT_THROW(NumericDiff(opts, oss).run(), std::runtime_error);
+}
+#endif
+
+// --- Tests for compressed and prefetched input ---
+
+// Byte reader over a string, returning at most `step` bytes per call (or failing at the end)
+class StringReader : public ByteReader {
+   public:
+    StringReader(std::string data, size_t step, bool fail_at_end = false)
+        : data_(std::move(data)), step_(step), fail_at_end_(fail_at_end) {}
+    size_t read(char* dst, size_t capacity) override {
+        size_t n = std::min({capacity, step_, data_.size() - pos_});
+        if (n == 0 && fail_at_end_) throw std::runtime_error("Error: simulated read failure");
+        std::memcpy(dst, data_.data() + pos_, n);
+        pos_ += n;
+        return n;
+    }
+
+   private:
+    std::string data_;
+    size_t step_, pos_ = 0;
+    bool fail_at_end_;
+};
+
+// Test: Prefetching with tiny blocks keeps every byte in order and surfaces reader errors
+TEST(ByteReader, PrefetchPreservesStream) {
+    std::string content;
+    for (int i = 0; i < 500; ++i)
+        content += std::to_string(i) + " " + std::to_string(i * 0.5) + "\n";
+    std::vector<std::string> expected;
+    std::istringstream in(content);
+    for (std::string line; std::getline(in, line);) expected.push_back(line);
+
+    StreamLineSource prefetched(
+        std::make_unique<PrefetchReader>(std::make_unique<StringReader>(content, 5), 7, 2));
+    EXPECT_EQ(read_all_lines(prefetched), expected);
+
+    StreamLineSource failing(
+        std::make_unique<PrefetchReader>(std::make_unique<StringReader>(content, 64, true), 256, 3));
+    std::string_view line;
+    size_t n_lines = 0;
+    EXPECT_THROW(
+        {
+            while (failing.next_line(line)) ++n_lines;
+        },
+        std::runtime_error);
+    EXPECT_EQ(n_lines, expected.size());  // Data preceding the failure is delivered first
+}
+
+#if defined(DIFF_NUMERICS_WITH_ZLIB) && defined(DIFF_NUMERICS_WITH_XZ)
+// Test: gzip (multi-member) and xz inputs are detected and compared like the plain files
+TEST(LineSource, CompressedInputsMatchPlain) {
+    std::string plain1 = test_data_path("delta_3P2-3F2.dat");
+    std::string plain2 = test_data_path("delta_3P2-3F2_2.dat");
+    auto slurp = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream content;
+        content << in.rdbuf();
+        return content.str();
+    };
+    auto write_file = [](const std::string& name, const std::string& bytes) {
+        std::string path = (fs::temp_directory_path() / name).string();
+        std::ofstream(path, std::ios::binary) << bytes;
+        return path;
+    };
+
+    // gzip: two members, split in the middle of the file
+    std::string text1 = slurp(plain1);
+    std::string gz;
+    for (std::string part : {text1.substr(0, text1.size() / 2), text1.substr(text1.size() / 2)}) {
+        uLongf capacity = compressBound(static_cast<uLong>(part.size())) + 32;
+        std::vector<Bytef> out(capacity);
+        z_stream zs{};
+        deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);  // +16: gzip header
+        zs.next_in = reinterpret_cast<Bytef*>(part.data());
+        zs.avail_in = static_cast<uInt>(part.size());
+        zs.next_out = out.data();
+        zs.avail_out = static_cast<uInt>(capacity);
+        ASSERT_EQ(deflate(&zs, Z_FINISH), Z_STREAM_END);
+        gz.append(reinterpret_cast<char*>(out.data()), zs.total_out);
+        deflateEnd(&zs);
+    }
+    std::string gz1 = write_file("dn_compressed_1.dat.gz", gz);
+
+    // xz
+    std::string text2 = slurp(plain2);
+    std::vector<std::uint8_t> xz(lzma_stream_buffer_bound(text2.size()));
+    size_t xz_size = 0;
+    ASSERT_EQ(lzma_easy_buffer_encode(6, LZMA_CHECK_CRC64, nullptr,
+                                      reinterpret_cast<const std::uint8_t*>(text2.data()),
+                                      text2.size(), xz.data(), &xz_size, xz.size()),
+              LZMA_OK);
+    std::string xz2 = write_file("dn_compressed_2.dat.xz",
+                                 std::string(reinterpret_cast<char*>(xz.data()), xz_size));
+
+    auto lines1 = LineSource::open(gz1);
+    auto expected1 = LineSource::open(plain1);
+    EXPECT_EQ(read_all_lines(*lines1), read_all_lines(*expected1));
+
+    FullOutput compressed = run_diff(gz1, xz2, 1e-2, 1e-6, true, false, false, false);
+    FullOutput plain = run_diff(plain1, plain2, 1e-2, 1e-6, true, false, false, false);
+    EXPECT_EQ(compressed.output, plain.output);
+    EXPECT_EQ(compressed.result.n_different_lines, plain.result.n_different_lines);
+
+    // Truncated stream is an error, not a silently shorter file
+    std::string truncated = write_file("dn_truncated.dat.gz", gz.substr(0, gz.size() / 3));
+    auto broken = LineSource::open(truncated);
+    EXPECT_THROW(read_all_lines(*broken), std::runtime_error);
+}
+#endif
+
+// Test: buffered output is only written at the threshold or on flush
+TEST(OutputBuffer, FlushesAtThresholdAndOnDestruction) {
+    std::ostringstream os;
+    {
+        OutputBuffer out(&os, 8);
+        out.append("abc");
+        out.commit();
+        EXPECT_TRUE(os.str().empty());
+        out.append_fill(5, '-');
+        out.append('\n');
+        out.commit();
+        EXPECT_EQ(os.str(), "abc-----\n");
+        out.append("tail");
+    }
+    EXPECT_EQ(os.str(), "abc-----\ntail");
+}
+
+// Test: truncation into a buffer keeps colors balanced like extract_visible_prefix
+TEST(Printer, CellsMatchTokenRendering) {
+    std::string red = "1.25";
+    Formatter::make_red(red);
+    for (const std::string& text : {std::string("plain text"), "a " + red + " b", red + red}) {
+        for (size_t n : {0, 1, 3, 4, 6, 100}) {
+            std::string appended = "x";
+            Formatter::append_visible_prefix(appended, text, n);
+            EXPECT_EQ(appended, "x" + Formatter::extract_visible_prefix(text, n)) << n;
+        }
+    }
+    EXPECT_EQ(Formatter::visible_width("a " + red + " b"), 8u);
+
+    std::vector<std::string> tokens1 = {"1.0", red, "x"};
+    std::vector<std::string> tokens2 = {"1.0", "1.30", "x", "extra"};
+    std::vector<size_t> widths = {4, 5, 1};
+    std::ostringstream by_tokens, by_cells;
+    {
+        Printer printer(by_tokens);
+        printer.print_side_by_side_tokens(tokens1, tokens2, widths, 12);
+        printer.print_side_by_side_tokens({"1"}, {"1"}, {1}, 60);
+    }
+    {
+        OutputBuffer out(&by_cells);
+        Printer printer(out);
+        std::vector<Printer::Cell> cells1 = {{"1.0", 3}, {red, 4}, {"x", 1}};
+        std::vector<Printer::Cell> cells2 = {{"1.0", 3}, {"1.30", 4}, {"x", 1}, {"extra", 5}};
+        printer.print_side_by_side_cells(cells1, cells2, widths, 12);
+        printer.print_side_by_side_cells({{"1", 1}}, {{"1", 1}}, {1}, 60);
+    }
+    EXPECT_EQ(by_cells.str(), by_tokens.str());
+    EXPECT_EQ(by_tokens.str(), "1.0  " + red + "  x   |   1.0  1.30  x\n1       1\n");
+}
+
+// Test: rendering into a token arena gives the strings of the string-returning API
+TEST(Formatter, ArenaRenderingMatchesStringApi) {
+    TokenArena arena;
+    const std::vector<std::pair<std::string, std::string>> pairs = {
+        {"3.14159", "3.14259"}, {"1.23e5", "1.23e6"}, {"1.5", "1.50"}, {"2e-3", "2e-3"}};
+    for (int pass = 0; pass < 2; ++pass) {  // The second pass reuses the arena's storage
+        arena.clear();
+        for (const auto& [a, b] : pairs) Formatter::append_different_digits(arena, a, b);
+        ASSERT_EQ(arena.size(), 2 * pairs.size());
+        for (size_t k = 0; k < pairs.size(); ++k) {
+            std::string s1 = pairs[k].first, s2 = pairs[k].second;
+            Formatter::colorize_different_digits(s1, s2);
+            EXPECT_EQ(arena.token(2 * k), s1);
+            EXPECT_EQ(arena.token(2 * k + 1), s2);
+        }
+    }
+    EXPECT_EQ(arena.token(0), "3.14\033[31m159\033[0m");
+    EXPECT_EQ(arena.token(3), "1.23\033[31me6\033[0m");
+
+    std::string red = "x";
+    Formatter::append_red(red, "12");
+    EXPECT_EQ(red, "x\033[31m12\033[0m");
+    std::string plain = "<";
+    Formatter::append_stripped(plain, red + " y\033[31m");
+    EXPECT_EQ(plain, "<x12 y");
+    EXPECT_EQ(Formatter::strip_ansi(red + " \033[1;31mz"), "x12 z");
+}
+
+// Test: --stats counters describe the work done, and are not collected by default
+TEST(DiffNumerics, StatsCountStages) {
+    std::string a = "# header\n1.0 x 2.0\n5 5 5\n3.0 y 4.0\n";
+    std::string b = "# header\n1.0 x 2.5\n5 5 5\n3.0 z 4.0\n";
+    NumericDiffOptions opts;
+    std::ostringstream oss;
+    {
+        BufferLineSource source1(a), source2(b);
+        EXPECT_EQ(NumericDiff(opts, oss).run(source1, source2).stats.lines, 0u);
+    }
+
+    opts.stats = StatsFormat::json;
+    BufferLineSource source1(a), source2(b);
+    oss.str("");
+    NumericDiffResult result = NumericDiff(opts, oss).run(source1, source2);
+    const RunStats& stats = result.stats;
+    EXPECT_EQ(stats.lines, 3u);
+    EXPECT_EQ(stats.identical_lines, 1u);  // "5 5 5" is never tokenized
+    EXPECT_EQ(stats.comment_lines, 2u);
+    EXPECT_EQ(stats.bytes_read, a.size() + b.size());
+    EXPECT_EQ(stats.tokens, 12u);
+    EXPECT_EQ(stats.numeric_columns, 4u);
+    EXPECT_EQ(stats.text_columns, 2u);
+    EXPECT_EQ(stats.lines_printed, 1u);
+    EXPECT_EQ(stats.bytes_written, oss.str().size());
+
+    std::ostringstream report;
+    Printer::print_stats(report, stats, StatsFormat::json);
+    EXPECT_EQ(report.str().front(), '{');
+    EXPECT_NE(report.str().find("\"lines\":3,"), std::string::npos);
+    EXPECT_NE(report.str().find("\"stages_ms\":{\"read\":"), std::string::npos);
+}
+
+// --- Tests for batch mode ---
+
+// Test: A manifest runs every pair with its own options; output and results match single runs
+// and a failing pair is reported without stopping the batch
+TEST(BatchRunner, ManifestMatchesSingleRuns) {
+    std::string d1 = test_data_path("delta_3D2.dat"), d2 = test_data_path("delta_3D2_2.dat");
+    std::string p1 = test_data_path("delta_3P2-3F2.dat");
+    std::string p2 = test_data_path("delta_3P2-3F2_2.dat");
+    std::string manifest = (fs::temp_directory_path() / "diff-numerics-batch.txt").string();
+    {
+        std::ofstream out(manifest);
+        out << "# pairs\n\n"
+            << d1 << " " << d2 << " -t 1e3\n"
+            << p1 << " " << p2 << " -y\n"
+            << "missing1.dat missing2.dat\n";
+    }
+    std::vector<NumericDiffOptions> pairs = BatchRunner::read_manifest(manifest, {"-w", "80"});
+    ASSERT_EQ(pairs.size(), 3u);
+    EXPECT_EQ(pairs[0].tolerance, 1e3);
+    EXPECT_TRUE(pairs[1].side_by_side);
+    EXPECT_EQ(pairs[1].line_length, 80);
+
+    std::ostringstream printed;
+    std::vector<BatchOutcome> outcomes = BatchRunner(3).run(pairs, &printed);
+    ASSERT_EQ(outcomes.size(), 3u);
+    for (size_t i = 0; i < 2; ++i) {
+        std::ostringstream single;
+        NumericDiffResult expected = NumericDiff(pairs[i], single).run();
+        EXPECT_FALSE(outcomes[i].failed);
+        EXPECT_EQ(outcomes[i].result.n_different_lines, expected.n_different_lines);
+        EXPECT_EQ(outcomes[i].result.max_percentage_err, expected.max_percentage_err);
+        if (!single.str().empty()) EXPECT_NE(printed.str().find(single.str()), std::string::npos);
+    }
+    EXPECT_TRUE(outcomes[2].failed);
+    EXPECT_NE(outcomes[2].error.find("missing1.dat"), std::string::npos);
+
+    std::ostringstream summary;
+    BatchRunner::print_summary(summary, pairs, outcomes);
+    EXPECT_NE(summary.str().find("ERROR"), std::string::npos);
+    EXPECT_NE(summary.str().find("Pairs: 3"), std::string::npos);
+
+    {
+        std::ofstream out(manifest);
+        out << d1 << "\n";
+    }
+    EXPECT_THROW(BatchRunner::read_manifest(manifest, {}), std::runtime_error);
+    std::remove(manifest.c_str());
+}
+
+// Test: Tasks that wait for their own subtasks do not deadlock a pool smaller than the nesting
+TEST(ThreadPool, NestedWaitRunsSubtasks) {
+    ThreadPool pool(2);
+    std::atomic<int> leaves{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 8; ++i) {
+        outer.push_back(pool.submit([&] {
+            std::vector<std::future<void>> inner;
+            for (int k = 0; k < 16; ++k) inner.push_back(pool.submit([&] { leaves++; }));
+            for (std::future<void>& done : inner) {
+                pool.wait(done);
+                done.get();
+            }
+        }));
+    }
+    for (std::future<void>& done : outer) done.get();
+    EXPECT_EQ(leaves.load(), 8 * 16);
+}
+
+// Test: The parallel engine running as a task of a shared pool matches the sequential engine
+TEST(DiffNumerics, ParallelOnSharedPoolMatchesSequential) {
+    std::string file1 = write_large_file("dn_shared_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_shared_2.dat", 60000, 997, 5003);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    std::ostringstream sequential_out, parallel_out;
+    NumericDiffResult sequential = NumericDiff(opts, sequential_out).run();
+
+    ThreadPool pool(3);
+    opts.threads = pool.size();
+    NumericDiffResult parallel;
+    pool.submit([&] {
+            NumericDiff diff(opts, parallel_out);
+            diff.set_pool(&pool);
+            parallel = diff.run();
+        })
+        .get();
+    EXPECT_GT(sequential.n_different_lines, 0u);
+    EXPECT_EQ(parallel.n_different_lines, sequential.n_different_lines);
+    EXPECT_EQ(parallel_out.str(), sequential_out.str());
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// Test: Directory trees are paired by relative path; files in one tree only are reported
+TEST(BatchRunner, PairDirectories) {
+    fs::path root = fs::temp_directory_path() / "diff-numerics-dirs";
+    fs::remove_all(root);
+    for (const char* dir : {"a/sub", "b/sub"}) fs::create_directories(root / dir);
+    fs::copy_file(test_data_path("delta_3D2.dat"), root / "a/sub/x.dat");
+    fs::copy_file(test_data_path("delta_3D2_2.dat"), root / "b/sub/x.dat");
+    std::ofstream(root / "a/same.dat") << "1 2 3\n";
+    std::ofstream(root / "b/same.dat") << "1 2 3\n";
+    std::ofstream(root / "a/extra.dat") << "1\n";
+    std::ofstream(root / "b/sub/new.dat") << "1\n";
+
+    NumericDiffOptions opts;
+    opts.file1 = (root / "a").string();
+    opts.file2 = (root / "b").string();
+    opts.tolerance = 1e-3;
+    DirectoryPairing pairing = BatchRunner::pair_directories(opts);
+    ASSERT_EQ(pairing.pairs.size(), 2u);
+    EXPECT_EQ(pairing.pairs[0].file1, (root / "a" / "same.dat").string());
+    EXPECT_EQ(pairing.pairs[1].file2, (root / "b" / "sub/x.dat").string());
+    EXPECT_EQ(pairing.pairs[1].tolerance, 1e-3);
+    EXPECT_EQ(pairing.only_in1, std::vector<std::string>{"extra.dat"});
+    EXPECT_EQ(pairing.only_in2, std::vector<std::string>{"sub/new.dat"});
+
+    std::vector<BatchOutcome> outcomes = BatchRunner(2).run(pairing.pairs);
+    EXPECT_EQ(outcomes[0].result.n_different_lines, 0u);
+    EXPECT_GT(outcomes[1].result.n_different_lines, 0u);
+    std::ostringstream report;
+    BatchRunner::print_unpaired(report, opts, pairing);
+    EXPECT_NE(report.str().find("Only in " + opts.file2 + ": sub/new.dat"), std::string::npos);
+    fs::remove_all(root);
+}
+
+// --- Tests for the streaming API ---
+
+// Test: Inputs fed in random chunks give the output and result of run(); callbacks report
+// every value beyond tolerance
+TEST(StreamingDiff, ChunkedFeedMatchesRun) {
+    std::string text1, text2;
+    {
+        std::ifstream in1(test_data_path("delta_3P2-3F2.dat"));
+        std::ifstream in2(test_data_path("delta_3P2-3F2_2.dat"));
+        text1.assign(std::istreambuf_iterator<char>(in1), std::istreambuf_iterator<char>());
+        text2.assign(std::istreambuf_iterator<char>(in2), std::istreambuf_iterator<char>());
+    }
+    for (bool side_by_side : {false, true}) {
+        NumericDiffOptions opts;
+        opts.side_by_side = side_by_side;
+        std::ostringstream expected_out, streamed_out;
+        BufferLineSource source1(text1), source2(text2);
+        NumericDiffResult expected = NumericDiff(opts, expected_out).run(source1, source2);
+
+        std::vector<DiffEvent> events;
+        StreamingDiff stream(opts, streamed_out, [&](const DiffEvent& e) {
+            events.push_back(e);
+            events.back().token1 = events.back().token2 = {};  // Views end with the callback
+        });
+        std::mt19937 rng(7);
+        size_t pos1 = 0, pos2 = 0;
+        while (pos1 < text1.size() || pos2 < text2.size()) {
+            size_t n = rng() % 300;
+            if (rng() % 2 == 0 && pos1 < text1.size()) {
+                stream.feed1(std::string_view(text1).substr(pos1, n));
+                pos1 += n;
+            } else if (pos2 < text2.size()) {
+                stream.feed2(std::string_view(text2).substr(pos2, n));
+                pos2 += n;
+            }
+        }
+        NumericDiffResult streamed = stream.finish();
+        EXPECT_EQ(streamed.n_different_lines, expected.n_different_lines);
+        EXPECT_EQ(streamed.max_percentage_err, expected.max_percentage_err);
+        EXPECT_EQ(streamed.first_diff.line1, expected.first_diff.line1);
+        EXPECT_EQ(streamed_out.str(), expected_out.str());
+        ASSERT_FALSE(events.empty());
+        EXPECT_EQ(events.front().line1, expected.first_diff.line1);
+        EXPECT_EQ(events.front().column, expected.first_diff.column);
+    }
+}
+
+// Test: Line feeding, --first-diff stop and a line left over on one side
+TEST(StreamingDiff, LinesFirstDiffAndLeftovers) {
+    NumericDiffOptions opts;
+    opts.first_diff = true;
+    StreamingDiff stream(opts);
+    stream.feed_line1("# comment");
+    stream.feed_line1("1.0 2.0");
+    stream.feed_line2("1.0 2.0");
+    EXPECT_EQ(stream.result().n_different_lines, 0u);
+    stream.feed_line1("1.0 3.0");
+    stream.feed_line2("1.0 2.0");
+    EXPECT_TRUE(stream.stopped());
+    EXPECT_EQ(stream.result().first_diff.line1, 3u);
+    EXPECT_EQ(stream.result().first_diff.line2, 2u);
+    EXPECT_EQ(stream.result().first_diff.column, 2u);
+
+    StreamingDiff unterminated(NumericDiffOptions{});
+    unterminated.feed1("1.0 2.0\n3.0");
+    unterminated.feed2("1.0 2.0\n3.0\n\n");
+    EXPECT_EQ(unterminated.finish().n_different_lines, 0u);
+
+    StreamingDiff longer(NumericDiffOptions{});
+    longer.feed1("1.0\n2.0\n");
+    longer.feed2("1.0\n");
+    EXPECT_THROW(longer.finish(), std::runtime_error);
+}
+
+// --- Tests for the parsed-reference cache ---
+
+// Test: --cache output matches the text path on first (build) and second (mapped) runs, and a
+// reference edited in place invalidates its sidecar
+TEST(ReferenceCache, CachedRunsMatchTextRuns) {
+    std::string reference = (fs::temp_directory_path() / "dn_cache_ref.dat").string();
+    std::string cache = ReferenceCache::default_path(reference);
+    copy_file(test_data_path("delta_3P2-3F2.dat"), reference);
+    fs::remove(cache);
+
+    NumericDiffOptions opts;
+    opts.file1 = reference;
+    opts.file2 = test_data_path("delta_3P2-3F2_2.dat");
+    opts.side_by_side = true;
+    auto run_with = [&](const std::string& cache_path) {
+        NumericDiffOptions o = opts;
+        o.reference_cache = cache_path;
+        FullOutput full;
+        std::ostringstream oss;
+        full.result = NumericDiff(o, oss).run();
+        full.output = oss.str();
+        return full;
+    };
+    FullOutput text = run_with("");
+    for (int pass = 0; pass < 2; ++pass) {
+        FullOutput cached = run_with(cache);
+        EXPECT_TRUE(fs::exists(cache));
+        EXPECT_EQ(cached.output, text.output);
+        EXPECT_EQ(cached.result.n_different_lines, text.result.n_different_lines);
+        EXPECT_EQ(cached.result.first_diff.line1, text.result.first_diff.line1);
+    }
+
+    // Same size, different content: the stale cache must not be used
+    std::string content;
+    {
+        std::ifstream in(reference);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    size_t first_data = content.find('\n', content.find_first_not_of('#'));
+    size_t digit = content.find_first_of("123456789", first_data);
+    content[digit] = content[digit] == '9' ? '1' : '9';
+    std::ofstream(reference, std::ios::binary) << content;
+    EXPECT_EQ(ReferenceCache::load(cache, content, "#"), nullptr);
+    EXPECT_EQ(run_with(cache).output, run_with("").output);
+    EXPECT_NE(ReferenceCache::load(cache, content, "#"), nullptr);  // Rebuilt
+    EXPECT_EQ(ReferenceCache::load(cache, content, "%"), nullptr);  // Other comment prefix
+    fs::remove(reference);
+    fs::remove(cache);
+}
+
+// Test: a sidecar written by an older format version (here: one whose parser took D exponents for
+// text) is rejected and rebuilt, so its stale token verdicts never reach a comparison
+TEST(ReferenceCache, OldFormatVersionIsRebuilt) {
+    std::string reference = (fs::temp_directory_path() / "dn_cache_old.dat").string();
+    std::string candidate = (fs::temp_directory_path() / "dn_cache_old_2.dat").string();
+    std::string cache = ReferenceCache::default_path(reference);
+    std::string content = "1.0D+00 2.0\n";
+    std::ofstream(reference, std::ios::binary) << content;
+    std::ofstream(candidate, std::ios::binary) << "1.1D+00 2.0\n";
+    ASSERT_TRUE(ReferenceCache::build(content, "#")->write(cache));
+    ASSERT_NE(ReferenceCache::load(cache, content, "#"), nullptr);
+
+    std::string image;
+    {
+        std::ifstream in(cache, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::uint32_t old_version = 1;
+    std::memcpy(&image[8], &old_version, sizeof(old_version));  // Version follows the magic
+    image[image.size() - 8] = 0;  // numeric[0], in the last 8-byte section: "1.0D+00" is text
+    std::ofstream(cache, std::ios::binary) << image;
+    EXPECT_EQ(ReferenceCache::load(cache, content, "#"), nullptr);
+
+    NumericDiffOptions opts;
+    opts.file1 = reference;
+    opts.file2 = candidate;
+    opts.reference_cache = cache;
+    std::ostringstream oss;
+    EXPECT_EQ(NumericDiff(opts, oss).run().n_different_lines, 1);
+    EXPECT_NE(ReferenceCache::load(cache, content, "#"), nullptr);  // Rebuilt
+    fs::remove(reference);
+    fs::remove(candidate);
+    fs::remove(cache);
+}
+
+// Test: a sidecar whose line records point outside the text or the token arrays, or whose
+// numeric flags are not 0/1, is rejected and rebuilt instead of crashing the comparison
+TEST(ReferenceCache, CorruptedLineRecordIsRebuilt) {
+    std::string reference = (fs::temp_directory_path() / "dn_cache_bad.dat").string();
+    std::string candidate = (fs::temp_directory_path() / "dn_cache_bad_2.dat").string();
+    std::string cache = ReferenceCache::default_path(reference);
+    std::string content = "1.0 2.0\n3.0 4.0\n";
+    std::ofstream(reference, std::ios::binary) << content;
+    std::ofstream(candidate, std::ios::binary) << "1.0 2.0\n3.0 4.5\n";
+    ASSERT_TRUE(ReferenceCache::build(content, "#")->write(cache));
+    std::string image;
+    {
+        std::ifstream in(cache, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    // Image ends with Line[2] | double[4] | uint8[4] padded to 8 bytes
+    size_t numeric = image.size() - 8;
+    size_t first_line = numeric - 4 * sizeof(double) - 2 * sizeof(ReferenceCache::Line);
+    auto corrupt = [&](size_t at, std::uint64_t value, size_t size) {
+        std::string bad = image;
+        std::memcpy(&bad[at], &value, size);
+        return bad;
+    };
+    const std::string corrupted[] = {
+        corrupt(first_line + offsetof(ReferenceCache::Line, offset), 0x7fffffff, 8),
+        corrupt(first_line + offsetof(ReferenceCache::Line, length), 1000, 4),
+        corrupt(first_line + offsetof(ReferenceCache::Line, first_token), 1ULL << 40, 8),
+        corrupt(first_line + sizeof(ReferenceCache::Line) + offsetof(ReferenceCache::Line, n_tokens),
+                3, 4),
+        corrupt(numeric + 1, 2, 1),
+    };
+    for (const std::string& bad : corrupted) {
+        std::ofstream(cache, std::ios::binary | std::ios::trunc) << bad;
+        EXPECT_EQ(ReferenceCache::load(cache, content, "#"), nullptr);
+
+        NumericDiffOptions opts;
+        opts.file1 = reference;
+        opts.file2 = candidate;
+        opts.reference_cache = cache;
+        std::ostringstream oss;
+        EXPECT_EQ(NumericDiff(opts, oss).run().n_different_lines, 1);
+        EXPECT_NE(ReferenceCache::load(cache, content, "#"), nullptr);  // Rebuilt
+    }
+    fs::remove(reference);
+    fs::remove(candidate);
+    fs::remove(cache);
+}
+
+// --- Tests for resynchronization ---
+
+// Test: --resync pairs the rows around a deleted, an inserted and a changed row, with and without
+// a key column, and reports the unmatched rows in both output formats
+TEST(DiffNumerics, ResyncRealignsInsertedAndDeletedLines) {
+    std::string text1, text2;
+    for (int i = 1; i <= 30; ++i) {
+        std::string row = std::to_string(i) + " " + std::to_string(i * 0.5) + "\n";
+        if (i != 5) text2 += row;           // Row 5 deleted from file2
+        if (i == 12) text2 += "99 1.5\n";   // Row inserted after row 12
+        if (i == 20) row = "20 11.0\n";     // Row 20 changed in file1
+        text1 += row;
+    }
+
+    for (size_t key : {size_t{0}, size_t{1}}) {
+        NumericDiffOptions opts;
+        opts.resync_window = 8;
+        opts.key_column = key;
+        std::ostringstream oss;
+        BufferLineSource source1(text1), source2(text2);
+        NumericDiffResult result = NumericDiff(opts, oss).run(source1, source2);
+        EXPECT_EQ(result.n_only_in1, 1u);
+        EXPECT_EQ(result.n_only_in2, 1u);
+        EXPECT_EQ(result.n_different_lines, 3u);
+        EXPECT_EQ(result.first_diff.line1, 5u);
+        EXPECT_EQ(result.first_diff.column, 0u);
+        std::string plain = Formatter::strip_ansi(oss.str());
+        EXPECT_NE(plain.find("\n< 5 2.500000\n"), std::string::npos);
+        EXPECT_NE(plain.find("\n> 99 1.5\n"), std::string::npos);
+        EXPECT_NE(plain.find("\n< 20 11.0\n> 20 10.000000\n"), std::string::npos);
+
+        opts.side_by_side = true;
+        opts.suppress_common_lines = true;
+        std::ostringstream side;
+        BufferLineSource side1(text1), side2(text2);
+        NumericDiff(opts, side).run(side1, side2);
+        plain = Formatter::strip_ansi(side.str());
+        EXPECT_NE(plain.find("5 2.500000   <\n"), std::string::npos);
+        EXPECT_NE(plain.find("   >   99 1.5\n"), std::string::npos);
+    }
+
+    // Without resync the rows between the deletion and the insertion are paired off by one
+    NumericDiffOptions opts;
+    opts.quiet = true;
+    BufferLineSource source1(text1), source2(text2);
+    EXPECT_EQ(NumericDiff(opts).run(source1, source2).n_different_lines, 9u);
+}
+
+// --- Tests for the key-column join ---
+
+// Test: KeyIndex hands out each row once, lowest id first, with keys matched within tolerance
+TEST(KeyIndex, TolerantKeysAndDuplicates) {
+    KeyIndex index({1, 3}, 0.01);
+    EXPECT_TRUE(index.add("1.000 a x"));
+    EXPECT_TRUE(index.add("2.000 b x"));
+    EXPECT_TRUE(index.add("1.000 c x"));
+    EXPECT_FALSE(index.add("3.000 d"));  // No third column
+    EXPECT_TRUE(index.add("4.995 e y"));
+    index.build();
+    EXPECT_EQ(index.take("0.995 - x"), 0u);
+    EXPECT_EQ(index.take("1.004 - x"), 2u);
+    EXPECT_EQ(index.take("1.000 - x"), KeyIndex::npos);  // Both duplicates taken
+    EXPECT_EQ(index.take("2.000 - y"), KeyIndex::npos);  // Text key differs
+    EXPECT_EQ(index.take("2.02 - x"), KeyIndex::npos);   // Beyond tolerance
+    EXPECT_EQ(index.take("5.004 - y"), 4u);              // Across a cell boundary
+    EXPECT_EQ(index.take("3.000 d"), KeyIndex::npos);
+    EXPECT_TRUE(index.taken(0));
+    EXPECT_FALSE(index.taken(1));
+}
+
+// Test: --join pairs shuffled rows by key, in memory and through disk partitions alike
+TEST(DiffNumerics, JoinPairsShuffledRows) {
+    std::vector<std::string> rows;
+    std::string text1 = "# t value\n";
+    for (int i = 0; i < 200; ++i) {
+        char row[64];
+        std::snprintf(row, sizeof(row), "%.4f %d.5\n", i * 0.25, i);
+        text1 += row;
+        if (i == 17) continue;  // Missing from file2
+        std::snprintf(row, sizeof(row), "%.9f %d.5\n", i * 0.25 + 1e-7, i == 42 ? i + 9 : i);
+        rows.push_back(row);
+    }
+    rows.push_back("999 1.0\n");  // Only in file2
+    std::shuffle(rows.begin(), rows.end(), std::mt19937(7));
+    std::string text2;
+    for (const std::string& row : rows) text2 += row;
+
+    for (std::uint64_t memory : {std::uint64_t{1} << 30, std::uint64_t{1}}) {
+        NumericDiffOptions opts;
+        opts.join_columns = {1};
+        opts.key_tolerance = 1e-6;
+        opts.join_memory = memory;
+        std::ostringstream oss;
+        BufferLineSource source1(text1), source2(text2);
+        NumericDiffResult result = NumericDiff(opts, oss).run(source1, source2);
+        EXPECT_EQ(result.n_only_in1, 1u);
+        EXPECT_EQ(result.n_only_in2, 1u);
+        EXPECT_EQ(result.n_different_lines, 3u);
+        std::string plain = Formatter::strip_ansi(oss.str());
+        EXPECT_NE(plain.find("\n< 4.2500 17.5\n"), std::string::npos);
+        EXPECT_NE(plain.find("\n> 999 1.0\n"), std::string::npos);
+        EXPECT_NE(plain.find("\n< 10.5000 42.5\n> 10.500000100 51.5\n"), std::string::npos);
+    }
+
+    // Exact keys: the perturbed keys no longer pair
+    NumericDiffOptions opts;
+    opts.quiet = true;
+    opts.join_columns = {1};
+    BufferLineSource source1(text1), source2(text2);
+    EXPECT_EQ(NumericDiff(opts).run(source1, source2).n_only_in1, 200u);
+}
+
+// --- Tests for the per-mode line loops ---
+
+// Test: the specialized loop of every output mode and column filter prints and counts exactly
+// what the generic loop does, sequential and in parallel
+TEST(DiffNumerics, SpecializedLoopsMatchGenericLoop) {
+    NumericDiffOptions base;
+    base.file1 = test_data_path("delta_3P2-3F2.dat");
+    base.file2 = test_data_path("delta_3P2-3F2_2.dat");
+    std::vector<NumericDiffOptions> modes(6, base);
+    modes[1].side_by_side = true;
+    modes[2].side_by_side = true;
+    modes[2].suppress_common_lines = true;
+    modes[3].only_equal = true;
+    modes[4].columns_to_compare = {1, 3};
+    modes[5].side_by_side = true;
+    modes[5].columns_to_compare = {2};
+    modes[5].color_diff_digits = true;
+    for (NumericDiffOptions opts : modes) {
+        for (size_t threads : {1, 2}) {
+            opts.threads = threads;
+            auto run_with = [&](bool specialize) {
+                NumericDiffOptions o = opts;
+                o.specialize = specialize;
+                FullOutput full;
+                std::ostringstream oss;
+                full.result = NumericDiff(o, oss).run();
+                full.output = oss.str();
+                return full;
+            };
+            FullOutput generic = run_with(false);
+            FullOutput specialized = run_with(true);
+            EXPECT_EQ(specialized.output, generic.output);
+            EXPECT_EQ(specialized.result.n_different_lines, generic.result.n_different_lines);
+            EXPECT_EQ(specialized.result.first_diff.column, generic.result.first_diff.column);
+            EXPECT_DOUBLE_EQ(specialized.result.max_percentage_err,
+                             generic.result.max_percentage_err);
+        }
+    }
+}
+
+// --- Tests for --fixed-width ---
+
+// Test: the layout is learned from consistent lines, slices lines that fit it and rejects the rest
+TEST(FixedWidthLayout, LearnsAndSlicesFields) {
+    std::vector<std::string_view> tokens;
+    auto learn = [&](FixedWidthLayout& layout, std::initializer_list<std::string_view> lines) {
+        for (std::string_view line : lines) {
+            TextParser::tokenize(line, tokens);
+            layout.observe(line, tokens);
+        }
+    };
+    FixedWidthLayout layout(2);
+    learn(layout, {"   1.5E+00  abc   2.0", "", "  12.5E+00  de   -3.0"});
+    ASSERT_TRUE(layout.ready());
+    ASSERT_EQ(layout.size(), 3u);
+    EXPECT_EQ(layout.width(1), 4u);
+
+    const ColumnSelection all;
+    ASSERT_TRUE(layout.slice("  -1.5E+00  xyz -20.0", all, tokens));  // Wider to the left
+    EXPECT_EQ(tokens, (std::vector<std::string_view>{"-1.5E+00", "xyz", "-20.0"}));
+    ASSERT_TRUE(layout.slice("   1.5E+00  abc   2", all, tokens));  // Short last field
+    EXPECT_EQ(tokens[2], "2");
+    ASSERT_TRUE(layout.slice("   1.5E+00  abc   2.0", ColumnSelection({3}), tokens));
+    EXPECT_EQ(tokens, (std::vector<std::string_view>{"2.0"}));
+
+    EXPECT_FALSE(layout.slice("   1.5E+000 abc   2.0", all, tokens));  // Runs into the gap
+    EXPECT_FALSE(layout.slice("   1.5E+00        2.0", all, tokens));  // Blank field
+    EXPECT_FALSE(layout.slice("   1.5E+00  a b   2.0", all, tokens));  // Two tokens in a field
+    EXPECT_FALSE(layout.slice("   1.5E+00  abc   2.0 7", all, tokens));  // Extra column
+    EXPECT_FALSE(layout.slice("   1.5E+00  abc", all, tokens));          // Missing column
+
+    FixedWidthLayout ragged(2);
+    learn(ragged, {"1.0 2.0", "1.0 2.0 3.0"});
+    EXPECT_FALSE(ragged.learning());
+    EXPECT_FALSE(ragged.ready());
+    FixedWidthLayout touching(2);
+    learn(touching, {"1.0   2.0", "  1.0000 2.0"});  // Token extents overlap across the lines
+    EXPECT_FALSE(touching.ready());
+}
+
+// Test: --fixed-width finds the same differences and prints the same output as tokenizing,
+// and slices the lines past the learned ones
+TEST(DiffNumerics, FixedWidthMatchesTokenizing) {
+    for (size_t threads : {1, 2}) {
+        for (bool side_by_side : {false, true}) {
+            NumericDiffOptions opts;
+            opts.file1 = test_data_path("delta_3P2-3F2.dat");
+            opts.file2 = test_data_path("delta_3P2-3F2_2.dat");
+            opts.threads = threads;
+            opts.side_by_side = side_by_side;
+            opts.stats = StatsFormat::json;
+            FullOutput plain, fixed;
+            std::ostringstream out1, out2;
+            plain.result = NumericDiff(opts, out1).run();
+            opts.fixed_width_lines = FixedWidthLayout::default_learn_lines;
+            fixed.result = NumericDiff(opts, out2).run();
+            EXPECT_EQ(fixed.result.n_different_lines, plain.result.n_different_lines);
+            EXPECT_EQ(fixed.result.first_diff.column, plain.result.first_diff.column);
+            EXPECT_DOUBLE_EQ(fixed.result.max_percentage_err, plain.result.max_percentage_err);
+            EXPECT_EQ(plain.result.stats.sliced_lines, 0u);
+            EXPECT_EQ(fixed.result.stats.sliced_lines, 2 * (200 - 16u));  // One chunk
+
+            EXPECT_EQ(out2.str(), out1.str());  // A pure speed-up: the same output
+        }
+    }
+}
+
+// Test: Two numbers in one field are not taken as one text token: the column count mismatch
+// is found as without --fixed-width
+TEST(DiffNumerics, FixedWidthFieldWithBlanksIsTokenized) {
+    std::string path1 = (fs::temp_directory_path() / "dn_fixed_blank_1.dat").string();
+    std::string path2 = (fs::temp_directory_path() / "dn_fixed_blank_2.dat").string();
+    {
+        std::ofstream out1(path1), out2(path2);
+        for (int i = 1; i <= 20; ++i) {  // Lines of file2 within tolerance, but not identical
+            char row1[32], row2[32];
+            std::snprintf(row1, sizeof(row1), "%4.1f%17.3f\n", static_cast<double>(i), 37.0);
+            std::snprintf(row2, sizeof(row2), "%4.1f%17.3f\n", static_cast<double>(i), 37.001);
+            out1 << row1;
+            out2 << (i == 19 ? "19.0  99.0     37.000\n" : row2);
+        }
+    }
+    NumericDiffOptions opts;
+    opts.file1 = path1;
+    opts.file2 = path2;
+    opts.only_equal = true;
+    std::ostringstream out;
+    EXPECT_THROW(NumericDiff(opts, out).run(), std::runtime_error);
+    opts.fixed_width_lines = FixedWidthLayout::default_learn_lines;
+    EXPECT_THROW(NumericDiff(opts, out).run(), std::runtime_error);
+    fs::remove(path1);
+    fs::remove(path2);
+}
+
+// Test: The layout is learned from the first lines even when they are identical, so the
+// lines past them are sliced
+TEST(DiffNumerics, FixedWidthLearnsFromIdenticalLines) {
+    std::string file1 = write_large_file("dn_fixed_same_1.dat", 2000, 0, 0);
+    std::string file2 = write_large_file("dn_fixed_same_2.dat", 2000, 1000, 0);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.only_equal = true;
+    opts.stats = StatsFormat::json;
+    opts.fixed_width_lines = FixedWidthLayout::default_learn_lines;
+    std::ostringstream out;
+    NumericDiffResult result = NumericDiff(opts, out).run();
+    EXPECT_EQ(result.n_different_lines, 2u);
+    EXPECT_EQ(result.stats.sliced_lines, 2 * 2u);  // Both differing line pairs
+    EXPECT_EQ(result.stats.identical_lines, 2000u - 16u - 2u);
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for the --top report ---
+
+// Test: The K worst differences are the head of the full ranked list, the same with threads,
+// and no line is printed
+TEST(DiffNumerics, TopMatchesFullRanking) {
+    std::string file1 = write_large_file("dn_top_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_top_2.dat", 60000, 997, 5003);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.top_k = 1 << 20;
+    std::ostringstream out;
+    NumericDiffResult all = NumericDiff(opts, out).run();
+    ASSERT_GT(all.n_different_lines, 10u);
+    ASSERT_EQ(all.top.size(), all.n_different_lines);  // One differing value per line
+    for (size_t i = 1; i < all.top.size(); ++i) {
+        EXPECT_TRUE(all.top[i - 1].ranks_before(all.top[i]));
+    }
+
+    opts.top_k = 10;
+    for (size_t threads : {1, 4}) {
+        opts.threads = threads;
+        std::ostringstream top_out;
+        NumericDiffResult top = NumericDiff(opts, top_out).run();
+        EXPECT_EQ(top.n_different_lines, all.n_different_lines);
+        EXPECT_TRUE(top_out.str().empty());
+        ASSERT_EQ(top.top.size(), 10u);
+        for (size_t i = 0; i < top.top.size(); ++i) {
+            const ValueDifference& expected = all.top[i];
+            EXPECT_EQ(top.top[i].line1, expected.line1);
+            EXPECT_EQ(top.top[i].line2, expected.line2);
+            EXPECT_EQ(top.top[i].column, 2u);
+            EXPECT_DOUBLE_EQ(top.top[i].value2, expected.value2);
+            EXPECT_DOUBLE_EQ(top.top[i].error, expected.error);
+        }
+    }
+    EXPECT_DOUBLE_EQ(all.top.front().error, all.max_percentage_err);
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for --column-stats ---
+
+// Test: Errors, running means and histogram bins of one column; a merge of two halves equals
+// one pass over all pairs
+TEST(ColumnErrorStats, AccumulatesAndMerges) {
+    EXPECT_EQ(ColumnErrorStats::bin(0.0), 0u);
+    EXPECT_EQ(ColumnErrorStats::bin(1e-14), 1u);
+    EXPECT_EQ(ColumnErrorStats::bin(50.0), 16u);
+    EXPECT_EQ(ColumnErrorStats::bin(200.0), ColumnErrorStats::n_bins - 1);
+
+    ColumnErrorStats all, first, second;
+    const double pairs[][2] = {{1.0, 1.0}, {2.0, 2.5}, {-4.0, 4.0}, {0.0, 0.0}, {10.0, 10.001}};
+    for (size_t i = 0; i < 5; ++i) {
+        all.add(pairs[i][0], pairs[i][1], i == 1);
+        (i < 2 ? first : second).add(pairs[i][0], pairs[i][1], i == 1);
+    }
+    all.add(1.0, std::numeric_limits<double>::quiet_NaN(), false);
+    all.add(1e308, -1e308, true);  // The error overflows, the pair still differs
+    EXPECT_EQ(all.pairs, 5u);
+    EXPECT_EQ(all.different, 2u);
+    EXPECT_EQ(all.nonfinite, 2u);
+    EXPECT_DOUBLE_EQ(all.max_abs, 8.0);
+    EXPECT_DOUBLE_EQ(all.max_rel, 200.0);  // Percent
+    EXPECT_NEAR(all.mean_abs, (0.5 + 8.0 + 0.001) / 5, 1e-12);
+    EXPECT_NEAR(all.rms_rel(),
+                100.0 * std::sqrt((0.2 * 0.2 + 4.0 + std::pow(0.001 / 10.001, 2)) / 5), 1e-10);
+    EXPECT_NEAR(all.rms_abs(), std::sqrt((0.25 + 64.0 + 1e-6) / 5), 1e-9);
+    EXPECT_EQ(all.histogram[0], 2u);   // Equal pairs
+    EXPECT_EQ(all.histogram[12], 1u);  // Just below 1e-2 %
+    EXPECT_EQ(all.histogram[16], 1u);  // 20 %
+    EXPECT_EQ(all.histogram[17], 1u);  // Opposite signs
+
+    first.merge(second);
+    EXPECT_EQ(first.pairs, all.pairs);
+    EXPECT_DOUBLE_EQ(first.mean_abs, all.mean_abs);
+    EXPECT_DOUBLE_EQ(first.mean_square_rel, all.mean_square_rel);
+    EXPECT_DOUBLE_EQ(first.rms_abs(), all.rms_abs());
+    EXPECT_EQ(first.histogram, all.histogram);
+
+    ColumnErrorStats huge;  // Squares of these errors overflow
+    huge.add(1e200, -1e200, true);
+    huge.add(1.0, 1.0, false);
+    EXPECT_DOUBLE_EQ(huge.rms_abs(), 2e200 / std::sqrt(2.0));
+}
+
+// Test: Every line counts, identical ones included, and threads give the same statistics
+TEST(DiffNumerics, ColumnStatsParallelMatchesSequential) {
+    std::string file1 = write_large_file("dn_colstats_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_colstats_2.dat", 60000, 997, 5003);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.quiet = true;
+    opts.column_stats = StatsFormat::json;
+    std::ostringstream out;
+    NumericDiffResult sequential = NumericDiff(opts, out).run();
+    opts.threads = 4;
+    NumericDiffResult parallel = NumericDiff(opts, out).run();
+
+    ASSERT_EQ(sequential.columns.size(), 3u);
+    EXPECT_EQ(sequential.columns[1].pairs, 60000u);
+    EXPECT_EQ(sequential.columns[1].different, sequential.n_different_lines);
+    EXPECT_EQ(sequential.columns[0].max_abs, 0.0);
+    EXPECT_NEAR(sequential.columns[1].max_rel, 100.0 / 3.0, 1e-10);
+    ASSERT_EQ(parallel.columns.size(), 3u);
+    for (size_t c = 0; c < 3; ++c) {
+        const ColumnErrorStats& s = sequential.columns[c];
+        const ColumnErrorStats& p = parallel.columns[c];
+        EXPECT_EQ(p.pairs, s.pairs);
+        EXPECT_EQ(p.different, s.different);
+        EXPECT_EQ(p.max_abs, s.max_abs);
+        EXPECT_NEAR(p.mean_rel, s.mean_rel, 1e-12);
+        EXPECT_NEAR(p.rms_abs(), s.rms_abs(), 1e-12);
+        EXPECT_EQ(p.histogram, s.histogram);
+    }
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for --records ---
+
+// Test: JSONL and binary records hold every differing value, in file order, whatever the threads
+TEST(DiffNumerics, RecordsListEveryDifference) {
+    std::string file1 = write_large_file("dn_records_1.dat", 60000, 0, 7001);
+    std::string file2 = write_large_file("dn_records_2.dat", 60000, 997, 5003);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.top_k = 1 << 20;
+    std::ostringstream text;
+    NumericDiffResult all = NumericDiff(opts, text).run();
+    std::sort(all.top.begin(), all.top.end(), [](const auto& a, const auto& b) {
+        return a.line1 < b.line1;
+    });
+    opts.top_k = 0;
+
+    for (size_t threads : {1, 4}) {
+        opts.threads = threads;
+        opts.records = RecordFormat::jsonl;
+        std::ostringstream jsonl, binary;
+        NumericDiffResult result = NumericDiff(opts, jsonl).run();
+        EXPECT_EQ(result.n_different_lines, all.n_different_lines);
+        std::istringstream lines(jsonl.str());
+        std::string line;
+        size_t n = 0;
+        while (std::getline(lines, line)) {
+            ASSERT_LT(n, all.top.size());
+            const ValueDifference& d = all.top[n++];
+            EXPECT_EQ(line.rfind("{\"line1\":" + std::to_string(d.line1) + ",\"line2\":" +
+                                     std::to_string(d.line2) + ",\"column\":2,\"v1\":", 0),
+                      0u);
+            EXPECT_DOUBLE_EQ(std::stod(line.substr(line.find("\"v2\":") + 5)), d.value2);
+        }
+        EXPECT_EQ(n, all.top.size());
+
+        opts.records = RecordFormat::binary;
+        NumericDiff(opts, binary).run();
+        std::string bytes = binary.str();
+        ASSERT_EQ(bytes.size(), all.top.size() * Printer::record_size);
+        std::uint64_t line1;
+        std::uint32_t column;
+        double error;
+        std::memcpy(&line1, bytes.data(), 8);
+        std::memcpy(&column, bytes.data() + 16, 4);
+        std::memcpy(&error, bytes.data() + 36, 8);
+        EXPECT_EQ(line1, all.top[0].line1);
+        EXPECT_EQ(column, 2u);
+        EXPECT_DOUBLE_EQ(error, all.top[0].error);
+    }
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// --- Tests for standard input and named pipes ---
+
+// Test: A FIFO fed by another thread while comparing gives the output of the regular file
+TEST(DiffNumerics, NamedPipeMatchesFile) {
+    std::string plain1 = test_data_path("delta_3P2-3F2.dat");
+    std::string plain2 = test_data_path("delta_3P2-3F2_2.dat");
+    std::string fifo = (fs::temp_directory_path() / "dn_input.fifo").string();
+    fs::remove(fifo);
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    std::thread writer([&] {
+        std::ifstream in(plain2, std::ios::binary);
+        std::ofstream out(fifo, std::ios::binary);  // Waits for the reader to open the FIFO
+        out << in.rdbuf();
+    });
+    FullOutput piped = run_diff(plain1, fifo, 1e-2, 1e-6, true, false, false, false);
+    writer.join();
+    FullOutput plain = run_diff(plain1, plain2, 1e-2, 1e-6, true, false, false, false);
+    EXPECT_EQ(piped.output, plain.output);
+    EXPECT_EQ(piped.result.n_different_lines, plain.result.n_different_lines);
+    fs::remove(fifo);
+}
+
+// Test: "-" reads standard input, as either file but not both
+TEST(DiffNumericsCLI, StandardInput) {
+    std::string file1 = test_data_path("delta_3P2-3F2.dat");
+    std::string file2 = test_data_path("delta_3P2-3F2_2.dat");
+    std::string expected = run_diff_numerics_cli(file1 + " " + file2);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(run_diff_numerics_cli(file1 + " - < " + file2), expected);
+    EXPECT_EQ(run_diff_numerics_cli("- " + file2 + " < " + file1), expected);
+
+    // Through a pipe: the stream backend instead of a mapping of the redirected file
+    std::string cmd = "cat " + file2 + " | " + project_root() + "/build/diff-numerics " + file1 +
+                      " - 2>&1";
+    std::unique_ptr<FILE, int (*)(FILE*)> pipe(popen(cmd.c_str(), "r"), pclose);
+    ASSERT_TRUE(pipe);
+    std::string piped;
+    std::array<char, 256> buffer;
+    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) piped += buffer.data();
+    EXPECT_EQ(piped, expected);
+
+    std::string out = run_diff_numerics_cli("- - < " + file1);
+    EXPECT_NE(out.find("Error: Only one input can be read from standard input (-)."),
+              std::string::npos);
+}
+
+// Test: A line in one file only (--resync) has no line number in the other file's field
+TEST(DiffNumerics, RecordsOfUnmatchedLinesNameOneFile) {
+    std::string path1 = (fs::temp_directory_path() / "dn_records_resync_1.dat").string();
+    std::string path2 = (fs::temp_directory_path() / "dn_records_resync_2.dat").string();
+    {
+        std::ofstream out1(path1), out2(path2);
+        for (int i = 1; i <= 10; ++i) {
+            if (i != 4) out1 << i << " " << 10 * i << "\n";  // Deleted from file1
+            out2 << i << " " << 10 * i << "\n";
+            if (i == 7) out1 << "99 990\n";  // Inserted into file1
+        }
+    }
+    NumericDiffOptions opts;
+    opts.file1 = path1;
+    opts.file2 = path2;
+    opts.resync_window = 4;
+    opts.key_column = 1;
+    opts.records = RecordFormat::jsonl;
+    std::ostringstream out;
+    NumericDiffResult result = NumericDiff(opts, out).run();
+    EXPECT_EQ(result.n_only_in1, 1u);
+    EXPECT_EQ(result.n_only_in2, 1u);
+    EXPECT_NE(out.str().find("{\"line1\":null,\"line2\":4,\"column\":0,"), std::string::npos)
+        << out.str();
+    EXPECT_NE(out.str().find("{\"line1\":7,\"line2\":null,\"column\":0,"), std::string::npos)
+        << out.str();
+    fs::remove(path1);
+    fs::remove(path2);
+}
+
+// --- Tests for --sample ---
+
+// Test: A sample bounds the true difference rate, located alike by counting and by record length
+TEST(DiffNumerics, SampleEstimatesDifferenceRate) {
+    std::string file1 = write_large_file("dn_sample_1.dat", 60000, 0, 0);
+    std::string file2 = write_large_file("dn_sample_2.dat", 60000, 10, 0);
+    NumericDiffOptions opts;
+    opts.file1 = file1;
+    opts.file2 = file2;
+    opts.quiet = true;
+    opts.sample_lines = 2000;
+    std::ostringstream out;
+    NumericDiffResult counted = NumericDiff(opts, out).run();
+    EXPECT_EQ(counted.sample.population, 60000u);
+    EXPECT_EQ(counted.sample.n_sampled, 2000u);
+    EXPECT_EQ(counted.sample.n_different, counted.n_different_lines);
+    EXPECT_LT(counted.sample.lower, 0.1);
+    EXPECT_GT(counted.sample.upper, 0.1);
+
+    opts.fixed_width_lines = FixedWidthLayout::default_learn_lines;  // Lines found by offset
+    NumericDiffResult records = NumericDiff(opts, out).run();
+    EXPECT_EQ(records.sample.n_different, counted.sample.n_different);
+    EXPECT_EQ(records.first_diff.line1, counted.first_diff.line1);
+    EXPECT_EQ(records.max_percentage_err, counted.max_percentage_err);
+
+    opts.sample_lines = 100000;  // More than the population: every line, an exact rate
+    NumericDiffResult all = NumericDiff(opts, out).run();
+    EXPECT_EQ(all.sample.n_sampled, 60000u);
+    EXPECT_EQ(all.sample.n_different, 6000u);
+    EXPECT_EQ(all.sample.lower, all.sample.upper);
+    fs::remove(file1);
+    fs::remove(file2);
+}
+
+// Test: A sampled run reports its estimate, never the EQUAL/DIFFER verdict of a full run
+TEST(DiffNumericsCLI, SampleHasNoVerdict) {
+    std::string out = run_diff_numerics_cli("-s --sample 5 " + test_data_path("delta_3P2-3F2.dat") +
+                                            " " + test_data_path("delta_3P2-3F2_2.dat"));
+    EXPECT_NE(out.find("Sampled 5 of "), std::string::npos);
+    EXPECT_EQ(out.find("Files are EQUAL"), std::string::npos);
+    EXPECT_EQ(out.find("Files DIFFER"), std::string::npos);
+}